@@ -55,6 +55,10 @@ static uint graphics_buffer_height = 0;
 static int graphics_buffer_shift_x = 0;
 static int graphics_buffer_shift_y = 0;
 
+// set by core 0 once a row is in the frame buffer, cleared by refresh_lcd()
+// on core 1 before the row is sent, so a row changed mid-send goes out again
+static volatile uint8_t dirty_rows[SCREEN_HEIGHT];
+
 enum graphics_mode_t graphics_mode = GRAPHICSMODE_DEFAULT;
 
 static inline void lcd_set_dc_cs(const bool dc, const bool cs) {
@@ -252,10 +256,19 @@ void graphics_init() {
     gpio_put(TFT_LED_PIN, 1);
     for (int i = 0; i < 256; ++i) palette[i] = (uint16_t)i << 8;
     clrScr(0);
+    memset((void*)dirty_rows, 1, sizeof(dirty_rows));
 
     create_dma_channel();
 }
 
+void graphics_set_dirty_rows(int top, int bottom) {
+    if (top < 0) top = 0;
+    if (bottom > SCREEN_HEIGHT) bottom = SCREEN_HEIGHT;
+    __dmb();
+    for (int y = top; y < bottom; ++y)
+        dirty_rows[y] = 1;
+}
+
 void graphics_set_palette(uint8_t i, uint32_t color) {
     palette[i] = RGB888(
         (color & 0xFF),
@@ -305,18 +318,35 @@ void st7789_dma_pixels(const uint16_t* pixels, const uint num_pixels) {
 
 uint8_t* get_line_buffer(int line);
 void vsync_handler();
+// called between rows, core 1 has other work waiting on it while it sends
+void refresh_poll_handler();
 
+// sends only the runs of rows marked by graphics_set_dirty_rows()
 void __inline __scratch_x("refresh_lcd") refresh_lcd() {
-    lcd_set_window(graphics_buffer_shift_x, graphics_buffer_shift_y, graphics_buffer_width,
-                    graphics_buffer_height);
-    start_pixels();
-    for (register size_t y = 0; y < graphics_buffer_height; ++y) {
-        register uint8_t* bitmap = get_line_buffer(y);
-        if (!bitmap) continue;
-        for (register size_t x = 0; x < graphics_buffer_width; ++x) {
-            st7789_lcd_put_pixel(pio, sm, palette[ bitmap[x] ]);
+    size_t height = graphics_buffer_height;
+    if (height > SCREEN_HEIGHT) height = SCREEN_HEIGHT;
+    size_t y = 0;
+    while (y < height) {
+        if (!dirty_rows[y]) {
+            ++y;
+            continue;
+        }
+        size_t top = y;
+        while (y < height && dirty_rows[y])
+            dirty_rows[y++] = 0;
+        __dmb();
+        lcd_set_window(graphics_buffer_shift_x, graphics_buffer_shift_y + top, graphics_buffer_width,
+                        y - top);
+        start_pixels();
+        for (register size_t row = top; row < y; ++row) {
+            register uint8_t* bitmap = get_line_buffer(row);
+            if (!bitmap) continue;
+            for (register size_t x = 0; x < graphics_buffer_width; ++x) {
+                st7789_lcd_put_pixel(pio, sm, palette[ bitmap[x] ]);
+            }
+            refresh_poll_handler();
         }
+        stop_pixels();
     }
-    stop_pixels();
     vsync_handler();
 }
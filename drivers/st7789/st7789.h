@@ -40,3 +40,5 @@ inline static void graphics_set_flashmode(bool flash_line, bool flash_frame) {
 extern uint8_t TFT_FLAGS;
 extern uint8_t TFT_INVERSION;
 void refresh_lcd();
+// rows [top, bottom) changed and go out on the next refresh_lcd()
+void graphics_set_dirty_rows(int top, int bottom);
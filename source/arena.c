@@ -0,0 +1,310 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// arena.c -- scoped arenas for frame temporary memory
+
+#include "quakedef.h"
+
+static arena_t	*arena_list;
+
+/*
+===============
+Arena_Create
+===============
+*/
+void Arena_Create (arena_t *a, const char *name, void *base, int size, int flags)
+{
+	arena_t	*l;
+
+	for (l = arena_list ; l && l != a ; l = l->next)
+		;
+	if (!l)
+	{	// first time, a restarted video driver gives the same ones again
+		a->next = arena_list;
+		arena_list = a;
+	}
+
+	l = a->next;
+	memset (a, 0, sizeof(*a));
+	a->next = l;
+	a->name = name;
+	a->base = (byte *)base;
+	a->end = a->base + size;
+	a->flags = flags;
+	Arena_Reset (a);
+}
+
+/*
+===============
+Arena_SetShared
+
+The memory of the arena is also written by its owner, rowbytes at a time
+from the bottom up
+===============
+*/
+void Arena_SetShared (arena_t *a, int rowbytes)
+{
+	if (!(a->flags & ARENA_TOPDOWN) || rowbytes <= 0)
+		Sys_Error ("Arena_SetShared: %s must be top down", a->name);
+	a->flags |= ARENA_SHARED;
+	a->rowbytes = rowbytes;
+}
+
+/*
+===============
+Arena_Reset
+
+Drops every allocation and open scope, for the start of a frame or after
+an error longjmp'd past the scopes
+===============
+*/
+void Arena_Reset (arena_t *a)
+{
+	a->rover = (a->flags & ARENA_TOPDOWN) ? a->end : a->base;
+	a->scope = NULL;
+	a->depth = 0;
+	a->reclaimed = false;
+}
+
+void Arena_ResetAll (void)
+{
+	arena_t	*a;
+
+	for (a = arena_list ; a ; a = a->next)
+		Arena_Reset (a);
+}
+
+/*
+===============
+Arena_FreeBytes
+===============
+*/
+int Arena_FreeBytes (arena_t *a)
+{
+	if (a->flags & ARENA_TOPDOWN)
+		return a->rover - a->base;
+	return a->end - a->rover;
+}
+
+/*
+===============
+Arena_FramePeak
+
+High water mark since the last call
+===============
+*/
+int Arena_FramePeak (arena_t *a)
+{
+	int		peak;
+
+	peak = a->framepeak;
+	a->framepeak = a->end - a->base - Arena_FreeBytes (a);
+	return peak;
+}
+
+/*
+===============
+Arena_Take
+
+NULL if it doesn't fit
+===============
+*/
+static void *Arena_Take (arena_t *a, int size, int align)
+{
+	uintptr_t	p;
+	int			used;
+
+	if (a->reclaimed)
+		Sys_Error ("Arena_Alloc: %s allocated from after its owner reclaimed it", a->name);
+	if (size < 0 || align <= 0 || (align & (align - 1)))
+		Sys_Error ("Arena_Alloc: %s: bad size %i or alignment %i", a->name, size, align);
+
+	if (a->flags & ARENA_TOPDOWN)
+	{
+		if (size > a->rover - a->base)
+			return NULL;
+		p = ((uintptr_t)a->rover - size) & ~(uintptr_t)(align - 1);
+		if (p < (uintptr_t)a->base)
+			return NULL;
+		a->rover = (byte *)p;
+		used = a->end - a->rover;
+	}
+	else
+	{
+		p = ((uintptr_t)a->rover + align - 1) & ~(uintptr_t)(align - 1);
+		if (p > (uintptr_t)a->end || size > (uintptr_t)a->end - p)
+			return NULL;
+		a->rover = (byte *)p + size;
+		used = a->rover - a->base;
+	}
+
+	a->allocs++;
+	if (used > a->peak)
+		a->peak = used;
+	if (used > a->framepeak)
+		a->framepeak = used;
+	return (void *)p;
+}
+
+/*
+===============
+Arena_AllocAligned
+===============
+*/
+void *Arena_AllocAligned (arena_t *a, int size, int align)
+{
+	arenascope_t	*s;
+	char			scopes[128];
+	int				len;
+	void			*p;
+
+	p = Arena_Take (a, size, align);
+	if (p)
+		return p;
+
+	scopes[0] = 0;
+	len = 0;
+	for (s = a->scope ; s && len < sizeof(scopes) - 32 ; s = s->outer)
+		len += snprintf (scopes + len, sizeof(scopes) - len, " %s", s->name);
+	Sys_Error ("Arena_Alloc: %s: %i bytes asked, %i free of %i, peak %i, scopes:%s",
+		a->name, size, Arena_FreeBytes (a), (int)(a->end - a->base), a->peak,
+		scopes[0] ? scopes : " none");
+	return NULL;
+}
+
+/*
+===============
+Arena_TryAlloc
+===============
+*/
+void *Arena_TryAlloc (arena_t *a, int size)
+{
+	void	*p;
+
+	p = Arena_Take (a, size, 8);
+	if (!p)
+		a->failures++;
+	return p;
+}
+
+/*
+===============
+Arena_Enter
+===============
+*/
+void Arena_Enter (arena_t *a, arenascope_t *scope, const char *name)
+{
+	scope->arena = a;
+	scope->rover = a->rover;
+	scope->name = name;
+	scope->outer = a->scope;
+	a->scope = scope;
+	if (++a->depth > a->peakdepth)
+		a->peakdepth = a->depth;
+}
+
+/*
+===============
+Arena_Leave
+
+Releases everything allocated since the scope was entered
+===============
+*/
+void Arena_Leave (arenascope_t *scope)
+{
+	arena_t	*a;
+
+	a = scope->arena;
+	if (a->scope != scope)
+		Sys_Error ("Arena_Leave: %s: scope %s left while %s is open", a->name,
+			scope->name, a->scope ? a->scope->name : "none");
+
+	a->rover = scope->rover;
+	a->scope = scope->outer;
+	a->depth--;
+	if (!a->scope)
+		a->reclaimed = false;
+}
+
+/*
+===============
+Arena_SharedRows
+
+How many whole rows the owner of a shared arena can write from the bottom
+before it reaches the allocations
+===============
+*/
+int Arena_SharedRows (arena_t *a)
+{
+	if (!(a->flags & ARENA_SHARED))
+		return 0;
+	return (a->rover - a->base) / a->rowbytes;
+}
+
+/*
+===============
+Arena_Reclaim
+
+The owner has written past the allocations, whatever was there is gone
+===============
+*/
+void Arena_Reclaim (arena_t *a)
+{
+	a->reclaimed = true;
+}
+
+/*
+===============
+Arena_Stats_f
+===============
+*/
+static void Arena_Stats_f (void)
+{
+	arena_t	*a;
+
+	if (Cmd_Argc () == 2 && !strcmp (Cmd_Argv (1), "clear"))
+	{
+		for (a = arena_list ; a ; a = a->next)
+		{
+			a->peak = a->end - a->base - Arena_FreeBytes (a);
+			a->peakdepth = a->depth;
+			a->allocs = a->failures = 0;
+		}
+		return;
+	}
+
+	Con_Printf ("%-8s %6s %6s %6s %6s %5s %7s %s\n", "arena", "size", "used", "peak",
+		"spare", "depth", "allocs", "failed");
+	for (a = arena_list ; a ; a = a->next)
+	{
+		Con_Printf ("%-8s %6i %6i %6i %6i %2i/%-2i %7i %i\n", a->name, (int)(a->end - a->base),
+			(int)(a->end - a->base) - Arena_FreeBytes (a), a->peak,
+			(int)(a->end - a->base) - a->peak, a->depth, a->peakdepth, a->allocs, a->failures);
+	}
+}
+
+/*
+===============
+Arena_Init
+===============
+*/
+void Arena_Init (void)
+{
+	Cmd_AddCommand ("arenas", Arena_Stats_f);
+}
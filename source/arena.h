@@ -0,0 +1,104 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+/*
+ scoped arenas for frame temporary memory
+
+
+An arena is a named block handed out in a stack fashion, from the bottom
+up, or from the top down with ARENA_TOPDOWN. Nothing is freed on its own:
+memory goes back when the scope it was allocated in is left.
+
+	ARENA_SCOPE (aux_arena);
+	spans = Arena_Alloc (&aux_arena, size);
+	...
+	// released on return, whichever way the function returns
+
+Scopes nest and must be left in the order they were entered; a scope left
+out of order is an error naming both. Allocations are 8 byte aligned unless
+Arena_AllocAligned asks for more. Running out is an error naming the arena,
+the size asked for and the open scopes, Arena_TryAlloc returns NULL instead.
+
+An arena can be ARENA_SHARED with an owner that writes its memory in rows
+of rowbytes from the bottom up while allocations are live at the top, the
+way the z-buffer is drawn under the z-buffer arena. Arena_SharedRows is how
+many rows the owner may write before it reaches the allocations, and once
+it has gone past them Arena_Reclaim marks the arena so any further
+allocation is an error until its outermost scope is left.
+
+"arenas" prints the size, use and high water mark of every arena,
+"arenas clear" resets the high water marks.
+*/
+
+#define	ARENA_TOPDOWN	1
+#define	ARENA_SHARED	2
+
+typedef struct arenascope_s
+{
+	struct arena_s			*arena;
+	byte					*rover;
+	const char				*name;
+	struct arenascope_s		*outer;
+} arenascope_t;
+
+typedef struct arena_s
+{
+	const char		*name;
+	byte			*base, *end;
+	byte			*rover;
+	int				flags;
+	int				rowbytes;		// ARENA_SHARED
+	qboolean		reclaimed;
+	arenascope_t	*scope;			// innermost open scope
+	int				depth;
+	int				peak;			// bytes
+	int				framepeak;		// since the last Arena_FramePeak
+	int				peakdepth;
+	int				allocs;
+	int				failures;		// Arena_TryAlloc returned NULL
+	struct arena_s	*next;
+} arena_t;
+
+void Arena_Init (void);
+void Arena_Create (arena_t *a, const char *name, void *base, int size, int flags);
+void Arena_SetShared (arena_t *a, int rowbytes);
+void Arena_Reset (arena_t *a);
+void Arena_ResetAll (void);
+
+void *Arena_AllocAligned (arena_t *a, int size, int align);
+void *Arena_TryAlloc (arena_t *a, int size);
+int Arena_FreeBytes (arena_t *a);
+int Arena_FramePeak (arena_t *a);
+
+void Arena_Enter (arena_t *a, arenascope_t *scope, const char *name);
+void Arena_Leave (arenascope_t *scope);
+
+int Arena_SharedRows (arena_t *a);
+void Arena_Reclaim (arena_t *a);
+
+#define	Arena_Alloc(a,size)	Arena_AllocAligned (a, size, 8)
+
+#define	ARENA_CAT_(a,b)		a##b
+#define	ARENA_CAT(a,b)		ARENA_CAT_(a,b)
+
+// opens a scope on the arena that is left when the enclosing block is
+#define	ARENA_SCOPE(a)		ARENA_SCOPE_(a, ARENA_CAT(arenascope_,__COUNTER__))
+#define	ARENA_SCOPE_(a,s)												\
+	arenascope_t s __attribute__((cleanup(Arena_Leave)));				\
+	Arena_Enter (&(a), &s, __func__)
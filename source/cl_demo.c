@@ -19,9 +19,12 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "quakedef.h"
+#include "pcprof.h"
+#include "sctrace.h"
 
 void CL_FinishFrameTimeDemo(void);
 void CL_FinishTimeDemo (void);
+void CL_FinishHashDemo (void);
 
 /*
 ==============================================================================
@@ -54,10 +57,13 @@ void CL_StopPlayback (void)
 		cls.demofile = NULL;
 	}
 	cls.demoplayback = false;
+	cls.demoseeking = false;
 	cls.state = ca_disconnected;
 
 	if (cls.frametimedemo)
 		CL_FinishFrameTimeDemo();
+	if (cls.hashdemo)
+		CL_FinishHashDemo ();
 	if (cls.timedemo)
 		CL_FinishTimeDemo ();
 }
@@ -87,6 +93,47 @@ void CL_WriteDemoMessage (void)
 	f_sync (cls.demofile);
 }
 
+static void CL_IndexDemo (void);
+
+/*
+====================
+CL_ReadDemoMessage
+
+reads the next message and its view angles, returns 0 at the end of the demo
+====================
+*/
+static int CL_ReadDemoMessage (void)
+{
+	int		r, i;
+	float	f;
+	UINT	rb;
+
+	if (cls.signon == SIGNONS)
+		CL_IndexDemo ();
+
+	f_read (cls.demofile, &net_message.cursize, 4, &rb);
+	VectorCopy (cl.mviewangles[0], cl.mviewangles[1]);
+	for (i=0 ; i<3 ; i++)
+	{
+		f_read (cls.demofile, &f, 4, &rb);
+		r = rb >> 2;
+		cl.mviewangles[0][i] = LittleFloat (f);
+	}
+	
+	net_message.cursize = LittleLong (net_message.cursize);
+	if (net_message.cursize > MAX_MSGLEN)
+		Sys_Error ("Demo message > MAX_MSGLEN");
+	f_read (cls.demofile, net_message.data, net_message.cursize, &rb);
+	r = rb / net_message.cursize;
+	if (r != 1)
+	{
+		CL_StopPlayback ();
+		return 0;
+	}
+
+	return 1;
+}
+
 /*
 ====================
 CL_GetMessage
@@ -96,8 +143,7 @@ Handles recording and playback of demos, on top of NET_ code
 */
 int CL_GetMessage (void)
 {
-	int		r, i;
-	float	f;
+	int		r;
 	
 	//Con_Printf ("CL_GetMessage: %d\n", cls.demoplayback);
 	if	(cls.demoplayback)
@@ -113,7 +159,10 @@ int CL_GetMessage (void)
 			// if this is the second frame, grab the real td_starttime
 			// so the bogus time on the first frame doesn't count
 				if (host_framecount == cls.td_startframe + 1)
+				{
 					cls.td_starttime = realtime;
+					PCProf_Begin ();
+				}
 			}
 			else if ( /* cl.time > 0 && */ cl.time <= cl.mtime[0])
 			{
@@ -122,28 +171,7 @@ int CL_GetMessage (void)
 		}
 		
 	// get the next message
-		UINT rb;
-		f_read (cls.demofile, &net_message.cursize, 4, &rb);
-		VectorCopy (cl.mviewangles[0], cl.mviewangles[1]);
-		for (i=0 ; i<3 ; i++)
-		{
-			f_read (cls.demofile, &f, 4, &rb);
-			r = rb >> 2;
-			cl.mviewangles[0][i] = LittleFloat (f);
-		}
-		
-		net_message.cursize = LittleLong (net_message.cursize);
-		if (net_message.cursize > MAX_MSGLEN)
-			Sys_Error ("Demo message > MAX_MSGLEN");
-		f_read (cls.demofile, net_message.data, net_message.cursize, &rb);
-		r = rb / net_message.cursize;
-		if (r != 1)
-		{
-			CL_StopPlayback ();
-			return 0;
-		}
-	
-		return 1;
+		return CL_ReadDemoMessage ();
 	}
 
 	while (1)
@@ -327,6 +355,7 @@ void CL_PlayDemo_f (void)
 	cls.demoplayback = true;
 	cls.state = ca_connected;
 	cls.forcetrack = 0;
+	CL_ClearDemoIndex ();
 
 	while ((c = f_getc(cls.demofile)) != '\n')
 		if (c == '-')
@@ -361,8 +390,15 @@ void CL_FinishTimeDemo (void)
 	if (!time)
 		time = 1;
 	Con_Printf ("%i frames %5.1f seconds %5.1f fps\n", frames, time, frames/time);
+
+	PCProf_End ();
+	SCTrace_End ();
 }
 
+#define	FTDEMO_FRAMES	1024
+
+static int	ftd_mark, ftd_top;		// high marks below and above cls.ftd_buf
+
 /*
 ====================
 CL_FrameTimeDemoAdvance
@@ -390,18 +426,37 @@ void CL_FinishFrameTimeDemo (void)
 
 	cls.frametimedemo = false;
 
+	if (!cls.ftd_buf)
+		return;
+	if (Hunk_HighMark () < ftd_top)
+	{	// an aborted frame freed the high hunk back past it
+		cls.ftd_buf = NULL;
+		Con_Printf ("frametimedemo: the frame stats were freed by an error\n");
+		return;
+	}
+
 	Con_Printf("--------------------------\n");
-	Con_Printf("Total\tSerever\tRender\tParticles\tRenderWorld\tBEntities\tScanEdges\tEntities\tViewModel\tfaceclip\tpolycount\tdrawnpolycount\tsurfaces\n");
+	Con_Printf("Total\tSerever\tRender\tParticles\tRenderWorld\tBEntities\tScanEdges\tEntities\tViewModel\tfaceclip\tpolycount\tdrawnpolycount\tsurfaces\tscale\tmipbias"
+		"\thunklow\thunkhigh\tzonefree\tzonelargest\tcache\tcacheblocks\tevicted\tsurfcache\twrapped\tthrash\tauxpeak\tzbufferpeak\n");
 	p = cls.ftd_buf;
 	for (i = 0; i < cls.ftd_frames_recorded; i++) {
-		Con_Printf("%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%d\t%d\t%d\t%d\t\n", 
+		Con_Printf("%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%.2f\t%d\t%d\t%d\t%d\t%.4f\t%.2f\t", 
 			p->total, p->server, p->r, p->dp, p->rw, p->db, p->se, p->de, p->dv, 
-			p->faceclip, p->polycount, p->drawnpolycount, p->surf
+			p->faceclip, p->polycount, p->drawnpolycount, p->surf, p->scale, p->mipbias
+		);
+		Con_Printf("%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t%d\t\n",
+			p->mem.hunklow, p->mem.hunkhigh, p->mem.zonefree, p->mem.zonelargest,
+			p->mem.cachebytes, p->mem.cacheblocks, p->mem.cacheevicted, p->mem.scbytes,
+			!!(p->mem.scflags & MS_SCWRAPPED), !!(p->mem.scflags & MS_SCTHRASH),
+			p->mem.auxpeak, p->mem.zbufferpeak
 		);
 		p++;
 	} 
 	Con_Printf("--------------------------\n");
 
+	if (Hunk_HighMark () == ftd_top)
+		Hunk_FreeToHighMark (ftd_mark);
+	cls.ftd_buf = NULL;
 	cls.ftd_frames_recorded = 0;
 	cls.ftd_frames_total = 0;
 }
@@ -432,10 +487,11 @@ void CL_TimeDemo_f (void)
 	cls.timedemo = true;
 	cls.td_startframe = host_framecount;
 	cls.td_lastframe = -1;		// get a new message this frame
-}
 
-// KLUDGE KLUDGE KLUDGE
-__psram_bss("cl_demo") ftdemo_point_t ftdbuf[1024];
+// the surface cache is traced from the start, the map load flushes it
+	if (cls.demoplayback)
+		SCTrace_Begin ();
+}
 
 /*
 ====================
@@ -455,13 +511,24 @@ void CL_FrameTimeDemo_f (void)
 		return;
 	}
 
-	// allocate buffer for frametime statistics
-	cls.ftd_buf = ftdbuf;
+	CL_PlayDemo_f ();
+	if (!cls.demoplayback)
+		return;
+
+// the frametime statistics come from the high hunk for the run, once the
+// demo is open so a run still playing has given its buffer back
+	ftd_mark = Hunk_HighMark ();
+	cls.ftd_buf = Hunk_HighAllocName (FTDEMO_FRAMES * sizeof(ftdemo_point_t), "ftdemo");
+	if (!cls.ftd_buf)
+	{
+		Con_Printf ("ERROR: not enough memory for the frame stats.\n");
+		CL_StopPlayback ();
+		return;
+	}
+	ftd_top = Hunk_HighMark ();
 	cls.ftd_framepos = 0;
 	cls.ftd_frames_recorded = 0;
-	cls.ftd_frames_total = 1024;
-
-	CL_PlayDemo_f ();
+	cls.ftd_frames_total = FTDEMO_FRAMES;
 	
 // cls.td_starttime will be grabbed at the second frame of the demo, so
 // all the loading time doesn't get counted
@@ -486,3 +553,638 @@ void CL_FrameTimeDemoCloseFrame (void)
 		cls.ftd_frames_recorded++;
 	}
 }
+
+/*
+==============================================================================
+
+FRAME HASHING
+
+hashdemo plays a demo like timedemo, but with a fixed timestep, and hashes
+every frame handed to VID_Update. The hashes are written to <demo>.fhash,
+hashcheck compares a new run against that list instead, so a renderer change
+can be proven to draw exactly the same frames. The hash lists are taken from
+the high hunk for the run and given back when it finishes.
+
+==============================================================================
+*/
+
+#define	MAX_HASHFRAMES	16384
+
+cvar_t	hashdemo_palette = {"hashdemo_palette", "1"};	// include the palette in the hash
+cvar_t	hashdemo_frametime = {"hashdemo_frametime", "0.0138889"};	// 1/72
+
+static unsigned	*hd_hashes;		// high hunk, hd_golden follows for hashcheck
+static unsigned	*hd_golden;
+static int		hd_mark, hd_top;	// high marks below and above them
+static int		hd_frames;
+static int		hd_goldenframes;
+static qboolean	hd_check;
+static char		hd_name[MAX_OSPATH];
+
+static unsigned CL_HashBytes (unsigned hash, byte *data, int count)
+{
+	while (count--)
+	{
+		hash ^= *data++;
+		hash *= 16777619;	// FNV-1a
+	}
+	return hash;
+}
+
+/*
+====================
+CL_HashListsValid
+
+an aborted frame frees the high hunk back to the mark it started with,
+which can take the lists with it
+====================
+*/
+static qboolean CL_HashListsValid (void)
+{
+	if (hd_hashes && Hunk_HighMark () < hd_top)
+		hd_hashes = hd_golden = NULL;
+	return hd_hashes != NULL;
+}
+
+/*
+====================
+CL_FreeHashLists
+====================
+*/
+static void CL_FreeHashLists (void)
+{
+	if (CL_HashListsValid () && Hunk_HighMark () == hd_top)
+		Hunk_FreeToHighMark (hd_mark);
+	hd_hashes = hd_golden = NULL;
+}
+
+/*
+====================
+CL_AllocHashLists
+====================
+*/
+static qboolean CL_AllocHashLists (qboolean check)
+{
+	CL_FreeHashLists ();
+
+	hd_mark = Hunk_HighMark ();
+	hd_hashes = Hunk_HighAllocName ((check ? 2 : 1) * MAX_HASHFRAMES * sizeof(unsigned), "hashdemo");
+	if (!hd_hashes)
+		return false;
+	hd_golden = check ? hd_hashes + MAX_HASHFRAMES : NULL;
+	hd_top = Hunk_HighMark ();
+	return true;
+}
+
+/*
+====================
+CL_HashDemoFrame
+
+Called by VID_Update with the frame being presented
+====================
+*/
+void CL_HashDemoFrame (byte *buffer, int rowbytes, byte *palette)
+{
+	unsigned	hash;
+	int			y;
+
+	hash = 2166136261u;
+	for (y=0 ; y<vid.height ; y++)
+		hash = CL_HashBytes (hash, buffer + y*rowbytes, vid.width);
+	if (hashdemo_palette.value && palette)
+		hash = CL_HashBytes (hash, palette, 768);
+
+	if (hd_frames < MAX_HASHFRAMES && hd_hashes)
+		hd_hashes[hd_frames] = hash;
+	hd_frames++;
+}
+
+/*
+====================
+CL_LoadHashList
+
+reads the "frame hash" lines of a previous run into hd_golden
+====================
+*/
+static qboolean CL_LoadHashList (char *path)
+{
+	int		h, len, i, n;
+	char	buf[512], line[64];
+	int		linelen;
+	int		frame;
+	unsigned	hash;
+
+	len = Sys_FileOpenRead (path, &h);
+	if (len == -1)
+		return false;
+
+	hd_goldenframes = 0;
+	linelen = 0;
+	while (len > 0)
+	{
+		n = Sys_FileRead (h, buf, len < sizeof(buf) ? len : sizeof(buf));
+		if (n <= 0)
+			break;
+		len -= n;
+
+		for (i=0 ; i<=n ; i++)
+		{
+			if (i < n && buf[i] != '\n')
+			{
+				if (buf[i] != '\r' && linelen < sizeof(line) - 1)
+					line[linelen++] = buf[i];
+				continue;
+			}
+			if (i == n && len > 0)
+				break;		// line continues in the next chunk
+
+			line[linelen] = 0;
+			linelen = 0;
+			if (sscanf (line, "%i %x", &frame, &hash) != 2)
+				continue;
+			if (frame != hd_goldenframes || hd_goldenframes >= MAX_HASHFRAMES)
+				continue;
+			hd_golden[hd_goldenframes++] = hash;
+		}
+	}
+	Sys_FileClose (h);
+
+	return true;
+}
+
+static void CL_WriteHashList (char *path)
+{
+	int		h, i, n, count;
+	char	buf[512];
+
+	h = Sys_FileOpenWrite (path);
+	if (h == -1)
+	{
+		Con_Printf ("ERROR: couldn't open %s.\n", path);
+		return;
+	}
+
+	count = hd_frames < MAX_HASHFRAMES ? hd_frames : MAX_HASHFRAMES;
+	n = 0;
+	for (i=0 ; i<count ; i++)
+	{
+		n += sprintf (buf + n, "%i %08x\n", i, hd_hashes[i]);
+		if (n > sizeof(buf) - 32 || i == count - 1)
+		{
+			Sys_FileWrite (h, buf, n);
+			n = 0;
+		}
+	}
+	Sys_FileClose (h);
+
+	Con_Printf ("wrote %i frame hashes to %s\n", count, path);
+}
+
+/*
+====================
+CL_FinishHashDemo
+
+====================
+*/
+void CL_FinishHashDemo (void)
+{
+	int		i, count, diffs, first;
+
+	cls.hashdemo = false;
+	cls.timedemo = false;
+
+	if (!CL_HashListsValid ())
+	{
+		Con_Printf ("hashdemo: the frame hashes were freed by an error\n");
+		return;
+	}
+
+	if (hd_frames > MAX_HASHFRAMES)
+		Con_Printf ("hashdemo: only the first %i of %i frames were kept\n",
+				MAX_HASHFRAMES, hd_frames);
+
+	if (!hd_check)
+	{
+		CL_WriteHashList (hd_name);
+		CL_FreeHashLists ();
+		if (COM_CheckParm ("-hashexit"))
+			Sys_Quit ();
+		return;
+	}
+
+	count = hd_frames < MAX_HASHFRAMES ? hd_frames : MAX_HASHFRAMES;
+	if (count > hd_goldenframes)
+		count = hd_goldenframes;
+
+	diffs = 0;
+	first = -1;
+	for (i=0 ; i<count ; i++)
+	{
+		if (hd_hashes[i] == hd_golden[i])
+			continue;
+		if (first == -1)
+			first = i;
+		diffs++;
+	}
+
+	if (first != -1)
+		Con_Printf ("hashcheck: FAILED, first divergent frame %i (%08x, expected %08x), %i frames differ\n",
+				first, hd_hashes[first], hd_golden[first], diffs);
+	else if (hd_frames != hd_goldenframes)
+		Con_Printf ("hashcheck: FAILED, %i frames drawn, %i expected\n",
+				hd_frames, hd_goldenframes);
+	else
+		Con_Printf ("hashcheck: %i frames identical\n", hd_frames);
+	CL_FreeHashLists ();
+
+	if (COM_CheckParm ("-hashexit"))
+	{
+		if (first != -1 || hd_frames != hd_goldenframes)
+			Sys_Error ("hashcheck failed");
+		Sys_Quit ();
+	}
+}
+
+/*
+====================
+CL_StartHashDemo
+
+====================
+*/
+static void CL_StartHashDemo (qboolean check)
+{
+	char	demo[MAX_QPATH];
+	char	name[MAX_OSPATH];
+
+	if (cmd_source != src_command)
+		return;
+
+	if (Cmd_Argc() != 2)
+	{
+		if (check)
+			Con_Printf ("hashcheck <demoname> : plays a demo and compares the frames\nagainst <demoname>.fhash\n");
+		else
+			Con_Printf ("hashdemo <demoname> : plays a demo with a fixed timestep\nand writes the frame hashes to <demoname>.fhash\n");
+		return;
+	}
+
+	if (strlen (Cmd_Argv(1)) >= sizeof(demo))
+	{
+		Con_Printf ("ERROR: demo name too long.\n");
+		return;
+	}
+	COM_StripExtension (Cmd_Argv(1), demo);
+	if (snprintf (name, sizeof(name), "%s/%s.fhash", com_gamedir, demo) >= (int)sizeof(name))
+	{
+		Con_Printf ("ERROR: demo name too long.\n");
+		return;
+	}
+
+// a run still playing is finished by this, so the lists and the name come
+// after it
+	CL_PlayDemo_f ();
+	if (!cls.demoplayback)
+		return;
+	strcpy (hd_name, name);
+
+	if (!CL_AllocHashLists (check))
+	{
+		Con_Printf ("ERROR: not enough memory for the frame hashes.\n");
+		CL_StopPlayback ();
+		return;
+	}
+
+	hd_check = check;
+	if (check && !CL_LoadHashList (hd_name))
+	{
+		Con_Printf ("ERROR: couldn't open %s.\n", hd_name);
+		CL_FreeHashLists ();
+		CL_StopPlayback ();
+		return;
+	}
+
+// same starting state for every run
+	srand (0);
+	hd_frames = 0;
+
+	cls.hashdemo = true;
+	cls.timedemo = true;
+	cls.td_startframe = host_framecount;
+	cls.td_lastframe = -1;		// get a new message this frame
+}
+
+/*
+====================
+CL_HashDemo_f
+
+hashdemo [demoname]
+====================
+*/
+void CL_HashDemo_f (void)
+{
+	CL_StartHashDemo (false);
+}
+
+/*
+====================
+CL_HashCheck_f
+
+hashcheck [demoname]
+====================
+*/
+void CL_HashCheck_f (void)
+{
+	CL_StartHashDemo (true);
+}
+
+/*
+==============================================================================
+
+DEMO SEEKING
+
+While a demo plays, the file position of the next message is noted every
+demo_indexinterval seconds of demo time.  Every demo_keyframes seconds the
+entry also keeps the client state the server only sends when it changes:
+stats, lightstyles, the scoreboard, the intermission and the cd track;
+entities and the player state come with every update anyway.  The index
+lives on the hunk from the first entry of a level until the next
+CL_ClearState.
+
+demoseek fast-forwards by parsing messages and relinking the entities
+without drawing a frame.  Seeking back jumps to the last keyframe before
+the target and fast-forwards from there.
+
+==============================================================================
+*/
+
+#define	MAX_DEMOINDEX		512
+#define	MAX_DEMOKEYFRAMES	16
+
+typedef struct
+{
+	int		offset;			// file position of the next message
+	float	time;			// cl.mtime[0] with everything before offset parsed
+	int		keyframe;		// -1 = none
+} demoindex_t;
+
+typedef struct
+{
+	char	name[MAX_SCOREBOARDNAME];
+	float	entertime;
+	int		frags;
+	int		colors;
+} demoscore_t;			// scoreboard_t without the translation tables
+
+typedef struct
+{
+	int				stats[MAX_CL_STATS];
+	int				items;
+	lightstyle_t	lightstyles[MAX_LIGHTSTYLES];
+	int				intermission;
+	int				completed_time;
+	int				cdtrack, looptrack;
+	demoscore_t		scores[MAX_SCOREBOARD];
+} demokeyframe_t;
+
+cvar_t	demo_indexinterval = {"demo_indexinterval", "5"};
+cvar_t	demo_keyframes = {"demo_keyframes", "60"};	// seconds between keyframes, 0 = none
+
+static demoindex_t		*dm_index;			// [MAX_DEMOINDEX], hunk
+static demokeyframe_t	*dm_keyframes;		// [MAX_DEMOKEYFRAMES], hunk
+static int		dm_numindex;
+static int		dm_numkeyframes;
+static float	dm_lastkeyframe;
+
+/*
+====================
+CL_ClearDemoIndex
+
+Also called from CL_ClearState, the hunk the index was on goes with the
+level
+====================
+*/
+void CL_ClearDemoIndex (void)
+{
+	dm_index = NULL;
+	dm_keyframes = NULL;
+	dm_numindex = 0;
+	dm_numkeyframes = 0;
+}
+
+/*
+====================
+CL_IndexDemo
+
+called with the demo file at the start of the next message
+====================
+*/
+static void CL_IndexDemo (void)
+{
+	demoindex_t		*e;
+	demokeyframe_t	*kf;
+	int				i, offset;
+	float			time;
+
+	offset = f_tell (cls.demofile);
+	time = cl.mtime[0];
+
+	if (dm_numindex)
+	{
+		e = &dm_index[dm_numindex-1];
+		if (offset <= e->offset)
+			return;			// replaying after a seek back
+		if (time < e->time)
+			dm_numindex = dm_numkeyframes = 0;	// the clock started over
+		else if (time < e->time + demo_indexinterval.value)
+			return;
+	}
+	if (dm_numindex == MAX_DEMOINDEX)
+		return;
+
+	if (!dm_index)
+	{
+		dm_index = Hunk_AllocName (MAX_DEMOINDEX * sizeof(*dm_index), "demoidx");
+		dm_keyframes = Hunk_AllocName (MAX_DEMOKEYFRAMES * sizeof(*dm_keyframes), "demokeys");
+	}
+
+	e = &dm_index[dm_numindex++];
+	e->offset = offset;
+	e->time = time;
+	e->keyframe = -1;
+
+	if (!demo_keyframes.value || dm_numkeyframes == MAX_DEMOKEYFRAMES)
+		return;
+	if (dm_numkeyframes && time < dm_lastkeyframe + demo_keyframes.value)
+		return;
+
+	dm_lastkeyframe = time;
+	e->keyframe = dm_numkeyframes;
+	kf = &dm_keyframes[dm_numkeyframes++];
+	memcpy (kf->stats, cl.stats, sizeof(kf->stats));
+	kf->items = cl.items;
+	memcpy (kf->lightstyles, cl_lightstyle, sizeof(kf->lightstyles));
+	kf->intermission = cl.intermission;
+	kf->completed_time = cl.completed_time;
+	kf->cdtrack = cl.cdtrack;
+	kf->looptrack = cl.looptrack;
+	memset (kf->scores, 0, sizeof(kf->scores));
+	for (i=0 ; i<cl.maxclients && i<MAX_SCOREBOARD ; i++)
+	{
+		memcpy (kf->scores[i].name, cl.scores[i].name, MAX_SCOREBOARDNAME);
+		kf->scores[i].entertime = cl.scores[i].entertime;
+		kf->scores[i].frags = cl.scores[i].frags;
+		kf->scores[i].colors = cl.scores[i].colors;
+	}
+}
+
+/*
+====================
+CL_RewindDemo
+
+Positions the demo at an index entry.  Effects already spawned belong to
+the future and are dropped, entities are corrected by the next update.
+====================
+*/
+static void CL_RewindDemo (demoindex_t *e)
+{
+	demokeyframe_t	*kf;
+	scoreboard_t	*sc;
+	int				i;
+
+	f_lseek (cls.demofile, e->offset);
+	cl.mtime[0] = cl.mtime[1] = e->time;
+
+	if (e->keyframe >= 0)
+	{
+		kf = &dm_keyframes[e->keyframe];
+		memcpy (cl.stats, kf->stats, sizeof(cl.stats));
+		cl.items = kf->items;
+		memcpy (cl_lightstyle, kf->lightstyles, sizeof(cl_lightstyle));
+
+		if (cl.intermission != kf->intermission)
+		{
+			cl.intermission = kf->intermission;
+			scr_centertime_off = 0;		// the finale text is from later
+			vid.recalc_refdef = true;
+		}
+		cl.completed_time = kf->completed_time;
+
+		for (i=0, sc=cl.scores ; i<cl.maxclients && i<MAX_SCOREBOARD ; i++, sc++)
+		{
+			memcpy (sc->name, kf->scores[i].name, MAX_SCOREBOARDNAME);
+			sc->entertime = kf->scores[i].entertime;
+			sc->frags = kf->scores[i].frags;
+			if (sc->colors != kf->scores[i].colors)
+			{
+				sc->colors = kf->scores[i].colors;
+				CL_NewTranslation (i);
+			}
+		}
+		Sbar_Changed ();
+
+		if (cl.cdtrack != kf->cdtrack)
+		{
+			cl.cdtrack = kf->cdtrack;
+			cl.looptrack = kf->looptrack;
+			CDAudio_Play ((byte)(cls.forcetrack != -1 ? cls.forcetrack : cl.cdtrack), true);
+		}
+	}
+
+	memset (cl_dlights, 0, sizeof(cl_dlights));
+	memset (cl_beams, 0, sizeof(cl_beams));
+	R_ClearParticles ();
+}
+
+/*
+====================
+CL_FastForwardDemo
+
+parses messages until the demo reaches time, without drawing or sound
+====================
+*/
+static void CL_FastForwardDemo (float time)
+{
+	cls.demoseeking = true;
+	while (cls.demoplayback && cls.signon == SIGNONS && cl.mtime[0] < time)
+	{
+		if (!CL_ReadDemoMessage ())
+			break;
+		cl.last_received_message = realtime;
+		CL_ParseServerMessage ();
+		cl.time = cl.mtime[0];
+		CL_RelinkEntities ();
+	}
+	cls.demoseeking = false;
+
+// no lerp from the time before the seek
+	cl.mtime[1] = cl.mtime[0];
+	cl.oldtime = cl.time = cl.mtime[0];
+}
+
+/*
+====================
+CL_DemoSeek_f
+
+demoseek <time>
+====================
+*/
+void CL_DemoSeek_f (void)
+{
+	float	base, time;
+	char	*s;
+	int		i, best;
+
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("demoseek <time> : jump to <time> seconds into the demo,\n+<time> or -<time> from the current position\n");
+		if (dm_numindex)
+			Con_Printf ("%i index entries, %i keyframes, %.1f seconds indexed\n",
+					dm_numindex, dm_numkeyframes,
+					dm_index[dm_numindex-1].time - dm_index[0].time);
+		return;
+	}
+
+	if (!cls.demoplayback || cls.signon != SIGNONS || !dm_numindex)
+	{
+		Con_Printf ("demoseek: no demo playing\n");
+		return;
+	}
+	if (cls.hashdemo)
+	{
+		Con_Printf ("demoseek: not during hashdemo\n");
+		return;
+	}
+
+	base = dm_index[0].time;
+	s = Cmd_Argv(1);
+	if (s[0] == '+' || s[0] == '-')
+		time = cl.mtime[0] + atof (s);
+	else
+		time = base + atof (s);
+	if (time < base)
+		time = base;
+
+	if (time < cl.mtime[0])
+	{
+		best = 0;
+		for (i=0 ; i<dm_numindex && dm_index[i].time <= time ; i++)
+			if (dm_index[i].keyframe >= 0 || !demo_keyframes.value)
+				best = i;
+		CL_RewindDemo (&dm_index[best]);
+	}
+	CL_FastForwardDemo (time);
+
+	if (!cls.demoplayback)
+		return;		// ran off the end
+
+// time the frames from here on
+	if (cls.timedemo)
+	{
+		cls.td_startframe = host_framecount;
+		cls.td_lastframe = host_framecount;
+		cls.ftd_framepos = 0;
+		cls.ftd_frames_recorded = 0;
+	}
+
+	Con_Printf ("demo at %.1f seconds\n", cl.mtime[0] - base);
+}
@@ -66,6 +66,7 @@ void CL_ClearState (void)
 
 	if (!sv.active)
 		Host_ClearMemory ();
+	CL_ClearDemoIndex ();
 
 // wipe the entire cl structure
 	memset (&cl, 0, sizeof(cl));
@@ -728,5 +729,12 @@ void CL_Init (void)
 	Cmd_AddCommand ("playdemo", CL_PlayDemo_f);
 	Cmd_AddCommand ("timedemo", CL_TimeDemo_f);
 	Cmd_AddCommand ("frametimedemo", CL_FrameTimeDemo_f);
+	Cmd_AddCommand ("hashdemo", CL_HashDemo_f);
+	Cmd_AddCommand ("hashcheck", CL_HashCheck_f);
+	Cvar_RegisterVariable (&hashdemo_palette);
+	Cvar_RegisterVariable (&hashdemo_frametime);
+	Cmd_AddCommand ("demoseek", CL_DemoSeek_f);
+	Cvar_RegisterVariable (&demo_indexinterval);
+	Cvar_RegisterVariable (&demo_keyframes);
 }
 
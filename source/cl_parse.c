@@ -131,6 +131,9 @@ void CL_ParseStartSoundPacket(void)
 	
 	for (i=0 ; i<3 ; i++)
 		pos[i] = MSG_ReadCoord ();
+
+	if (cls.demoseeking)
+		return;
  
     S_StartSound (ent, channel, clp.sound_precache[sound_num], pos, volume/255.0, attenuation);
 }       
@@ -99,6 +99,55 @@ void CL_ParseBeam (model_t *m)
 	Con_Printf ("beam list overflow!\n");	
 }
 
+/*
+=================
+CL_SkipTEnt
+
+Reads past a temp entity without any of its sounds, lights, particles or
+beams, a demo seek would only throw them away
+=================
+*/
+static void CL_SkipTEnt (int type)
+{
+	int		i, count;
+
+	switch (type)
+	{
+	case TE_LIGHTNING1:
+	case TE_LIGHTNING2:
+	case TE_LIGHTNING3:
+	case TE_BEAM:
+		MSG_ReadShort ();
+		count = 6;
+		break;
+
+	case TE_WIZSPIKE:
+	case TE_KNIGHTSPIKE:
+	case TE_SPIKE:
+	case TE_SUPERSPIKE:
+	case TE_GUNSHOT:
+	case TE_EXPLOSION:
+	case TE_TAREXPLOSION:
+	case TE_LAVASPLASH:
+	case TE_TELEPORT:
+		count = 3;
+		break;
+
+	case TE_EXPLOSION2:
+		for (i=0 ; i<3 ; i++)
+			MSG_ReadCoord ();
+		MSG_ReadByte ();
+		MSG_ReadByte ();
+		return;
+
+	default:
+		Sys_Error ("CL_ParseTEnt: bad type");
+	}
+
+	for (i=0 ; i<count ; i++)
+		MSG_ReadCoord ();
+}
+
 /*
 =================
 CL_ParseTEnt
@@ -113,6 +162,13 @@ void CL_ParseTEnt (void)
 	int		colorStart, colorLength;
 
 	type = MSG_ReadByte ();
+
+	if (cls.demoseeking)
+	{
+		CL_SkipTEnt (type);
+		return;
+	}
+
 	switch (type)
 	{
 	case TE_WIZSPIKE:			// spike hitting wall
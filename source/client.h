@@ -64,6 +64,9 @@ typedef struct {
 	float server;
 	float r, dp, rw, db, se, de, dv;
 	int   faceclip, polycount, drawnpolycount, surf;
+	float scale;		// r_dynres view scale
+	float mipbias;		// d_mipgov
+	memsample_t mem;
 } ftdemo_point_t;
 
 //
@@ -127,6 +130,8 @@ typedef struct
 	qboolean	demoplayback;
 	qboolean	timedemo;
 	qboolean    frametimedemo;
+	qboolean	hashdemo;			// fixed timestep, frames hashed in VID_Update
+	qboolean	demoseeking;		// demoseek is parsing ahead, nothing is drawn or heard
 	int			forcetrack;			// -1 = use normal cd track
 	FIL			*demofile;
 	int			td_lastframe;		// to meter out one message a frame
@@ -307,6 +312,7 @@ void CL_Signon4 (void);
 void CL_Disconnect (void);
 void CL_Disconnect_f (void);
 void CL_NextDemo (void);
+void CL_RelinkEntities (void);
 
 #define			MAX_VISEDICTS	256
 extern	int				cl_numvisedicts;
@@ -355,6 +361,16 @@ void CL_PlayDemo_f (void);
 void CL_TimeDemo_f (void);
 void CL_FrameTimeDemo_f (void);
 void CL_FrameTimeDemoCloseFrame (void);
+void CL_HashDemo_f (void);
+void CL_HashCheck_f (void);
+void CL_HashDemoFrame (byte *buffer, int rowbytes, byte *palette);
+void CL_DemoSeek_f (void);
+void CL_ClearDemoIndex (void);
+
+extern	cvar_t	hashdemo_palette;
+extern	cvar_t	hashdemo_frametime;
+extern	cvar_t	demo_indexinterval;
+extern	cvar_t	demo_keyframes;
 
 //
 // cl_parse.c
@@ -1213,6 +1213,7 @@ QUAKE FILESYSTEM
 */
 
 __psram_bss ("common") int     com_filesize;
+__psram_bss ("common") int     com_filestart;
 
 
 //
@@ -1425,6 +1426,7 @@ int COM_FindFile (char *filename, int *handle, FIL **file)
 						}
 					}
 					com_filesize = pak->files[i].filelen;
+					com_filestart = pak->files[i].filepos;
 					return com_filesize;
 				}
 		}
@@ -1463,6 +1465,7 @@ int COM_FindFile (char *filename, int *handle, FIL **file)
 
 			Sys_Printf ("FindFile: %s\n", netpath);
 			com_filesize = Sys_FileOpenRead (netpath, &i);
+			com_filestart = 0;
 			if (handle)
 				*handle = i;
 			else
@@ -165,6 +165,7 @@ char	*va2(char* buf, size_t sz, const char* format, ...); // the same, but more
 //============================================================================
 
 extern int com_filesize;
+extern int com_filestart;	// of the last file found, within its pak
 struct cache_user_s;
 
 extern	char	com_gamedir[MAX_OSPATH];
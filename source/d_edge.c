@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "d_local.h"
+#include "kcapture.h"
 
 static int	miplevel;
 
@@ -228,10 +229,8 @@ void __no_inline_not_in_flash_func(D_DrawSurfaces) (void)
 
 			if (s->flags & SURF_DRAWSKY)
 			{
-				if (!r_skymade)
-				{
-					R_MakeSky ();
-				}
+				if (kcap_active)
+					KCap_Sky (s->spans);
 
 				D_DrawSkyScans8 (s->spans);
 				D_DrawZSpans (s->spans);
@@ -251,9 +250,7 @@ void __no_inline_not_in_flash_func(D_DrawSurfaces) (void)
 			{
 				pface = s->data;
 				miplevel = 0;
-				cacheblock = (pixel_t *)
-						((byte *)pface->texinfo->texture +
-						pface->texinfo->texture->offsets[0]);
+				cacheblock = (pixel_t *)Mod_TextureMip (pface->texinfo->texture, 0);
 				cachewidth = 64;
 
 				if (s->insubmodel)
@@ -271,6 +268,9 @@ void __no_inline_not_in_flash_func(D_DrawSurfaces) (void)
 				}
 
 				D_CalcGradients (pface);
+				if (kcap_active)
+					KCap_Spans (KC_TURB, s->spans);
+
 				Turbulent8 (s->spans);
 				D_DrawZSpans (s->spans);
 
@@ -317,6 +317,8 @@ void __no_inline_not_in_flash_func(D_DrawSurfaces) (void)
 				cachewidth = pcurrentcache->width;
 
 				D_CalcGradients (pface);
+				if (kcap_active)
+					KCap_Spans (KC_SPANS, s->spans);
 
 				(*d_drawspans) (s->spans);
 
@@ -37,48 +37,8 @@ typedef enum {
 	pt_static, pt_grav, pt_slowgrav, pt_fire, pt_explode, pt_explode2, pt_blob, pt_blob2
 } __ptype_t;
 
-// !!! if this is changed, it must be changed in d_ifacea.h too !!!
-// TODO update d_ifacea.h!!!
-#ifdef Q_PARTICLES_FP16
-// !!! if this is changed, it must be changed in d_ifacea.h too !!!
-// TODO update d_ifacea.h!!!
-typedef struct particle_s
-{
-	// first two 8b cache lines
-	struct particle_s	*next;
-	float				die;
-	
-	// next 8b cache line
-	vechalf3_t	vel;
-	int16_t     reserved;
-
-	// and next two 8b cachelines
-// driver-usable fields
-	vec3_t		org;
-// drivers never touch the following fields
-	int16_t		ramp;		// was float, now q1.7.8
-	byte		color;
-	ptype_t		type;
-} particle_t;
-#else
-typedef struct particle_s
-{
-	// first two 8b cache lines
-// driver-usable fields
-	vec3_t		org;
-// drivers never touch the following fields
-	int16_t		ramp;		// was float, now q1.7.8
-	byte		color;
-	ptype_t		type;
-	
-	// different 8b cache line
-	struct particle_s	*next;
-	float		die;
-
-	vec3_t		vel;
-} particle_t;
-#endif
-
+// particles live in r_part.c as separate field arrays, the driver only sees
+// their origins and colors
 #define PARTICLE_RAMP_FRACT 10
 #define PARTICLE_Z_CLIP	8.0
 
@@ -159,6 +119,8 @@ extern float	r_aliasuvscale;		// scale-up factor for screen u and v
 									//  on Alias vertices passed to driver
 
 extern qboolean	r_dowarp;
+extern float	d_mipbias;			// mip levels added by D_MipGovernor
+extern qboolean	r_dynresfloor;		// r_dynres can't shrink the view any more
 
 extern affinetridesc_t	r_affinetridesc;
 extern spritedesc_t		r_spritedesc;
@@ -179,7 +141,7 @@ void D_DisableBackBufferAccess (void);
 void D_EndDirectRect (int x, int y, int width, int height);
 void D_PolysetDraw (void);
 void D_PolysetDrawFinalVerts (finalvert_t *fv, int numverts);
-void D_DrawParticle (particle_t *pparticle);
+void D_DrawParticles (const float *x, const float *y, const float *z, const byte *color, int count);
 void D_DrawPoly (void);
 void D_DrawSprite (void);
 void D_DrawSurfaces (void);
@@ -189,9 +151,13 @@ void D_EndParticles (void);
 void D_Init (void);
 void D_ViewChanged (void);
 void D_SetupFrame (void);
+void D_MipGovernor (void);
 void D_StartParticles (void);
 void D_TurnZOn (void);
-void D_WarpScreen (void);
+void D_WarpScreen (vrect_t *view);
+void D_WarpOverdraw (int x, int y, int width, int height);
+// anything drawn into vid.buffer after the view calls this first
+void D_UpscaleView (vrect_t *src, vrect_t *dst);
 
 void D_FillRect (vrect_t *vrect, int color);
 void D_DrawRect (void);
@@ -204,7 +170,7 @@ void D_PolysetUpdateTables (void);
 
 // these are currently for internal use only, and should not be used by drivers
 extern int				r_skydirect;
-extern byte				*r_skysource;
+extern byte				*r_skytop, *r_skybottom;
 
 // transparency types for D_DrawRect ()
 #define DR_SOLID		0
@@ -235,6 +201,7 @@ typedef struct
 extern drawsurf_t	r_drawsurf;
 
 void R_DrawSurface (void);
+void R_DrawSurfaceBlocks (void);
 void R_GenTile (msurface_t *psurf, void *pdest);
 
 
@@ -256,5 +223,3 @@ extern float	skytime;
 extern int		c_surf;
 extern vrect_t	scr_vrect;
 
-extern byte		*r_warpbuffer;
-
@@ -21,17 +21,27 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "d_local.h"
+#include "sctrace.h"
+#include "quakegeneric.h"
 
 #define NUM_MIPS	4
 
 cvar_t	d_subdiv16 = {"d_subdiv16", "1"};
 cvar_t	d_mipcap = {"d_mipcap", "0"};
 cvar_t	d_mipscale = {"d_mipscale", "1"};
+cvar_t	d_mipgov = {"d_mipgov", "0", true};
+cvar_t	d_mipgov_fps = {"d_mipgov_fps", "30", true};	// frame budget, 0 for cache pressure only
+cvar_t	d_mipgov_max = {"d_mipgov_max", "1.5"};		// mip levels
+cvar_t	d_mipgov_build = {"d_mipgov_build", "0.25"};	// of the surface cache rebuilt in a frame
+cvar_t	d_mipgov_calm = {"d_mipgov_calm", "30"};		// frames before stepping back
+cvar_t	d_mipgov_hold = {"d_mipgov_hold", "8"};		// frames between steps up
+cvar_t	d_mipgov_minbuild = {"d_mipgov_minbuild", "0.05"};	// of the surface cache, to blame it for the frame time
 
 surfcache_t		*d_initial_rover;
 qboolean		d_roverwrapped;
 int				d_minmip;
 float			d_scalemip[NUM_MIPS-1];
+float			d_mipbias;			// mip levels, set by D_MipGovernor
 
 static float	basemip[NUM_MIPS-1] = {1.0, 0.5*0.8, 0.25*0.8};
 
@@ -53,6 +63,13 @@ void D_Init (void)
 	Cvar_RegisterVariable (&d_subdiv16);
 	Cvar_RegisterVariable (&d_mipcap);
 	Cvar_RegisterVariable (&d_mipscale);
+	Cvar_RegisterVariable (&d_mipgov);
+	Cvar_RegisterVariable (&d_mipgov_fps);
+	Cvar_RegisterVariable (&d_mipgov_max);
+	Cvar_RegisterVariable (&d_mipgov_build);
+	Cvar_RegisterVariable (&d_mipgov_calm);
+	Cvar_RegisterVariable (&d_mipgov_hold);
+	Cvar_RegisterVariable (&d_mipgov_minbuild);
 
 	r_drawpolys = false;
 	r_worldpolysbacktofront = false;
@@ -113,6 +130,103 @@ void D_DisableBackBufferAccess (void)
 }
 
 
+/*
+===============
+D_MipGovernor
+
+Called before the last frame's cache state is cleared. The mip bias goes
+up a step on a frame that thrashed the surface cache, rebuilt more than
+d_mipgov_build of it after wrapping, or went over the d_mipgov_fps budget
+while building more than d_mipgov_minbuild of it. After a step up it holds
+for d_mipgov_hold frames so the averaged frame time can catch up. It comes
+back a step after d_mipgov_calm frames in a row with none of that and time
+to spare. Coarser mips make smaller surfaces, so going up relieves the
+cache at once, but every step back down rebuilds what is on screen; hence
+the slow way down.
+
+r_dynres watches the same frame time and runs first, so the budget is left
+to it until the view is as small as r_dynres_min lets it go; cache
+pressure is acted on either way.
+===============
+*/
+#define	MIPGOV_STEP		0.25
+
+void D_MipGovernor (void)
+{
+	static double	lasttime;
+	static unsigned	lastallocated;
+	static float	avg;
+	static int		calm;
+	static int		hold;
+	double			now;
+	float			frametime, target, max, limit;
+	int				built;
+	qboolean		pressure, headroom, overbudget;
+
+	now = Sys_FloatTime ();
+	frametime = now - lasttime;
+	lasttime = now;
+	built = sc_allocated - lastallocated;
+	lastallocated = sc_allocated;
+
+	// hashdemo frames have to come out the same every run
+	if (!d_mipgov.value || cls.hashdemo)
+	{
+		d_mipbias = 0;
+		avg = 0;
+		calm = 0;
+		hold = 0;
+		return;
+	}
+	if (frametime <= 0 || frametime > 0.5)
+	{	// loading or paused, not a frame worth going by
+		avg = 0;
+		return;
+	}
+
+	avg = avg ? avg + (frametime - avg) * 0.25 : frametime;
+	target = d_mipgov_fps.value > 0 ? 1.0 / d_mipgov_fps.value : 0;
+	limit = d_mipgov_build.value * sc_size;
+
+	overbudget = target && avg > target * 1.1 && r_dynresfloor &&
+			built > d_mipgov_minbuild.value * sc_size;
+	pressure = r_cache_thrash || (d_roverwrapped && built > limit) || overbudget;
+	headroom = !d_roverwrapped && built <= limit * 0.5 &&
+			(!target || avg < target * 0.9);
+
+	max = d_mipgov_max.value;
+	if (max > NUM_MIPS-1)
+		max = NUM_MIPS-1;
+
+	if (hold > 0)
+	{
+		hold--;
+		calm = 0;
+	}
+	else if (pressure)
+	{
+		calm = 0;
+		hold = (int)d_mipgov_hold.value;
+		d_mipbias += MIPGOV_STEP;
+	}
+	else if (headroom && d_mipbias > 0)
+	{
+		if (++calm >= d_mipgov_calm.value)
+		{
+			calm = 0;
+			d_mipbias -= MIPGOV_STEP;
+		}
+	}
+	else
+		calm = 0;
+
+	if (d_mipbias > max)
+		d_mipbias = max;
+	if (d_mipbias < 0)
+		d_mipbias = 0;
+}
+
+
 /*
 ===============
 D_SetupFrame
@@ -121,21 +235,29 @@ D_SetupFrame
 void D_SetupFrame (void)
 {
 	int		i;
+	float	bias;
 
 	d_viewbuffer = (void *)(byte *)vid.buffer;
 	screenwidth = vid.rowbytes;
 
+	qg_warp = NULL;		// the last view's, it is about to be drawn over
+
 	d_roverwrapped = false;
 	d_initial_rover = sc_rover;
 
+	if (sct_active)
+		SCTrace_Frame ();
+
 	d_minmip = d_mipcap.value;
 	if (d_minmip > 3)
 		d_minmip = 3;
 	else if (d_minmip < 0)
 		d_minmip = 0;
 
+// every level of bias halves the scale a mip is picked at
+	bias = d_mipbias ? pow (2, d_mipbias) : 1;
 	for (i=0 ; i<(NUM_MIPS-1) ; i++)
-		d_scalemip[i] = basemip[i] * d_mipscale.value;
+		d_scalemip[i] = basemip[i] * d_mipscale.value * bias;
 				d_drawspans = D_DrawSpans8;
 
 	d_aflatcolor = 0;
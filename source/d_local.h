@@ -48,6 +48,8 @@ typedef struct surfcache_s
 	byte				data[4];	// width*height elements
 } surfcache_t;
 
+#define SC_MINFRAGMENT	256		// smaller leftovers stay with the block
+
 // !!! if this is changed, it must be changed in asm_draw.h too !!!
 typedef struct sspan_s
 {
@@ -60,6 +62,8 @@ extern float	scale_for_mip;
 
 extern qboolean		d_roverwrapped;
 extern surfcache_t	*sc_rover;
+extern int			sc_size;
+extern unsigned		sc_allocated;
 extern surfcache_t	*d_initial_rover;
 
 extern float	d_sdivzstepu, d_tdivzstepu, d_zistepu;
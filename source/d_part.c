@@ -44,61 +44,32 @@ void D_StartParticles (void)
 // not used by software driver
 }
 
+#define D_PARTICLE_BATCH	512		// most particles projected at once
+
+typedef struct
+{
+	short	u, v;
+	short	izi;
+	byte	pix;
+	byte	color;
+} dparticle_t;
+
 /*
 ==============
-D_DrawParticle
+D_PlotParticle
 ==============
 */
-void __no_inline_not_in_flash_func(D_DrawParticle) (particle_t *pparticle)
+static inline void D_PlotParticle (dparticle_t *pparticle)
 {
-	vec3_t	local, transformed;
-	float	zi;
 	byte	*pdest;
 	short	*pz;
-	int		i, izi, pix, count, u, v;
+	int		i, izi, pix, count;
 	int     pcolor;
 
-// transform point
-	VectorSubtract (pparticle->org, r_origin, local);
-
-	transformed[0] = DotProduct(local, r_pright);
-	transformed[1] = DotProduct(local, r_pup);
-	transformed[2] = DotProduct(local, r_ppn);		
-
-	if (transformed[2] < PARTICLE_Z_CLIP)
-		return;
-
-// project the point
-// FIXME: preadjust xcenter and ycenter
-#ifdef Q_ALIAS_DOUBLE_TO_FLOAT_RENDER
-	zi = 1.0f / transformed[2];
-	u = (int)(xcenter + zi * transformed[0] + 0.5f);
-	v = (int)(ycenter - zi * transformed[1] + 0.5f);
-#else
-	zi = 1.0 / transformed[2];
-	u = (int)(xcenter + zi * transformed[0] + 0.5);
-	v = (int)(ycenter - zi * transformed[1] + 0.5);
-#endif
-
-	if ((v > d_vrectbottom_particle) || 
-		(u > d_vrectright_particle) ||
-		(v < d_vrecty) ||
-		(u < d_vrectx))
-	{
-		return;
-	}
-
-	pz = d_pzbuffer + (d_zwidth * v) + u;
-	pdest = d_viewbuffer + (vid.rowbytes*v) + u;
-	izi = (int)(zi * 0x8000);
-
-	pix = izi >> d_pix_shift;
-
-	if (pix < d_pix_min)
-		pix = d_pix_min;
-	else if (pix > d_pix_max)
-		pix = d_pix_max;
-
+	pz = d_pzbuffer + (d_zwidth * pparticle->v) + pparticle->u;
+	pdest = d_viewbuffer + (vid.rowbytes*pparticle->v) + pparticle->u;
+	izi = pparticle->izi;
+	pix = pparticle->pix;
 	pcolor = pparticle->color;
 
 	switch (pix)
@@ -208,3 +179,107 @@ void __no_inline_not_in_flash_func(D_DrawParticle) (particle_t *pparticle)
 		break;
 	}
 }
+
+/*
+==============
+D_DrawParticles
+
+The particles are transformed and projected a batch at a time into aux
+memory, then each batch is binned by screen row with a counting sort so
+the z and color writes go down the frame in order.
+==============
+*/
+void __no_inline_not_in_flash_func(D_DrawParticles) (const float *x, const float *y, const float *z, const byte *color, int count)
+{
+	vec3_t			local, transformed;
+	float			zi;
+	dparticle_t		*batch, *p;
+	unsigned short	*order;
+	unsigned short	rowstart[MAXHEIGHT+1];
+	int				i, first, size, numbatch, maxbatch;
+	int				izi, pix, u, v;
+
+	if (!count)
+		return;
+
+	ARENA_SCOPE (aux_arena);
+	maxbatch = (Arena_FreeBytes (&aux_arena) - 16) /
+			(int)(sizeof(dparticle_t) + sizeof(unsigned short));
+	if (maxbatch > D_PARTICLE_BATCH)
+		maxbatch = D_PARTICLE_BATCH;
+	if (maxbatch < 1)
+		Sys_Error ("D_DrawParticles: out of aux memory");
+	batch = Arena_Alloc (&aux_arena, maxbatch * sizeof(dparticle_t));
+	order = Arena_Alloc (&aux_arena, maxbatch * sizeof(unsigned short));
+
+	for (first=0 ; first<count ; first+=size)
+	{
+		size = count - first;
+		if (size > maxbatch)
+			size = maxbatch;
+
+		memset (rowstart, 0, sizeof(rowstart));
+		numbatch = 0;
+
+		for (i=first ; i<first+size ; i++)
+		{
+		// transform point
+			local[0] = x[i] - r_origin[0];
+			local[1] = y[i] - r_origin[1];
+			local[2] = z[i] - r_origin[2];
+
+			transformed[2] = DotProduct(local, r_ppn);
+			if (transformed[2] < PARTICLE_Z_CLIP)
+				continue;
+
+			transformed[0] = DotProduct(local, r_pright);
+			transformed[1] = DotProduct(local, r_pup);
+
+		// project the point
+		// FIXME: preadjust xcenter and ycenter
+#ifdef Q_ALIAS_DOUBLE_TO_FLOAT_RENDER
+			zi = 1.0f / transformed[2];
+			u = (int)(xcenter + zi * transformed[0] + 0.5f);
+			v = (int)(ycenter - zi * transformed[1] + 0.5f);
+#else
+			zi = 1.0 / transformed[2];
+			u = (int)(xcenter + zi * transformed[0] + 0.5);
+			v = (int)(ycenter - zi * transformed[1] + 0.5);
+#endif
+
+			if ((v > d_vrectbottom_particle) || 
+				(u > d_vrectright_particle) ||
+				(v < d_vrecty) ||
+				(u < d_vrectx))
+			{
+				continue;
+			}
+
+			izi = (int)(zi * 0x8000);
+
+			pix = izi >> d_pix_shift;
+
+			if (pix < d_pix_min)
+				pix = d_pix_min;
+			else if (pix > d_pix_max)
+				pix = d_pix_max;
+
+			p = &batch[numbatch++];
+			p->u = u;
+			p->v = v;
+			p->izi = izi;
+			p->pix = pix;
+			p->color = color[i];
+			rowstart[v+1]++;
+		}
+
+	// bin by row
+		for (v=0 ; v<=d_vrectbottom_particle ; v++)
+			rowstart[v+1] += rowstart[v];
+		for (i=0 ; i<numbatch ; i++)
+			order[rowstart[batch[i].v]++] = i;
+
+		for (i=0 ; i<numbatch ; i++)
+			D_PlotParticle (&batch[order[i]]);
+	}
+}
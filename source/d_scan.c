@@ -24,6 +24,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "r_local.h"
 #include "d_local.h"
+#include "quakegeneric.h"
 
 unsigned char	*r_turb_pbase, *r_turb_pdest;
 fixed16_t		r_turb_s, r_turb_t, r_turb_sstep, r_turb_tstep;
@@ -39,61 +40,184 @@ D_WarpScreen
 
 // this performs a slight compression of the screen at the same time as
 // the sine warp, to keep the edges from wrapping
+
+Only the row and column tables and the turb phase are set up here and
+published as qg_warp; the backend applies them while it copies the view
+out (QG_CopyRow), so an underwater frame costs no extra pass over the
+view. The view stays unwarped in the buffer until then, so anything about
+to be drawn over it calls D_WarpOverdraw first, which warps it in place
+and takes the warp back. view is where the finished view is in the buffer.
 =============
 */
-void D_WarpScreen (void)
+static int		warp_row[MAXHEIGHT+(AMP2*2)];
+static int		warp_rowofs[MAXHEIGHT+(AMP2*2)];
+static int		warp_column[MAXWIDTH+(AMP2*2)];
+static int		warp_ring;			// rows D_WarpInPlace has to keep
+static vrect_t	warp_bounds;		// read or written by the warp
+static qg_warp_t	warp;
+
+static void D_WarpInPlace (void);
+
+void D_WarpScreen (vrect_t *view)
 {
 	int		w, h;
 	int		u,v;
-	byte	*dest;
-	int		*turb;
-	int		*col;
-	byte	**row;
-	byte	*rowptr[MAXHEIGHT+(AMP2*2)];
-	int		column[MAXWIDTH+(AMP2*2)];
 	float	wratio, hratio;
 
-	ZBA_Reset();
-
-	r_warpbuffer = ZBA_Alloc(r_refdef.vrect.width * r_refdef.vrect.height);
-	memcpy(r_warpbuffer, vid.buffer, (r_refdef.vrect.width * r_refdef.vrect.height));
-
-	w = r_refdef.vrect.width;
-	h = r_refdef.vrect.height;
+	w = view->width;
+	h = view->height;
 
 	wratio = w / (float)scr_vrect.width;
 	hratio = h / (float)scr_vrect.height;
 
+	warp_ring = 1;
 	for (v=0 ; v<scr_vrect.height+AMP2*2 ; v++)
 	{
-		rowptr[v] = r_warpbuffer + (r_refdef.vrect.y * screenwidth) +
-				 (screenwidth * (int)((float)v * hratio * h / (h + AMP2 * 2)));
+		warp_row[v] = view->y +
+				 (int)((float)v * hratio * h / (h + AMP2 * 2));
+		warp_rowofs[v] = warp_row[v] * screenwidth;
+		if (v < scr_vrect.height && scr_vrect.y + v - warp_row[v] >= warp_ring)
+			warp_ring = scr_vrect.y + v - warp_row[v] + 1;
 	}
 
 	for (u=0 ; u<scr_vrect.width+AMP2*2 ; u++)
 	{
-		column[u] = r_refdef.vrect.x +
+		warp_column[u] = view->x +
 				(int)((float)u * wratio * w / (w + AMP2 * 2));
 	}
 
-	turb = intsintable + ((int)(cl.time*SPEED)&(CYCLE-1));
-	dest = vid.buffer + scr_vrect.y * vid.rowbytes + scr_vrect.x;
+	warp_bounds.x = view->x < scr_vrect.x ? view->x : scr_vrect.x;
+	warp_bounds.y = view->y < scr_vrect.y ? view->y : scr_vrect.y;
+	w = view->x + view->width > scr_vrect.x + scr_vrect.width ?
+			view->x + view->width : scr_vrect.x + scr_vrect.width;
+	h = view->y + view->height > scr_vrect.y + scr_vrect.height ?
+			view->y + view->height : scr_vrect.y + scr_vrect.height;
+	warp_bounds.width = w - warp_bounds.x;
+	warp_bounds.height = h - warp_bounds.y;
+
+	warp.x = scr_vrect.x;
+	warp.y = scr_vrect.y;
+	warp.width = scr_vrect.width;
+	warp.height = scr_vrect.height;
+	warp.turb = intsintable + ((int)(cl.time*SPEED)&(CYCLE-1));
+	warp.rowofs = warp_rowofs;
+	warp.column = warp_column;
+
+	qg_warp = &warp;	// until the next view is drawn
+
+// the two halves of the lcd_x view share the buffer rows
+	if (lcd_x.value)
+		D_WarpInPlace ();
+}
 
-	for (v=0 ; v<scr_vrect.height ; v++, dest += vid.rowbytes)
+/*
+=============
+D_WarpInPlace
+
+For when the warp can't wait for the present. A source row is never more
+than a few rows above the row being written, so each row is saved to a
+small ring in the aux arena just before it is written over, and rows read
+from at or above it come from the ring.
+=============
+*/
+static void D_WarpInPlace (void)
+{
+	int		u,v,k;
+	int		y, src, ring;
+	byte	*dest, *saved;
+	const int	*turb;
+	int		*col;
+	byte	*rows[AMP2*2+1];
+	ARENA_SCOPE (aux_arena);
+
+	ring = warp_ring;
+	saved = Arena_Alloc (&aux_arena, ring * screenwidth);
+
+	turb = warp.turb;
+	y = scr_vrect.y;
+	dest = d_viewbuffer + y * screenwidth;
+
+	for (v=0 ; v<scr_vrect.height ; v++, y++, dest += screenwidth)
 	{
-		col = &column[turb[v]];
-		row = &rowptr[v];
+		memcpy (saved + (y % ring) * screenwidth, dest, screenwidth);
+
+		for (k=0 ; k<=AMP2*2 ; k++)
+		{
+			src = warp_row[v + k];
+			if (src >= scr_vrect.y && src <= y)
+				rows[k] = saved + (src % ring) * screenwidth;	// already written over
+			else
+				rows[k] = d_viewbuffer + src * screenwidth;
+		}
 
+		col = &warp_column[turb[v]];
 		for (u=0 ; u<scr_vrect.width ; u+=4)
 		{
-			dest[u+0] = row[turb[u+0]][col[u+0]];
-			dest[u+1] = row[turb[u+1]][col[u+1]];
-			dest[u+2] = row[turb[u+2]][col[u+2]];
-			dest[u+3] = row[turb[u+3]][col[u+3]];
+			dest[scr_vrect.x+u+0] = rows[turb[u+0]][col[u+0]];
+			dest[scr_vrect.x+u+1] = rows[turb[u+1]][col[u+1]];
+			dest[scr_vrect.x+u+2] = rows[turb[u+2]][col[u+2]];
+			dest[scr_vrect.x+u+3] = rows[turb[u+3]][col[u+3]];
 		}
 	}
 
-	ZBA_Reset();
+	qg_warp = NULL;
+}
+
+/*
+=============
+D_WarpOverdraw
+
+Called before anything is drawn into the buffer after the view. If it
+lands on a view whose warp is still waiting for the present, the view is
+warped now so the overlay is not warped with it. Short of the crosshair,
+only the menu, console and the odd message are drawn over the view, so
+most underwater frames never get here.
+=============
+*/
+void D_WarpOverdraw (int x, int y, int width, int height)
+{
+	if (!qg_warp)
+		return;
+	if (x >= warp_bounds.x + warp_bounds.width || x + width <= warp_bounds.x ||
+		y >= warp_bounds.y + warp_bounds.height || y + height <= warp_bounds.y)
+		return;
+	D_WarpInPlace ();
+}
+
+/*
+=============
+D_UpscaleView
+
+Stretches the view drawn at a reduced size in src over dst, nearest pixel.
+It is done in place before anything is drawn over the view, rather than
+while presenting like the warp, so the crosshair, centerprint and console
+are drawn at full size. Both rects share their top left corner, and every
+pixel comes from at or above and left of itself, so going bottom up and
+right to left nothing is read after it has been written over.
+=============
+*/
+void D_UpscaleView (vrect_t *src, vrect_t *dst)
+{
+	static int	column[MAXWIDTH];
+	byte		*in, *out;
+	int			u, v, step, frac;
+
+	if (src->x != dst->x || src->y != dst->y ||
+		src->width > dst->width || src->height > dst->height)
+		Sys_Error ("D_UpscaleView: bad rects");
+
+	step = (src->width << 16) / dst->width;
+	for (u=0, frac=step>>1 ; u<dst->width ; u++, frac+=step)
+		column[u] = frac >> 16;
+
+	step = (src->height << 16) / dst->height;
+	for (v=dst->height-1 ; v>=0 ; v--)
+	{
+		in = d_viewbuffer + screenwidth*(src->y + ((v*step + (step>>1)) >> 16)) + src->x;
+		out = d_viewbuffer + screenwidth*(dst->y + v) + dst->x;
+		for (u=dst->width-1 ; u>=0 ; u--)
+			out[u] = in[column[u]];
+	}
 }
 
 /*
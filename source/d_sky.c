@@ -57,6 +57,25 @@ void __not_in_flash_func(D_Sky_uv_To_st) (int u, int v, fixed16_t *s, fixed16_t
 }
 
 
+/*
+=================
+D_SkyTexel
+
+The bottom layer scrolls by skytime*skyspeed texels over the top one and
+shows it through where it is 255, which R_MakeSky used to bake into a
+128*128 newsky every frame; only the sky pixels drawn pay for it now.
+=================
+*/
+#define D_SkyOfs(s,t)	((((t) & R_SKY_TMASK) >> (16-7)) + (((s) & R_SKY_SMASK) >> 16))
+
+static inline byte D_SkyTexel (fixed16_t s, fixed16_t t, fixed16_t shift)
+{
+	byte	b;
+
+	b = r_skybottom[D_SkyOfs (s + shift, t + shift)];
+	return b != 255 ? b : r_skytop[D_SkyOfs (s, t)];
+}
+
 /*
 =================
 D_DrawSkyScans8
@@ -68,11 +87,14 @@ void __no_inline_not_in_flash_func(D_DrawSkyScans8) (espan_t *pspan)
 	int				count, spancount, u, v;
 	unsigned char	*pdest;
 	fixed16_t		s, t, snext, tnext, sstep, tstep;
+	fixed16_t		shift;
 	int				spancountminus1;
 
 	sstep = 0;	// keep compiler happy
 	tstep = 0;	// ditto
 
+	shift = (int)(skytime*skyspeed) << 16;
+
 	do
 	{
 		pdest = (unsigned char *)((byte *)d_viewbuffer +
@@ -127,19 +149,19 @@ void __no_inline_not_in_flash_func(D_DrawSkyScans8) (espan_t *pspan)
 
 				do {
 					// manual unroll
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
-					*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
+					*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
 				} while (--sp8);
 			}
 			if (spancount > 0) do
 			{
-				*pdest++ = r_skysource[((t & R_SKY_TMASK) >> (16-7)) + ((s & R_SKY_SMASK) >> 16)]; s += sstep;	t += tstep;
+				*pdest++ = D_SkyTexel (s, t, shift); s += sstep;	t += tstep;
 			} while (--spancount);
 
 			s = snext;
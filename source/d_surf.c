@@ -22,12 +22,14 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 #include "quakedef.h"
 #include "d_local.h"
 #include "r_local.h"
+#include "sctrace.h"
 
 float           surfscale;
 qboolean        r_cache_thrash;         // set if surface cache is thrashing
 
 int                                     sc_size;
 surfcache_t                     *sc_rover, *sc_base;
+unsigned                                sc_allocated;   // bytes handed out, wraps; for memstat
 
 #define GUARDSIZE       4
 
@@ -109,6 +111,9 @@ void D_FlushCaches (void)
 	if (!sc_base)
 		return;
 
+	if (sct_active)
+		SCTrace_Flush ();
+
 	for (c = sc_base ; c ; c = c->next)
 	{
 		if (c->owner)
@@ -173,7 +178,7 @@ surfcache_t     *D_SCAlloc (int width, int size)
 	}
 
 // create a fragment out of any leftovers
-	if (new->size - size > 256)
+	if (new->size - size > SC_MINFRAGMENT)
 	{
 		sc_rover = (surfcache_t *)( (byte *)new + size);
 		sc_rover->size = new->size - size;
@@ -192,6 +197,7 @@ surfcache_t     *D_SCAlloc (int width, int size)
 		new->height = (size - sizeof(*new) + sizeof(new->data)) / width;
 
 	new->owner = NULL;              // should be set properly after return
+	sc_allocated += size;
 
 	if (d_roverwrapped)
 	{
@@ -278,6 +284,9 @@ surfcache_t* __no_inline_not_in_flash_func(D_CacheSurface) (msurface_t *surface,
 //
 	cache = surface->cachespots[miplevel];
 
+	if (sct_active)
+		SCTrace_Lookup (surface, miplevel, cache);
+
 	if (cache && !cache->dlight && surface->dlightframe != r_framecount
 			&& cache->texture == r_drawsurf.texture
 			&& cache->lightadj[0] == r_drawsurf.lightadj[0]
@@ -165,6 +165,7 @@ void Draw_Character (int x, int y, int num)
 	else
 		drawline = 8;
 
+	D_WarpOverdraw (x, y, 8, drawline);
 	dest = vid.conbuffer + y*vid.conrowbytes + x;
 	
 	while (drawline--)
@@ -269,6 +270,7 @@ void Draw_Pic (int x, int y, qpic_t *pic)
 
 	source = pic->data;
 
+	D_WarpOverdraw (x, y, pic->width, pic->height);
 	dest = vid.buffer + y * vid.rowbytes + x;
 
 	for (v=0 ; v<pic->height ; v++)
@@ -299,6 +301,7 @@ void Draw_TransPic (int x, int y, qpic_t *pic)
 		
 	source = pic->data;
 
+	D_WarpOverdraw (x, y, pic->width, pic->height);
 	dest = vid.buffer + y * vid.rowbytes + x;
 
 	if (pic->width & 7)
@@ -363,6 +366,7 @@ void Draw_TransPicTranslate (int x, int y, qpic_t *pic, byte *translation)
 		
 	source = pic->data;
 
+	D_WarpOverdraw (x, y, pic->width, pic->height);
 	dest = vid.buffer + y * vid.rowbytes + x;
 
 	if (pic->width & 7)
@@ -456,6 +460,7 @@ void Draw_ConsoleBackground (int lines)
 		Draw_CharToConback (ver[x], dest+(x<<3));
 	
 // draw the pic
+	D_WarpOverdraw (0, 0, vid.conwidth, lines);
 	dest = vid.conbuffer;
 
 	for (y=0 ; y<lines ; y++, dest += vid.conrowbytes)
@@ -496,6 +501,7 @@ void R_DrawRect (vrect_t *prect, int rowbytes, byte *psrc,
 	int		i, j, srcdelta, destdelta;
 	byte	*pdest;
 
+	D_WarpOverdraw (prect->x, prect->y, prect->width, prect->height);
 	pdest = vid.buffer + (prect->y * vid.rowbytes) + prect->x;
 
 	srcdelta = rowbytes - prect->width;
@@ -612,6 +618,7 @@ void Draw_Fill (int x, int y, int w, int h, int c)
 	unsigned		uc;
 	int				u, v;
 
+	D_WarpOverdraw (x, y, w, h);
 	dest = vid.buffer + y*vid.rowbytes + x;
 	for (v=0 ; v<h ; v++, dest += vid.rowbytes)
 		for (u=0 ; u<w ; u++)
@@ -634,6 +641,7 @@ void Draw_FadeScreen (void)
 	S_ExtraUpdate ();
 	VID_LockBuffer ();
 
+	D_WarpOverdraw (0, 0, vid.width, vid.height);
 	for (y=0 ; y<vid.height ; y++)
 	{
 		int	t;
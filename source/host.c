@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "r_local.h"
+#include "pcprof.h"
 
 /*
 
@@ -232,6 +233,11 @@ void Host_InitLocal (void)
 
 	Cvar_RegisterVariable (&temp1);
 	Cvar_RegisterVariable (&stacktosram);
+	Cvar_RegisterVariable (&stackpaint);
+	Cmd_AddCommand ("stackreport", stackcall_report_f);
+	Arena_Init ();
+	MemStat_Init ();
+	PCProf_Init ();
 
 	Host_FindMaxClients ();
 	
@@ -514,6 +520,14 @@ qboolean Host_FilterTime (float time)
 {
 	realtime += time;
 
+	if (cls.hashdemo)
+	{	// the wall clock is ignored so every run draws the same frames
+		realtime = oldrealtime + hashdemo_frametime.value;
+		host_frametime = hashdemo_frametime.value;
+		oldrealtime = realtime;
+		return true;
+	}
+
 	if (!cls.timedemo && realtime - oldrealtime < (1.0 / 72.0))
 		return false;		// framerate is too high
 
@@ -599,6 +613,7 @@ void _Host_Frame (float time)
 	static double		time3 = 0;
 	int			pass1, pass2, pass3;
 	ftdemo_point_t 	*p;
+	memsample_t		memsample;
 
 	time0 = Sys_FloatTime();
 
@@ -609,8 +624,7 @@ void _Host_Frame (float time)
 		if (snd_mutex.owner == 0) mutex_exit(&snd_mutex);
 		Hunk_FreeToLowMark(lm);
 		Hunk_FreeToHighMark(hm);
-		AUXA_Reset();
-		ZBA_Reset();
+		Arena_ResetAll();
 		return;			// something bad happened, or the server disconnected
 	}
 
@@ -699,8 +713,13 @@ void _Host_Frame (float time)
 		p = &cls.ftd_buf[cls.ftd_framepos];
 		p->total  = (Sys_FloatTime() - time0) * 1000;
 		p->server = (time1 - time0) * 1000;
+		MemStat_Frame (&p->mem);
 		CL_FrameTimeDemoCloseFrame();
 	}
+	else if (scr_showmem.value)
+	{
+		MemStat_Frame (&memsample);
+	}
 
 	if (host_speeds.value)
 	{
@@ -418,96 +418,622 @@ void Host_SavegameComment (char *text)
 
 /*
 ===============
-Host_Savegame_f
+Host_CanSavegame
 ===============
 */
-void Host_Savegame_f (void)
+static qboolean Host_CanSavegame (void)
 {
-	char	name[256];
-	FIL		*f;
 	int		i;
-	char	comment[SAVEGAME_COMMENT_LENGTH+1];
-
-	if (cmd_source != src_command)
-		return;
 
 	if (!sv.active)
 	{
 		Con_Printf ("Not playing a local game.\n");
-		return;
+		return false;
 	}
 
 	if (cl.intermission)
 	{
 		Con_Printf ("Can't save in intermission.\n");
-		return;
+		return false;
 	}
 
 	if (svs.maxclients != 1)
 	{
 		Con_Printf ("Can't save multiplayer games.\n");
+		return false;
+	}
+
+	for (i=0 ; i<svs.maxclients ; i++)
+	{
+		if (svs.clients[i].active && (svs.clients[i].edict->v.health <= 0) )
+		{
+			Con_Printf ("Can't savegame with a dead player\n");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+===============================================================================
+
+SNAPSHOTS
+
+A snapshot is the raw server state: lightstyles, the DEF_SAVEGLOBAL
+globals and the edict fields, copied as they are. Strings that live in the
+progs string table are stored as offsets, everything else (ED_NewString,
+temp strings) goes into a string table at the end and is stored as
+-(1 + table offset). Offsets, function and field numbers are only valid
+for the same progs, so the progs CRC is part of the header.
+
+Snapshots are built in hunk memory sized to the save: temporary for SD
+saves, a high hunk block for the quicksave slot and SD loads, which have to
+survive SV_SpawnServer.
+
+===============================================================================
+*/
+
+#define	SNAPSHOT_IDENT		(('P'<<24)+('A'<<16)+('N'<<8)+'S')
+#define	SNAPSHOT_VERSION	2
+
+#define	SNAPSHOT_MAXGLOBALS	512
+#define	SNAPSHOT_MAXFIELDS	256
+
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		crc;				// pr_crc of the progs that wrote it
+	char	comment[SAVEGAME_COMMENT_LENGTH+1];
+	char	mapname[MAX_QPATH];
+	float	spawn_parms[NUM_SPAWN_PARMS];
+	int		skill;
+	float	time;
+	int		numglobals;			// saved ones
+	int		entityfields;
+	int		numedicts;
+	int		stringsize;
+	int		lightstyles[MAX_LIGHTSTYLES];	// snapshot strings, 0 = none
+} snapheader_t;
+
+// followed by numglobals ints, then for every edict free, freetime and
+// entityfields ints, then stringsize bytes of strings
+typedef struct
+{
+	int		free;
+	float	freetime;
+} snapedict_t;
+
+static byte		*sv_quickslot;			// high hunk
+static int		sv_quickslotsize, sv_quicksize;
+static int		sv_quickmark, sv_quicktop;	// high marks below and above it
+
+static char		*snap_strings;			// the table of the snapshot being built
+static int		snap_stringsize;
+
+static int		snap_globals[SNAPSHOT_MAXGLOBALS], snap_numglobals;
+static int		snap_globalstrings[SNAPSHOT_MAXGLOBALS], snap_numglobalstrings;	// into snap_globals
+static int		snap_fieldstrings[SNAPSHOT_MAXFIELDS], snap_numfieldstrings;
+
+/*
+===============
+Host_SnapshotFindStrings
+
+offsets of the globals that are saved, the same ones ED_WriteGlobals
+writes, and of the string typed ones and entity fields; false if there are
+more than a snapshot can hold
+===============
+*/
+static qboolean Host_SnapshotFindStrings (void)
+{
+	int		i, type;
+	ddef_t	*def;
+
+	snap_numglobals = snap_numglobalstrings = 0;
+	for (i=0, def=pr_globaldefs ; i<progs->numglobaldefs ; i++, def++)
+	{
+		if (!(def->type & DEF_SAVEGLOBAL))
+			continue;
+		type = def->type & ~DEF_SAVEGLOBAL;
+		if (type != ev_string && type != ev_float && type != ev_entity)
+			continue;
+		if (snap_numglobals == SNAPSHOT_MAXGLOBALS)
+			return false;
+		if (type == ev_string)
+			snap_globalstrings[snap_numglobalstrings++] = snap_numglobals;
+		snap_globals[snap_numglobals++] = def->ofs;
+	}
+
+	snap_numfieldstrings = 0;
+	for (i=0, def=pr_fielddefs ; i<progs->numfielddefs ; i++, def++)
+	{
+		if ((def->type & ~DEF_SAVEGLOBAL) != ev_string)
+			continue;
+		if (snap_numfieldstrings == SNAPSHOT_MAXFIELDS)
+			return false;
+		snap_fieldstrings[snap_numfieldstrings++] = def->ofs;
+	}
+	return true;
+}
+
+/*
+===============
+Host_SnapshotStringSize
+
+table bytes a string value takes, 0 for progs strings
+===============
+*/
+static int Host_SnapshotStringSize (int value)
+{
+	if (value >= 0 && value < progs->numstrings)
+		return 0;		// part of the progs
+	return strlen (pr_strings + value) + 1;
+}
+
+/*
+===============
+Host_SnapshotString
+
+string to snapshot encoding, the table has been sized for it
+===============
+*/
+static void Host_SnapshotString (int *value)
+{
+	int		len;
+
+	len = Host_SnapshotStringSize (*value);
+	if (!len)
 		return;
+	memcpy (snap_strings + snap_stringsize, pr_strings + *value, len);
+	*value = -1 - snap_stringsize;
+	snap_stringsize += len;
+}
+
+/*
+===============
+Host_RestoreString
+
+snapshot encoding back to a string offset, table strings are copied to the
+hunk like ED_NewString does
+===============
+*/
+static int Host_RestoreString (int value, char *strings, int stringsize)
+{
+	char	*copy;
+	int		ofs;
+
+	if (value >= 0)
+		return value;
+
+	ofs = -1 - value;
+	if (ofs >= stringsize)
+		return 0;
+
+	copy = Hunk_Alloc (strlen(strings + ofs) + 1);
+	strcpy (copy, strings + ofs);
+	return copy - pr_strings;
+}
+
+/*
+===============
+Host_SnapshotSize
+
+Exact size of the snapshot Host_SaveSnapshot writes now, 0 if it can't be
+taken
+===============
+*/
+static int Host_SnapshotSize (void)
+{
+	edict_t	*ent;
+	int		i, j, size, *v;
+
+	if (!Host_SnapshotFindStrings ())
+	{
+		Con_Printf ("Too many saved globals or string fields for a snapshot\n");
+		return 0;
 	}
 
-	if (Cmd_Argc() != 2)
+	size = sizeof(snapheader_t) + snap_numglobals*4 +
+			sv.num_edicts*(sizeof(snapedict_t) + progs->entityfields*4);
+
+	size += 1;		// 0 means no string
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+		if (svp.lightstyles[i])
+			size += strlen (svp.lightstyles[i]) + 1;
+	for (i=0 ; i<snap_numglobalstrings ; i++)
+		size += Host_SnapshotStringSize (((int *)pr_globals)[snap_globals[snap_globalstrings[i]]]);
+	for (i=0 ; i<sv.num_edicts ; i++)
 	{
-		Con_Printf ("save <savename> : save a game\n");
+		ent = EDICT_NUM(i);
+		v = (int *)&ent->v;
+		for (j=0 ; j<snap_numfieldstrings ; j++)
+			size += Host_SnapshotStringSize (v[snap_fieldstrings[j]]);
+	}
+	return size;
+}
+
+/*
+===============
+Host_SaveSnapshot
+
+Writes Host_SnapshotSize bytes to buf
+===============
+*/
+static void Host_SaveSnapshot (byte *buf, int size)
+{
+	snapheader_t	*header;
+	snapedict_t		*rec;
+	edict_t			*ent;
+	byte			*p;
+	int				i, j, *v;
+
+	header = (snapheader_t *)buf;
+	memset (header, 0, sizeof(*header));
+	header->ident = SNAPSHOT_IDENT;
+	header->version = SNAPSHOT_VERSION;
+	header->crc = pr_crc;
+	Host_SavegameComment (header->comment);
+	Q_strncpy (header->mapname, svp.name, sizeof(header->mapname)-1);
+	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
+		header->spawn_parms[i] = svs.clients->spawn_parms[i];
+	header->skill = current_skill;
+	header->time = sv.time;
+	header->numglobals = snap_numglobals;
+	header->entityfields = progs->entityfields;
+	header->numedicts = sv.num_edicts;
+
+	p = (byte *)(header + 1);
+	snap_strings = (char *)p + snap_numglobals*4 +
+			sv.num_edicts*(sizeof(*rec) + progs->entityfields*4);
+	snap_stringsize = 1;
+	snap_strings[0] = 0;
+
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+	{
+		if (!svp.lightstyles[i])
+			continue;
+		j = strlen (svp.lightstyles[i]) + 1;
+		memcpy (snap_strings + snap_stringsize, svp.lightstyles[i], j);
+		header->lightstyles[i] = snap_stringsize;
+		snap_stringsize += j;
+	}
+
+// globals
+	v = (int *)p;
+	for (i=0 ; i<snap_numglobals ; i++)
+		v[i] = ((int *)pr_globals)[snap_globals[i]];
+	for (i=0 ; i<snap_numglobalstrings ; i++)
+		Host_SnapshotString (&v[snap_globalstrings[i]]);
+	p += snap_numglobals*4;
+
+// edicts
+	for (i=0 ; i<sv.num_edicts ; i++)
+	{
+		ent = EDICT_NUM(i);
+		rec = (snapedict_t *)p;
+		rec->free = ent->free;
+		rec->freetime = ent->freetime;
+		p += sizeof(*rec);
+
+		memcpy (p, &ent->v, progs->entityfields*4);
+		v = (int *)p;
+		for (j=0 ; j<snap_numfieldstrings ; j++)
+			Host_SnapshotString (&v[snap_fieldstrings[j]]);
+		p += progs->entityfields*4;
+	}
+
+	header->stringsize = snap_stringsize;
+	if ((byte *)snap_strings + snap_stringsize != buf + size)
+		Sys_Error ("Host_SaveSnapshot: %i bytes, sized for %i",
+				(int)((byte *)snap_strings + snap_stringsize - buf), size);
+	snap_strings = NULL;
+}
+
+/*
+===============
+Host_LoadSnapshot
+
+buf has to stay valid across SV_SpawnServer, so it must not be on the low
+hunk
+===============
+*/
+static void Host_LoadSnapshot (byte *buf, int size)
+{
+	snapheader_t	*header;
+	snapedict_t		*rec;
+	edict_t			*ent;
+	byte			*p;
+	char			*strings;
+	int				i, j, oldnumedicts, *v;
+
+	header = (snapheader_t *)buf;
+	if (size < (int)sizeof(*header) || header->ident != SNAPSHOT_IDENT)
+	{
+		Con_Printf ("Not a savegame snapshot\n");
+		return;
+	}
+	if (header->version != SNAPSHOT_VERSION)
+	{
+		Con_Printf ("Snapshot is version %i, not %i\n", header->version, SNAPSHOT_VERSION);
+		return;
+	}
+	if (size != (int)sizeof(*header) + header->numglobals*4 +
+			header->numedicts*((int)sizeof(*rec) + header->entityfields*4) +
+			header->stringsize || header->numedicts > MAX_EDICTS)
+	{
+		Con_Printf ("Snapshot is truncated\n");
+		return;
+	}
+	if (progs && header->crc != pr_crc)
+	{
+		Con_Printf ("Snapshot was saved with a different progs.dat\n");
 		return;
 	}
 
-	if (strstr(Cmd_Argv(1), ".."))
+	cls.demonum = -1;		// stop demo loop in case this fails
+
+	current_skill = header->skill;
+	Cvar_SetValue ("skill", (float)current_skill);
+
+	CL_Disconnect_f ();
+
+	SV_SpawnServer (header->mapname);
+
+	if (!sv.active)
 	{
-		Con_Printf ("Relative pathnames are not allowed.\n");
+		Con_Printf ("Couldn't load map\n");
 		return;
 	}
-		
-	for (i=0 ; i<svs.maxclients ; i++)
+	if (header->crc != pr_crc || !Host_SnapshotFindStrings () ||
+		header->numglobals != snap_numglobals ||
+		header->entityfields != progs->entityfields ||
+		header->numedicts > sv.max_edicts)
 	{
-		if (svs.clients[i].active && (svs.clients[i].edict->v.health <= 0) )
+		Con_Printf ("Snapshot doesn't match progs.dat\n");
+		return;
+	}
+
+	sv.paused = true;		// pause until all clients connect
+	sv.loadgame = true;
+
+	p = (byte *)(header + 1);
+	strings = (char *)p + header->numglobals*4 +
+			header->numedicts*(sizeof(*rec) + header->entityfields*4);
+
+// the light styles
+	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+	{
+		j = header->lightstyles[i];
+		if (j <= 0 || j >= header->stringsize)
+			continue;
+		svp.lightstyles[i] = Hunk_Alloc (strlen(strings + j)+1);
+		strcpy (svp.lightstyles[i], strings + j);
+	}
+
+// the saved globals, the rest keep what the map spawned; the snapshot is
+// only read, so the quicksave slot can be loaded again
+	v = (int *)p;
+	for (i=0 ; i<snap_numglobals ; i++)
+		((int *)pr_globals)[snap_globals[i]] = v[i];
+	for (i=0 ; i<snap_numglobalstrings ; i++)
+	{
+		j = snap_globals[snap_globalstrings[i]];
+		((int *)pr_globals)[j] = Host_RestoreString (v[snap_globalstrings[i]],
+				strings, header->stringsize);
+	}
+	p += header->numglobals*4;
+
+// the edicts, linked back into the world as they come
+	for (i=0 ; i<header->numedicts ; i++)
+	{
+		ent = EDICT_NUM(i);
+		rec = (snapedict_t *)p;
+		p += sizeof(*rec);
+
+		memcpy (&ent->v, p, header->entityfields*4);
+		p += header->entityfields*4;
+
+		v = (int *)&ent->v;
+		for (j=0 ; j<snap_numfieldstrings ; j++)
+			v[snap_fieldstrings[j]] = Host_RestoreString (v[snap_fieldstrings[j]],
+					strings, header->stringsize);
+
+		ent->free = rec->free;
+		ent->freetime = rec->freetime;
+		if (ent->free)
 		{
-			Con_Printf ("Can't savegame with a dead player\n");
+			ED_UnindexEdict (ent);
+			SV_UnlinkEdict (ent);
+			continue;
+		}
+
+		ED_IndexEdict (ent);
+		SV_LinkEdict (ent, false);
+	}
+
+// whatever the map spawned past the saved edicts is gone
+	oldnumedicts = sv.num_edicts;
+	for (i=header->numedicts ; i<oldnumedicts ; i++)
+	{
+		ent = EDICT_NUM(i);
+		ED_UnindexEdict (ent);
+		SV_UnlinkEdict (ent);
+		memset (&ent->v, 0, progs->entityfields*4);
+		ent->free = true;
+	}
+
+	sv.num_edicts = header->numedicts;
+	sv.time = header->time;
+
+	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
+		svs.clients->spawn_parms[i] = header->spawn_parms[i];
+
+	if (cls.state != ca_dedicated)
+	{
+		CL_EstablishConnection ("local");
+		Host_Reconnect_f ();
+	}
+}
+
+/*
+===============
+Host_SnapshotComment
+
+For the menu: copies the comment of a snapshot savegame, false if h isn't
+one (the file position is left at the start then)
+===============
+*/
+qboolean Host_SnapshotComment (int h, char *comment)
+{
+	snapheader_t	header;
+
+	if (Sys_FileRead (h, &header, sizeof(header)) != sizeof(header) ||
+		header.ident != SNAPSHOT_IDENT)
+	{
+		Sys_FileSeek (h, 0);
+		return false;
+	}
+
+	memcpy (comment, header.comment, SAVEGAME_COMMENT_LENGTH);
+	comment[SAVEGAME_COMMENT_LENGTH] = 0;
+	return true;
+}
+
+/*
+===============
+Host_QuickslotValid
+
+The slot sits on the high hunk; an aborted frame frees back to the mark it
+started with, which can take the slot with it
+===============
+*/
+static qboolean Host_QuickslotValid (void)
+{
+	if (sv_quickslot && Hunk_HighMark () < sv_quicktop)
+	{
+		sv_quickslot = NULL;
+		sv_quickslotsize = sv_quicksize = 0;
+	}
+	return sv_quickslot != NULL;
+}
+
+/*
+===============
+Host_Quicksave_f
+
+snapshot into the PSRAM slot, no SD access
+===============
+*/
+void Host_Quicksave_f (void)
+{
+	int		size;
+
+	if (cmd_source != src_command)
+		return;
+
+	if (!Host_CanSavegame ())
+		return;
+
+	size = Host_SnapshotSize ();
+	if (!size)
+		return;
+
+// the slot only grows, and can only be given back while it is on top
+	if (Host_QuickslotValid () && size > sv_quickslotsize &&
+		Hunk_HighMark () == sv_quicktop)
+	{
+		Hunk_FreeToHighMark (sv_quickmark);
+		sv_quickslot = NULL;
+	}
+	if (!sv_quickslot || size > sv_quickslotsize)
+	{
+		sv_quicksize = 0;
+		sv_quickmark = Hunk_HighMark ();
+		sv_quickslot = Hunk_HighAllocName (size, "quicksav");
+		if (!sv_quickslot)
+		{
+			Con_Printf ("No room for a %i byte quicksave\n", size);
 			return;
 		}
+		sv_quickslotsize = size;
+		sv_quicktop = Hunk_HighMark ();
 	}
 
-	sprintf (name, "%s/%s", com_gamedir, Cmd_Argv(1));
-	COM_DefaultExtension (name, ".sav");
-	
-	Con_Printf ("Saving game to %s...\n", name);
-	int h = Sys_FileOpenWrite(name);
-	f = Sys_File(h);
-	if (!f)
+	Host_SaveSnapshot (sv_quickslot, size);
+	sv_quicksize = size;
+	Con_Printf ("Quicksaved (%i bytes)\n", size);
+}
+
+/*
+===============
+Host_Quickload_f
+===============
+*/
+void Host_Quickload_f (void)
+{
+	if (cmd_source != src_command)
+		return;
+
+	if (!Host_QuickslotValid () || !sv_quicksize)
 	{
-		Con_Printf ("ERROR: couldn't open.\n");
+		Con_Printf ("No quicksave\n");
 		return;
 	}
-	
-	Sys_Fprintf (f, "%i\n", SAVEGAME_VERSION);
-	Host_SavegameComment (comment);
-	Sys_Fprintf (f, "%s\n", comment);
-	for (i=0 ; i<NUM_SPAWN_PARMS ; i++)
-		Sys_Fprintf (f, "%f\n", svs.clients->spawn_parms[i]);
-	Sys_Fprintf (f, "%d\n", current_skill);
-	Sys_Fprintf (f, "%s\n", svp.name);
-	Sys_Fprintf (f, "%f\n",sv.time);
 
-// write the light styles
+// SV_SpawnServer doesn't touch the high hunk, so it can be loaded in place
+// and loaded again later
+	Host_LoadSnapshot (sv_quickslot, sv_quicksize);
+}
 
-	for (i=0 ; i<MAX_LIGHTSTYLES ; i++)
+/*
+===============
+Host_Savegame_f
+===============
+*/
+void Host_Savegame_f (void)
+{
+	char	name[256];
+	byte	*buf;
+	int		size;
+
+	if (cmd_source != src_command)
+		return;
+
+	if (!Host_CanSavegame ())
+		return;
+
+	if (Cmd_Argc() != 2)
 	{
-		if (svp.lightstyles[i])
-			Sys_Fprintf (f, "%s\n", svp.lightstyles[i]);
-		else
-			Sys_Fprintf (f,"m\n");
+		Con_Printf ("save <savename> : save a game\n");
+		return;
 	}
 
+	if (strstr(Cmd_Argv(1), ".."))
+	{
+		Con_Printf ("Relative pathnames are not allowed.\n");
+		return;
+	}
 
-	ED_WriteGlobals (f);
-	for (i=0 ; i<sv.num_edicts ; i++)
+	sprintf (name, "%s/%s", com_gamedir, Cmd_Argv(1));
+	COM_DefaultExtension (name, ".sav");
+
+	size = Host_SnapshotSize ();
+	if (!size)
+		return;
+	buf = Hunk_TempAlloc (size);
+	Host_SaveSnapshot (buf, size);
+	
+	Con_Printf ("Saving game to %s...\n", name);
+	int h = Sys_FileOpenWrite(name);
+	if (h == -1)
 	{
-		ED_Write (f, EDICT_NUM(i));
-		f_sync (f);
+		Con_Printf ("ERROR: couldn't open.\n");
+		return;
 	}
+
+	if (Sys_FileWrite (h, buf, size) != size)
+		Con_Printf ("ERROR: short write.\n");
 	Sys_FileClose(h);
 	Con_Printf ("done.\n");
 }
@@ -530,6 +1056,8 @@ void Host_Loadgame_f (void)
 	int		entnum;
 	int		version;
 	float			spawn_parms[NUM_SPAWN_PARMS];
+	byte	*buf;
+	int		mark;
 
 	if (cmd_source != src_command)
 		return;
@@ -551,7 +1079,7 @@ void Host_Loadgame_f (void)
 
 	Con_Printf ("Loading game from %s...\n", name);
 	int h;
-	Sys_FileOpenRead(name, &h);
+	int len = Sys_FileOpenRead(name, &h);
 	f = Sys_File(h);
 	if (!f)
 	{
@@ -559,6 +1087,29 @@ void Host_Loadgame_f (void)
 		return;
 	}
 
+// snapshots are read in one go, anything else is the old text format
+	version = 0;
+	Sys_FileRead (h, &version, sizeof(version));
+	if (version == SNAPSHOT_IDENT)
+	{
+	// on the high hunk, SV_SpawnServer only clears the low one
+		mark = Hunk_HighMark ();
+		buf = Hunk_HighAllocName (len, "loadgame");
+		if (!buf)
+		{
+			Sys_FileClose (h);
+			Con_Printf ("Savegame is too big\n");
+			return;
+		}
+		*(int *)buf = version;
+		Sys_FileRead (h, buf + sizeof(version), len - sizeof(version));
+		Sys_FileClose (h);
+		Host_LoadSnapshot (buf, len);
+		Hunk_FreeToHighMark (mark);
+		return;
+	}
+	Sys_FileSeek (h, 0);
+
 	Sys_Fscanf (f, "%i\n", &version);
 	if (version != SAVEGAME_VERSION)
 	{
@@ -1667,6 +2218,8 @@ void Host_InitCommands (void)
 	Cmd_AddCommand ("ping", Host_Ping_f);
 	Cmd_AddCommand ("load", Host_Loadgame_f);
 	Cmd_AddCommand ("save", Host_Savegame_f);
+	Cmd_AddCommand ("quicksave", Host_Quicksave_f);
+	Cmd_AddCommand ("quickload", Host_Quickload_f);
 	Cmd_AddCommand ("give", Host_Give_f);
 
 	Cmd_AddCommand ("startdemos", Host_Startdemos_f);
@@ -0,0 +1,850 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// kbench.c -- host microbenchmark for the rasterizer kernels
+//
+// usage: kbench <capture.kcp> [-iters n] [-kernel name]
+//
+// replays a frame recorded with "kcapture" through D_DrawSpans8,
+// D_DrawZSpans, Turbulent8, D_DrawSkyScans8, D_PolysetDraw,
+// R_DrawSurfaceBlocks and S_PaintSfxChannel, and prints the time per
+// pixel and per span (triangle, block or channel) along with a checksum of
+// what the first pass produced. An optimized kernel must reproduce the
+// checksum of the reference one on the same capture. The mixer is also
+// run with a growing number of voices to see where core 1 runs out.
+
+#include <time.h>
+
+#include "quakedef.h"
+#include "r_local.h"
+#include "d_local.h"
+#include "kcapture.h"
+#include "quakegeneric.h"
+
+#define KB_SFXFRAMES	(512 / SFX_DOWNSAMPLE_RATIO)	// AUDIO_BUFFER_SIZE in mixer.cpp
+#define KB_MAXVOICES	64
+
+extern unsigned	blocklights[18*18];
+
+typedef struct
+{
+	kcapspans_t	h;
+	byte		*tex;
+	espan_t		*spans;
+	int			pixels;
+} kbspans_t;
+
+typedef struct
+{
+	kcapsky_t	h;
+	byte		*top, *bottom;
+	espan_t		*spans;
+	int			pixels;
+} kbsky_t;
+
+typedef struct
+{
+	kcapalias_t	h;
+	byte		*skin;
+	mtriangle_t	*triangles;
+	finalvert_t	*verts;
+	byte		*colormap;
+	int			pixels;		// approximate, projected area of the front faces
+} kbalias_t;
+
+typedef struct
+{
+	kcapsurf_t	h;
+	texture_t	*texture;
+	msurface_t	surf;
+	unsigned	*light;
+} kbsurf_t;
+
+typedef struct
+{
+	kcapsfx_t	h;
+	sfx_t		sfx;
+	sfxcache_t	*sc;
+} kbsfx_t;
+
+typedef struct
+{
+	double		ns;
+	int			pixels;		// per pass
+	int			spans;		// per pass
+	unsigned	crc;
+} kbresult_t;
+
+static kcapframe_t	kb_frame;
+static byte		*kb_colormap;
+static byte		*kb_viewbuffer;
+static short	*kb_zbuffer;
+static int32_t	kb_mixbuffer[KB_SFXFRAMES*2];
+
+static kbspans_t	*kb_spans;
+static int			kb_numspans;
+static kbspans_t	*kb_turbs;
+static int			kb_numturbs;
+static kbsky_t		*kb_skies;
+static int			kb_numskies;
+static kbalias_t	*kb_aliases;
+static int			kb_numaliases;
+static kbsurf_t		*kb_surfs;
+static int			kb_numsurfs;
+static kbsfx_t		*kb_sfxs;
+static int			kb_numsfxs;
+
+static int		kb_iters = 100;
+static char		*kb_kernel;
+
+/*
+==============================================================================
+
+HOST BACKEND STUBS
+
+==============================================================================
+*/
+
+void QG_Init (void) {}
+void QG_Quit (void) {}
+void QG_DrawFrame (void *pixels) {}
+void QG_DrawFrameRects (void *pixels, const qg_rect_t *rects, int numrects) {}
+void QG_SetPalette (unsigned char palette[768]) {}
+int QG_GetKey (int *down, int *key) { return 0; }
+void QG_GetMouseMove (int *x, int *y) { *x = *y = 0; }
+void QG_GetJoyAxes (float *axes) { *axes = 0; }
+
+/*
+==============================================================================
+
+LOADING
+
+==============================================================================
+*/
+
+static double KB_Nanoseconds (void)
+{
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static unsigned KB_Checksum (unsigned crc, void *data, int count)
+{
+	byte	*p = data;
+
+	while (count--)
+	{
+		crc ^= *p++;
+		crc *= 16777619;	// FNV-1a
+	}
+	return crc;
+}
+
+static void *KB_Alloc (int size)
+{
+	void	*p;
+
+	p = calloc (1, size > 0 ? size : 1);
+	if (!p)
+		Sys_Error ("KB_Alloc: failed on %i bytes", size);
+	return p;
+}
+
+// copies count bytes out of the record and advances, so every array ends
+// up aligned no matter where it sat in the file
+static void *KB_Take (byte **data, int *left, int count)
+{
+	void	*p;
+
+	if (count < 0 || count > *left)
+		Sys_Error ("KB_Take: record truncated");
+	p = KB_Alloc (count);
+	memcpy (p, *data, count);
+	*data += count;
+	*left -= count;
+	return p;
+}
+
+static void KB_TakeFixed (void *out, byte **data, int *left, int count)
+{
+	if (count > *left)
+		Sys_Error ("KB_TakeFixed: record truncated");
+	memcpy (out, *data, count);
+	*data += count;
+	*left -= count;
+}
+
+static espan_t *KB_TakeSpans (byte **data, int *left, int numspans, int *pixels)
+{
+	kcapspan_t	*in;
+	espan_t		*out;
+	int			i;
+
+	in = KB_Take (data, left, numspans*sizeof(kcapspan_t));
+	out = KB_Alloc (numspans*sizeof(espan_t));
+	*pixels = 0;
+	for (i=0 ; i<numspans ; i++)
+	{
+		out[i].u = in[i].u;
+		out[i].v = in[i].v;
+		out[i].count = in[i].count;
+		out[i].pnext = (i+1 < numspans) ? &out[i+1] : NULL;
+		*pixels += in[i].count;
+	}
+	free (in);
+	return out;
+}
+
+static void KB_ParseSpans (kbspans_t *k, byte *data, int left)
+{
+	KB_TakeFixed (&k->h, &data, &left, sizeof(k->h));
+	k->tex = KB_Take (&data, &left, k->h.texrows * k->h.cachewidth);
+	k->spans = KB_TakeSpans (&data, &left, k->h.numspans, &k->pixels);
+}
+
+static void KB_ParseSky (kbsky_t *k, byte *data, int left)
+{
+	KB_TakeFixed (&k->h, &data, &left, sizeof(k->h));
+	k->top = KB_Take (&data, &left, 128*128);
+	k->bottom = KB_Take (&data, &left, 128*128);
+	k->spans = KB_TakeSpans (&data, &left, k->h.numspans, &k->pixels);
+}
+
+static void KB_ParseAlias (kbalias_t *k, byte *data, int left)
+{
+	int			i;
+	finalvert_t	*v0, *v1, *v2;
+	int			area;
+
+	KB_TakeFixed (&k->h, &data, &left, sizeof(k->h));
+	k->skin = KB_Take (&data, &left, k->h.skinwidth * k->h.skinheight);
+	k->triangles = KB_Take (&data, &left, k->h.numtriangles*sizeof(mtriangle_t));
+	k->verts = KB_Take (&data, &left, k->h.numverts*sizeof(finalvert_t));
+	k->colormap = k->h.owncolormap ? KB_Take (&data, &left, 256*VID_GRADES) : NULL;
+
+// same facing test as D_DrawNonSubdiv
+	k->pixels = 0;
+	for (i=0 ; i<k->h.numtriangles ; i++)
+	{
+		v0 = k->verts + k->triangles[i].vertindex[0];
+		v1 = k->verts + k->triangles[i].vertindex[1];
+		v2 = k->verts + k->triangles[i].vertindex[2];
+		area = (v0->v[1] - v1->v[1]) * (v0->v[0] - v2->v[0]) -
+			   (v0->v[0] - v1->v[0]) * (v0->v[1] - v2->v[1]);
+		if (area < 0)
+			k->pixels += -area / 2;
+	}
+}
+
+static void KB_ParseSurf (kbsurf_t *k, byte *data, int left)
+{
+	int		texbytes;
+
+	KB_TakeFixed (&k->h, &data, &left, sizeof(k->h));
+
+	texbytes = (k->h.texwidth >> k->h.surfmip) * (k->h.texheight >> k->h.surfmip);
+	k->texture = KB_Alloc (sizeof(texture_t) + texbytes);
+	k->texture->width = k->h.texwidth;
+	k->texture->height = k->h.texheight;
+	k->texture->offsets[k->h.surfmip] = sizeof(texture_t);
+	k->texture->mips[k->h.surfmip] = (byte *)k->texture + sizeof(texture_t);
+	KB_TakeFixed ((byte *)k->texture + sizeof(texture_t), &data, &left, texbytes);
+
+	if (k->h.lightsize > 18*18)
+		Sys_Error ("KB_ParseSurf: lightmap too large");
+	k->light = KB_Take (&data, &left, k->h.lightsize*sizeof(unsigned));
+
+	k->surf.texturemins[0] = k->h.texturemins[0];
+	k->surf.texturemins[1] = k->h.texturemins[1];
+	k->surf.extents[0] = k->h.extents[0];
+	k->surf.extents[1] = k->h.extents[1];
+}
+
+static void KB_ParseSfx (kbsfx_t *k, byte *data, int left)
+{
+	int		bytes;
+
+	KB_TakeFixed (&k->h, &data, &left, sizeof(k->h));
+	bytes = k->h.adpcm ? SFX_ADPCM_BYTES(k->h.length) : k->h.length;
+	k->sc = KB_Alloc (sizeof(sfxcache_t) + bytes);
+	k->sc->length = k->h.length;
+	k->sc->loopstart = k->h.loopstart;
+	k->sc->width = 1;
+	k->sc->adpcm = k->h.adpcm;
+	KB_TakeFixed (k->sc->data, &data, &left, bytes);
+}
+
+/*
+===============
+KB_LoadCapture
+
+two passes over the records: count per kind, then parse
+===============
+*/
+static void KB_LoadCapture (char *name)
+{
+	FILE			*f;
+	byte			*buf, *p, *end;
+	int				len, pass;
+	kcapheader_t	header;
+	kcaprecord_t	rec;
+
+	f = fopen (name, "rb");
+	if (!f)
+		Sys_Error ("couldn't open %s", name);
+	fseek (f, 0, SEEK_END);
+	len = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	buf = KB_Alloc (len);
+	if (fread (buf, 1, len, f) != len)
+		Sys_Error ("couldn't read %s", name);
+	fclose (f);
+
+	if (len < sizeof(header))
+		Sys_Error ("%s is not a kernel capture", name);
+	memcpy (&header, buf, sizeof(header));
+	if (header.ident != KCAP_IDENT)
+		Sys_Error ("%s is not a kernel capture", name);
+	if (header.version != KCAP_VERSION)
+		Sys_Error ("%s is version %i, not %i", name, header.version, KCAP_VERSION);
+
+	end = buf + len;
+	for (pass=0 ; pass<2 ; pass++)
+	{
+		if (pass)
+		{
+			kb_spans = KB_Alloc (kb_numspans*sizeof(*kb_spans));
+			kb_turbs = KB_Alloc (kb_numturbs*sizeof(*kb_turbs));
+			kb_skies = KB_Alloc (kb_numskies*sizeof(*kb_skies));
+			kb_aliases = KB_Alloc (kb_numaliases*sizeof(*kb_aliases));
+			kb_surfs = KB_Alloc (kb_numsurfs*sizeof(*kb_surfs));
+			kb_sfxs = KB_Alloc (kb_numsfxs*sizeof(*kb_sfxs));
+		}
+		kb_numspans = kb_numturbs = kb_numskies = 0;
+		kb_numaliases = kb_numsurfs = kb_numsfxs = 0;
+
+		for (p = buf + sizeof(header) ; p < end ; p += rec.size)
+		{
+			if (end - p < sizeof(rec))
+				Sys_Error ("%s: truncated record header", name);
+			memcpy (&rec, p, sizeof(rec));
+			p += sizeof(rec);
+			if (rec.size < 0 || rec.size > end - p)
+				Sys_Error ("%s: truncated record", name);
+
+			switch (rec.kind)
+			{
+			case KC_FRAME:
+				if (pass)
+				{
+					int left = rec.size;
+					byte *d = p;
+					KB_TakeFixed (&kb_frame, &d, &left, sizeof(kb_frame));
+					kb_colormap = KB_Take (&d, &left, 256*VID_GRADES);
+				}
+				break;
+			case KC_SPANS:
+				if (pass)
+					KB_ParseSpans (&kb_spans[kb_numspans], p, rec.size);
+				kb_numspans++;
+				break;
+			case KC_TURB:
+				if (pass)
+					KB_ParseSpans (&kb_turbs[kb_numturbs], p, rec.size);
+				kb_numturbs++;
+				break;
+			case KC_SKY:
+				if (pass)
+					KB_ParseSky (&kb_skies[kb_numskies], p, rec.size);
+				kb_numskies++;
+				break;
+			case KC_ALIAS:
+				if (pass)
+					KB_ParseAlias (&kb_aliases[kb_numaliases], p, rec.size);
+				kb_numaliases++;
+				break;
+			case KC_SURF:
+				if (pass)
+					KB_ParseSurf (&kb_surfs[kb_numsurfs], p, rec.size);
+				kb_numsurfs++;
+				break;
+			case KC_SFX:
+				if (pass)
+					KB_ParseSfx (&kb_sfxs[kb_numsfxs], p, rec.size);
+				kb_numsfxs++;
+				break;
+			default:
+				printf ("skipping unknown record kind %i\n", rec.kind);
+				break;
+			}
+		}
+	}
+
+	free (buf);
+
+	if (!kb_colormap)
+		Sys_Error ("%s: no frame record", name);
+}
+
+/*
+===============
+KB_SetupFrame
+
+the minimum of the refresh state the kernels read
+===============
+*/
+static void KB_SetupFrame (void)
+{
+	if (kb_frame.width <= 0 || kb_frame.height <= 0 ||
+		kb_frame.width > MAXWIDTH || kb_frame.height > MAXHEIGHT ||
+		kb_frame.rowbytes < kb_frame.width)
+		Sys_Error ("bad frame size %ix%i", kb_frame.width, kb_frame.height);
+
+	kb_viewbuffer = KB_Alloc (kb_frame.rowbytes * kb_frame.height);
+	kb_zbuffer = KB_Alloc (kb_frame.width * kb_frame.height * sizeof(short));
+
+	vid.width = kb_frame.width;
+	vid.height = kb_frame.height;
+	vid.rowbytes = kb_frame.rowbytes;
+	vid.buffer = kb_viewbuffer;
+	vid.colormap = kb_colormap;
+
+	screenwidth = vid.rowbytes;
+	d_viewbuffer = kb_viewbuffer;
+	d_pzbuffer = kb_zbuffer;
+	d_zwidth = vid.width;
+	d_zrowbytes = vid.width * 2;
+
+	r_refdef.vrect.x = r_refdef.vrect.y = 0;
+	r_refdef.vrect.width = vid.width;
+	r_refdef.vrect.height = vid.height;
+	r_refdef.vrectright = vid.width;
+	r_refdef.vrectbottom = vid.height;
+
+	cl.time = kb_frame.time;
+
+	R_InitTurb ();
+}
+
+static void KB_ClearBuffers (void)
+{
+	memset (kb_viewbuffer, 0, kb_frame.rowbytes * kb_frame.height);
+	memset (kb_zbuffer, 0, kb_frame.width * kb_frame.height * sizeof(short));
+}
+
+/*
+==============================================================================
+
+KERNELS
+
+==============================================================================
+*/
+
+static void KB_SetSpanState (kcapspans_t *h, byte *tex)
+{
+	d_sdivzstepu = h->sdivzstepu;
+	d_tdivzstepu = h->tdivzstepu;
+	d_zistepu = h->zistepu;
+	d_sdivzstepv = h->sdivzstepv;
+	d_tdivzstepv = h->tdivzstepv;
+	d_zistepv = h->zistepv;
+	d_sdivzorigin = h->sdivzorigin;
+	d_tdivzorigin = h->tdivzorigin;
+	d_ziorigin = h->ziorigin;
+	sadjust = h->sadjust;
+	tadjust = h->tadjust;
+	bbextents = h->bbextents;
+	bbextentt = h->bbextentt;
+	cacheblock = (pixel_t *)tex;
+	cachewidth = h->cachewidth;
+	cl.time = h->time;
+}
+
+static void KB_SetSkyState (kcapsky_t *h, byte *top, byte *bottom)
+{
+	r_refdef.vrect.width = h->vrectwidth;
+	r_refdef.vrect.height = h->vrectheight;
+	VectorCopy (h->vpn, vpn);
+	VectorCopy (h->vright, vright);
+	VectorCopy (h->vup, vup);
+	skytime = h->skytime;
+	skyspeed = h->skyspeed;
+	r_skytop = top;
+	r_skybottom = bottom;
+	d_zistepu = h->zistepu;
+	d_zistepv = h->zistepv;
+	d_ziorigin = h->ziorigin;
+}
+
+static void KB_DrawSpans (kbspans_t *list, int count, kbresult_t *r, void (*kernel)(espan_t *))
+{
+	int		it, i;
+	double	t;
+
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		if (it == 0)
+			KB_ClearBuffers ();
+		for (i=0 ; i<count ; i++)
+		{
+			KB_SetSpanState (&list[i].h, list[i].tex);
+			t = KB_Nanoseconds ();
+			kernel (list[i].spans);
+			r->ns += KB_Nanoseconds () - t;
+			if (it == 0)
+			{
+				r->pixels += list[i].pixels;
+				r->spans += list[i].h.numspans;
+			}
+		}
+		if (it == 0)
+			r->crc = KB_Checksum (2166136261u, kb_viewbuffer, kb_frame.rowbytes * kb_frame.height);
+	}
+}
+
+static void KB_Spans (kbresult_t *r)
+{
+	KB_DrawSpans (kb_spans, kb_numspans, r, D_DrawSpans8);
+}
+
+static void KB_Turb (kbresult_t *r)
+{
+	KB_DrawSpans (kb_turbs, kb_numturbs, r, Turbulent8);
+}
+
+static void KB_Sky (kbresult_t *r)
+{
+	int		it, i;
+	double	t;
+
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		if (it == 0)
+			KB_ClearBuffers ();
+		for (i=0 ; i<kb_numskies ; i++)
+		{
+			KB_SetSkyState (&kb_skies[i].h, kb_skies[i].top, kb_skies[i].bottom);
+			t = KB_Nanoseconds ();
+			D_DrawSkyScans8 (kb_skies[i].spans);
+			r->ns += KB_Nanoseconds () - t;
+			if (it == 0)
+			{
+				r->pixels += kb_skies[i].pixels;
+				r->spans += kb_skies[i].h.numspans;
+			}
+		}
+		if (it == 0)
+			r->crc = KB_Checksum (2166136261u, kb_viewbuffer, kb_frame.rowbytes * kb_frame.height);
+	}
+	r_refdef.vrect.width = vid.width;
+	r_refdef.vrect.height = vid.height;
+}
+
+// every span list of the frame goes through the z writer
+static void KB_ZSpans (kbresult_t *r)
+{
+	int		it, i;
+	double	t;
+
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		if (it == 0)
+			KB_ClearBuffers ();
+		for (i=0 ; i<kb_numspans + kb_numturbs + kb_numskies ; i++)
+		{
+			kbspans_t	*k;
+			espan_t		*spans;
+
+			if (i < kb_numspans + kb_numturbs)
+			{
+				k = i < kb_numspans ? &kb_spans[i] : &kb_turbs[i - kb_numspans];
+				KB_SetSpanState (&k->h, k->tex);
+				spans = k->spans;
+				if (it == 0)
+				{
+					r->pixels += k->pixels;
+					r->spans += k->h.numspans;
+				}
+			}
+			else
+			{
+				kbsky_t	*sk = &kb_skies[i - kb_numspans - kb_numturbs];
+
+				KB_SetSkyState (&sk->h, sk->top, sk->bottom);
+				spans = sk->spans;
+				if (it == 0)
+				{
+					r->pixels += sk->pixels;
+					r->spans += sk->h.numspans;
+				}
+			}
+			t = KB_Nanoseconds ();
+			D_DrawZSpans (spans);
+			r->ns += KB_Nanoseconds () - t;
+		}
+		if (it == 0)
+			r->crc = KB_Checksum (2166136261u, kb_zbuffer, kb_frame.width * kb_frame.height * sizeof(short));
+	}
+	r_refdef.vrect.width = vid.width;
+	r_refdef.vrect.height = vid.height;
+}
+
+static void KB_Alias (kbresult_t *r)
+{
+	int			it, i;
+	double		t;
+	kbalias_t	*k;
+	unsigned	crc;
+
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		if (it == 0)
+			KB_ClearBuffers ();
+		for (i=0, k=kb_aliases ; i<kb_numaliases ; i++, k++)
+		{
+			r_affinetridesc.pskin = k->skin;
+			r_affinetridesc.skinwidth = k->h.skinwidth;
+			r_affinetridesc.skinheight = k->h.skinheight;
+			r_affinetridesc.ptriangles = k->triangles;
+			r_affinetridesc.pfinalverts = k->verts;
+			r_affinetridesc.numtriangles = k->h.numtriangles;
+			r_affinetridesc.drawtype = k->h.drawtype;
+			r_affinetridesc.seamfixupX16 = k->h.seamfixupX16;
+			r_refdef.vrectright = k->h.vrectright;
+			r_refdef.vrectbottom = k->h.vrectbottom;
+			acolormap = k->colormap ? k->colormap : kb_colormap;
+			if (k->h.drawtype)
+				D_PolysetUpdateTables ();
+
+			t = KB_Nanoseconds ();
+			D_PolysetDraw ();
+			r->ns += KB_Nanoseconds () - t;
+			if (it == 0)
+			{
+				r->pixels += k->pixels;
+				r->spans += k->h.numtriangles;
+			}
+		}
+		if (it == 0)
+		{
+			crc = KB_Checksum (2166136261u, kb_viewbuffer, kb_frame.rowbytes * kb_frame.height);
+			r->crc = KB_Checksum (crc, kb_zbuffer, kb_frame.width * kb_frame.height * sizeof(short));
+		}
+	}
+	r_refdef.vrectright = vid.width;
+	r_refdef.vrectbottom = vid.height;
+}
+
+static void KB_Surf (kbresult_t *r)
+{
+	int			it, i, size, maxsize;
+	double		t;
+	kbsurf_t	*k;
+	byte		*out;
+
+	maxsize = 0;
+	for (i=0, k=kb_surfs ; i<kb_numsurfs ; i++, k++)
+	{
+		size = k->h.rowbytes * k->h.surfheight;
+		if (size > maxsize)
+			maxsize = size;
+	}
+	out = KB_Alloc (maxsize);
+
+	r->crc = 2166136261u;
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		for (i=0, k=kb_surfs ; i<kb_numsurfs ; i++, k++)
+		{
+			memcpy (blocklights, k->light, k->h.lightsize*sizeof(unsigned));
+			r_drawsurf.surf = &k->surf;
+			r_drawsurf.texture = k->texture;
+			r_drawsurf.surfmip = k->h.surfmip;
+			r_drawsurf.surfwidth = k->h.surfwidth;
+			r_drawsurf.surfheight = k->h.surfheight;
+			r_drawsurf.rowbytes = k->h.rowbytes;
+			r_drawsurf.surfdat = (pixel_t *)out;
+
+			t = KB_Nanoseconds ();
+			R_DrawSurfaceBlocks ();
+			r->ns += KB_Nanoseconds () - t;
+			if (it == 0)
+			{
+				r->pixels += k->h.surfwidth * k->h.surfheight;
+				r->spans += (k->h.surfwidth >> (4 - k->h.surfmip)) *
+							(k->h.surfheight >> (4 - k->h.surfmip));
+				r->crc = KB_Checksum (r->crc, out, k->h.rowbytes * k->h.surfheight);
+			}
+		}
+	}
+	free (out);
+}
+
+static void KB_Sfx (kbresult_t *r)
+{
+	int			it, i;
+	double		t;
+	kbsfx_t		*k;
+	channel_t	ch;
+
+	for (it=0 ; it<kb_iters ; it++)
+	{
+		memset (kb_mixbuffer, 0, sizeof(kb_mixbuffer));
+		for (i=0, k=kb_sfxs ; i<kb_numsfxs ; i++, k++)
+		{
+			memset (&ch, 0, sizeof(ch));
+			ch.sfx = &k->sfx;
+			ch.leftvol = k->h.leftvol;
+			ch.rightvol = k->h.rightvol;
+			ch.pos = k->h.pos;
+			ch.end = k->h.end;
+
+			t = KB_Nanoseconds ();
+			S_PaintSfxChannel (kb_mixbuffer, &ch, k->sc, KB_SFXFRAMES, 0);
+			r->ns += KB_Nanoseconds () - t;
+			if (it == 0)
+			{
+				r->pixels += KB_SFXFRAMES;
+				r->spans++;
+			}
+		}
+		if (it == 0)
+			r->crc = KB_Checksum (2166136261u, kb_mixbuffer, sizeof(kb_mixbuffer));
+	}
+}
+
+/*
+===============
+KB_SfxScaling
+
+mixes 1, 2, 4 .. KB_MAXVOICES voices, cycling through the captured
+channels, and reports the cost of one output buffer against its playback
+time, which is what core 1 has to stay under
+===============
+*/
+static void KB_SfxScaling (void)
+{
+	int			it, i, voices;
+	double		t, ns, budget;
+	kbsfx_t		*k;
+	channel_t	ch;
+
+	if (!kb_numsfxs)
+		return;
+
+	budget = 1e9 * KB_SFXFRAMES / (SFX_OUTPUT_RATE / SFX_DOWNSAMPLE_RATIO);
+	printf ("voice scaling, %i frames at %i Hz = %.0f us per buffer\n",
+			KB_SFXFRAMES, SFX_OUTPUT_RATE / SFX_DOWNSAMPLE_RATIO, budget / 1000);
+
+	for (voices=1 ; voices<=KB_MAXVOICES ; voices<<=1)
+	{
+		ns = 0;
+		for (it=0 ; it<kb_iters ; it++)
+		{
+			memset (kb_mixbuffer, 0, sizeof(kb_mixbuffer));
+			t = KB_Nanoseconds ();
+			for (i=0 ; i<voices ; i++)
+			{
+				k = &kb_sfxs[i % kb_numsfxs];
+				memset (&ch, 0, sizeof(ch));
+				ch.sfx = &k->sfx;
+				ch.leftvol = k->h.leftvol;
+				ch.rightvol = k->h.rightvol;
+				ch.pos = k->h.pos;
+				ch.end = k->h.end;
+				S_PaintSfxChannel (kb_mixbuffer, &ch, k->sc, KB_SFXFRAMES, 0);
+			}
+			ns += KB_Nanoseconds () - t;
+		}
+		ns /= kb_iters;
+		printf ("%3i voices %9.2f us/buffer %8.1f ns/voice %6.2f%% of budget\n",
+				voices, ns / 1000, ns / voices, 100 * ns / budget);
+	}
+}
+
+typedef struct
+{
+	char	*name;
+	char	*pixel, *span;
+	void	(*run) (kbresult_t *r);
+} kbkernel_t;
+
+static kbkernel_t	kb_kernels[] = {
+	{"D_DrawSpans8", "px", "span", KB_Spans},
+	{"D_DrawZSpans", "px", "span", KB_ZSpans},
+	{"Turbulent8", "px", "span", KB_Turb},
+	{"D_DrawSkyScans8", "px", "span", KB_Sky},
+	{"D_PolysetDraw", "px", "tri", KB_Alias},
+	{"R_DrawSurfaceBlocks", "px", "block", KB_Surf},
+	{"S_PaintSfxChannel", "smp", "chan", KB_Sfx},
+	{NULL}
+};
+
+int main (int argc, char *argv[])
+{
+	kbkernel_t	*k;
+	kbresult_t	r;
+	double		passes;
+	int			i;
+
+	if (argc < 2)
+	{
+		printf ("usage: kbench <capture.kcp> [-iters n] [-kernel name]\n");
+		return 1;
+	}
+	for (i=2 ; i<argc ; i++)
+	{
+		if (!strcmp (argv[i], "-iters") && i+1 < argc)
+			kb_iters = atoi (argv[++i]);
+		else if (!strcmp (argv[i], "-kernel") && i+1 < argc)
+			kb_kernel = argv[++i];
+	}
+	if (kb_iters < 1)
+		kb_iters = 1;
+
+	KB_LoadCapture (argv[1]);
+	KB_SetupFrame ();
+
+	printf ("%s: %ix%i, %i spans %i turb %i sky %i alias %i surf %i sfx, %i iterations\n",
+			argv[1], kb_frame.width, kb_frame.height, kb_numspans, kb_numturbs,
+			kb_numskies, kb_numaliases, kb_numsurfs, kb_numsfxs, kb_iters);
+
+	for (k=kb_kernels ; k->name ; k++)
+	{
+		if (kb_kernel && strcmp (kb_kernel, k->name))
+			continue;
+
+		memset (&r, 0, sizeof(r));
+		k->run (&r);
+
+		passes = kb_iters;
+		printf ("%-20s %8i %-3s %6i %-5s %8.2f ns/%-3s %9.1f ns/%-5s crc %08x\n",
+				k->name, r.pixels, k->pixel, r.spans, k->span,
+				r.pixels ? r.ns / passes / r.pixels : 0.0, k->pixel,
+				r.spans ? r.ns / passes / r.spans : 0.0, k->span,
+				r.crc);
+	}
+
+	if (!kb_kernel || !strcmp (kb_kernel, "S_PaintSfxChannel"))
+		KB_SfxScaling ();
+
+	return 0;
+}
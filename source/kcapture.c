@@ -0,0 +1,365 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// kcapture.c -- records the inputs of the rasterizer kernels for one frame
+//
+// "kcapture <name>" arms the capture, the next rendered frame writes every
+// span list, alias triangle batch, surface block and mixer channel it sees
+// to <gamedir>/<name>.kcp, which kbench replays on the host.
+
+#include "quakedef.h"
+#include "r_local.h"
+#include "d_local.h"
+#include "kcapture.h"
+
+extern unsigned	blocklights[18*18];
+
+qboolean	kcap_active;
+
+static qboolean	kcap_pending;
+static char		kcap_name[MAX_OSPATH];
+static int		kcap_file = -1;
+static int		kcap_records;
+static int		kcap_bytes;
+
+static void KCap_Write (void *data, int count)
+{
+	if (count <= 0)
+		return;
+	Sys_FileWrite (kcap_file, data, count);
+	kcap_bytes += count;
+}
+
+/*
+===============
+KCap_Record
+
+Writes a record header and its fixed part; the variable parts follow
+with KCap_Write and must add up to size.
+===============
+*/
+static void KCap_Record (int kind, int size, void *fixed, int fixedsize)
+{
+	kcaprecord_t	rec;
+
+	rec.kind = kind;
+	rec.size = size;
+	KCap_Write (&rec, sizeof(rec));
+	KCap_Write (fixed, fixedsize);
+	kcap_records++;
+}
+
+static int KCap_CountSpans (espan_t *pspan)
+{
+	int		n;
+
+	for (n=0 ; pspan ; pspan=pspan->pnext)
+		n++;
+	return n;
+}
+
+static void KCap_WriteSpans (espan_t *pspan)
+{
+	kcapspan_t	span;
+
+	for ( ; pspan ; pspan=pspan->pnext)
+	{
+		span.u = pspan->u;
+		span.v = pspan->v;
+		span.count = pspan->count;
+		KCap_Write (&span, sizeof(span));
+	}
+}
+
+/*
+===============
+KCap_Spans
+
+D_DrawSpans8 / Turbulent8 input, called right after D_CalcGradients
+===============
+*/
+void KCap_Spans (int kind, espan_t *pspan)
+{
+	kcapspans_t	h;
+	int			texbytes;
+
+	h.sdivzstepu = d_sdivzstepu;
+	h.tdivzstepu = d_tdivzstepu;
+	h.zistepu = d_zistepu;
+	h.sdivzstepv = d_sdivzstepv;
+	h.tdivzstepv = d_tdivzstepv;
+	h.zistepv = d_zistepv;
+	h.sdivzorigin = d_sdivzorigin;
+	h.tdivzorigin = d_tdivzorigin;
+	h.ziorigin = d_ziorigin;
+	h.sadjust = sadjust;
+	h.tadjust = tadjust;
+	h.bbextents = bbextents;
+	h.bbextentt = bbextentt;
+	h.cachewidth = cachewidth;
+	if (kind == KC_TURB)
+		h.texrows = 64;
+	else
+		h.texrows = (bbextentt >> 16) + 1;
+	h.numspans = KCap_CountSpans (pspan);
+	h.time = cl.time;
+
+	texbytes = h.texrows * h.cachewidth;
+	KCap_Record (kind, sizeof(h) + texbytes + h.numspans*sizeof(kcapspan_t),
+			&h, sizeof(h));
+	KCap_Write (cacheblock, texbytes);
+	KCap_WriteSpans (pspan);
+}
+
+/*
+===============
+KCap_Sky
+===============
+*/
+void KCap_Sky (espan_t *pspan)
+{
+	kcapsky_t	h;
+
+	h.vrectwidth = r_refdef.vrect.width;
+	h.vrectheight = r_refdef.vrect.height;
+	VectorCopy (vpn, h.vpn);
+	VectorCopy (vright, h.vright);
+	VectorCopy (vup, h.vup);
+	h.skytime = skytime;
+	h.skyspeed = skyspeed;
+	h.zistepu = d_zistepu;
+	h.zistepv = d_zistepv;
+	h.ziorigin = d_ziorigin;
+	h.numspans = KCap_CountSpans (pspan);
+
+	KCap_Record (KC_SKY, sizeof(h) + 2*128*128 + h.numspans*sizeof(kcapspan_t),
+			&h, sizeof(h));
+	KCap_Write (r_skytop, 128*128);
+	KCap_Write (r_skybottom, 128*128);
+	KCap_WriteSpans (pspan);
+}
+
+/*
+===============
+KCap_Alias
+
+one D_PolysetDraw batch: skin, triangles and the projected verts
+===============
+*/
+void KCap_Alias (void)
+{
+	kcapalias_t	h;
+	int			i, j, skinbytes, cmapbytes;
+
+	h.skinwidth = r_affinetridesc.skinwidth;
+	h.skinheight = r_affinetridesc.skinheight;
+	h.numtriangles = r_affinetridesc.numtriangles;
+	h.drawtype = r_affinetridesc.drawtype;
+	h.seamfixupX16 = r_affinetridesc.seamfixupX16;
+	h.owncolormap = (acolormap != vid.colormap);
+	h.vrectright = r_refdef.vrectright;
+	h.vrectbottom = r_refdef.vrectbottom;
+
+	h.numverts = 0;
+	for (i=0 ; i<h.numtriangles ; i++)
+		for (j=0 ; j<3 ; j++)
+			if (r_affinetridesc.ptriangles[i].vertindex[j] >= h.numverts)
+				h.numverts = r_affinetridesc.ptriangles[i].vertindex[j] + 1;
+
+	skinbytes = h.skinwidth * h.skinheight;
+	cmapbytes = h.owncolormap ? 256*VID_GRADES : 0;
+
+	KCap_Record (KC_ALIAS, sizeof(h) + skinbytes +
+			h.numtriangles*sizeof(mtriangle_t) +
+			h.numverts*sizeof(finalvert_t) + cmapbytes, &h, sizeof(h));
+	KCap_Write (r_affinetridesc.pskin, skinbytes);
+	KCap_Write (r_affinetridesc.ptriangles, h.numtriangles*sizeof(mtriangle_t));
+	KCap_Write (r_affinetridesc.pfinalverts, h.numverts*sizeof(finalvert_t));
+	KCap_Write (acolormap, cmapbytes);
+}
+
+/*
+===============
+KCap_Surface
+
+R_DrawSurface input once the lightmap has been built
+===============
+*/
+void KCap_Surface (void)
+{
+	kcapsurf_t	h;
+	texture_t	*mt;
+	msurface_t	*surf;
+	int			texbytes;
+
+	mt = r_drawsurf.texture;
+	surf = r_drawsurf.surf;
+
+	h.surfmip = r_drawsurf.surfmip;
+	h.surfwidth = r_drawsurf.surfwidth;
+	h.surfheight = r_drawsurf.surfheight;
+	h.rowbytes = r_drawsurf.rowbytes;
+	h.texwidth = mt->width;
+	h.texheight = mt->height;
+	h.texturemins[0] = surf->texturemins[0];
+	h.texturemins[1] = surf->texturemins[1];
+	h.extents[0] = surf->extents[0];
+	h.extents[1] = surf->extents[1];
+	h.lightsize = ((surf->extents[0]>>4)+1) * ((surf->extents[1]>>4)+1);
+
+	texbytes = (mt->width >> h.surfmip) * (mt->height >> h.surfmip);
+	KCap_Record (KC_SURF, sizeof(h) + texbytes + h.lightsize*sizeof(unsigned),
+			&h, sizeof(h));
+	KCap_Write (Mod_TextureMip (mt, h.surfmip), texbytes);
+	KCap_Write (blocklights, h.lightsize*sizeof(unsigned));
+}
+
+/*
+===============
+KCap_Channels
+
+snapshot of the channels core 1 is mixing
+===============
+*/
+static void KCap_Channels (void)
+{
+	kcapsfx_t	h;
+	channel_t	*ch;
+	sfxcache_t	*sc;
+	int			i, bytes;
+
+	for (i=0, ch=channels ; i<total_channels ; i++, ch++)
+	{
+		if (!ch->sfx || !ch->leftvol || !ch->rightvol)
+			continue;
+		sc = (sfxcache_t *)ch->sfx->cache.data;
+		if (!sc || sc->length <= 0 || sc->width != 1)
+			continue;
+
+		h.leftvol = ch->leftvol;
+		h.rightvol = ch->rightvol;
+		h.pos = ch->pos;
+		h.end = ch->end;
+		h.length = sc->length;
+		h.loopstart = sc->loopstart;
+		h.adpcm = sc->adpcm;
+
+		bytes = h.adpcm ? SFX_ADPCM_BYTES(h.length) : h.length;
+		KCap_Record (KC_SFX, sizeof(h) + bytes, &h, sizeof(h));
+		KCap_Write (sc->data, bytes);
+	}
+}
+
+/*
+===============
+KCap_BeginFrame
+===============
+*/
+void KCap_BeginFrame (void)
+{
+	kcapheader_t	header;
+	kcapframe_t		frame;
+
+	if (!kcap_pending)
+		return;
+	kcap_pending = false;
+
+	kcap_file = Sys_FileOpenWrite (kcap_name);
+	if (kcap_file == -1)
+	{
+		Con_Printf ("ERROR: couldn't open %s\n", kcap_name);
+		return;
+	}
+
+	kcap_records = 0;
+	kcap_bytes = 0;
+
+	header.ident = KCAP_IDENT;
+	header.version = KCAP_VERSION;
+	KCap_Write (&header, sizeof(header));
+
+	frame.width = vid.width;
+	frame.height = vid.height;
+	frame.rowbytes = vid.rowbytes;
+	frame.time = cl.time;
+	KCap_Record (KC_FRAME, sizeof(frame) + 256*VID_GRADES, &frame, sizeof(frame));
+	KCap_Write (vid.colormap, 256*VID_GRADES);
+
+	KCap_Channels ();
+
+	kcap_active = true;
+}
+
+/*
+===============
+KCap_EndFrame
+===============
+*/
+void KCap_EndFrame (void)
+{
+	if (!kcap_active)
+		return;
+	kcap_active = false;
+
+	Sys_FileClose (kcap_file);
+	kcap_file = -1;
+
+	Con_Printf ("wrote %s: %i records, %i bytes\n", kcap_name, kcap_records, kcap_bytes);
+}
+
+/*
+===============
+KCap_Capture_f
+===============
+*/
+static void KCap_Capture_f (void)
+{
+	char	name[MAX_OSPATH];
+
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("kcapture <name> : record the kernel inputs of the next frame\n");
+		return;
+	}
+	if (!cl.worldmodel)
+	{
+		Con_Printf ("kcapture: no map running\n");
+		return;
+	}
+
+// leave room for the extension
+	if (snprintf (name, sizeof(name) - 4, "%s/%s", com_gamedir, Cmd_Argv(1)) >= (int)sizeof(name) - 4)
+	{
+		Con_Printf ("kcapture: name too long, nothing captured\n");
+		return;
+	}
+	COM_DefaultExtension (name, ".kcp");
+	strcpy (kcap_name, name);
+	kcap_pending = true;
+}
+
+/*
+===============
+KCap_Init
+===============
+*/
+void KCap_Init (void)
+{
+	Cmd_AddCommand ("kcapture", KCap_Capture_f);
+}
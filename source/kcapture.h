@@ -0,0 +1,129 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// kcapture.h -- recorded rasterizer kernel inputs, shared by the engine
+// (writer, kcapture.c) and the host benchmark (reader, kbench.c)
+//
+// a capture file is a kcapheader_t followed by a stream of records, each a
+// kcaprecord_t and size bytes of payload. All payload arrays are stored
+// inline in native byte order, pointers are never written.
+
+#define KCAP_IDENT		(('P'<<24)+('A'<<16)+('C'<<8)+'K')
+#define KCAP_VERSION	3
+
+typedef enum {
+	KC_FRAME,		// kcapframe_t, then 256*VID_GRADES colormap bytes
+	KC_SPANS,		// kcapspans_t, texture rows, kcapspan_t[numspans]
+	KC_TURB,		// kcapspans_t, 64*64 texture, kcapspan_t[numspans]
+	KC_SKY,			// kcapsky_t, 128*128 top and bottom layers, kcapspan_t[numspans]
+	KC_ALIAS,		// kcapalias_t, skin, mtriangle_t[], finalvert_t[], colormap
+	KC_SURF,		// kcapsurf_t, texture mip, lightmap
+	KC_SFX,			// kcapsfx_t, 8 bit samples or ADPCM blocks
+	KC_NUMKINDS
+} kcapkind_t;
+
+typedef struct
+{
+	int		ident;
+	int		version;
+} kcapheader_t;
+
+typedef struct
+{
+	int		kind;
+	int		size;			// payload bytes following this header
+} kcaprecord_t;
+
+typedef struct
+{
+	int		width, height, rowbytes;
+	float	time;
+} kcapframe_t;
+
+typedef struct
+{
+	int		u, v, count;
+} kcapspan_t;
+
+// D_DrawSpans8 / Turbulent8 / D_DrawZSpans state after D_CalcGradients
+typedef struct
+{
+	float	sdivzstepu, tdivzstepu, zistepu;
+	float	sdivzstepv, tdivzstepv, zistepv;
+	float	sdivzorigin, tdivzorigin, ziorigin;
+	int		sadjust, tadjust;
+	int		bbextents, bbextentt;
+	int		cachewidth;
+	int		texrows;
+	int		numspans;
+	float	time;			// cl.time, selects the Turbulent8 phase
+} kcapspans_t;
+
+typedef struct
+{
+	int		vrectwidth, vrectheight;
+	float	vpn[3], vright[3], vup[3];
+	float	skytime, skyspeed;
+	float	zistepu, zistepv, ziorigin;
+	int		numspans;
+} kcapsky_t;
+
+// one D_PolysetDraw call
+typedef struct
+{
+	int		skinwidth, skinheight;
+	int		numtriangles, numverts;
+	int		drawtype;
+	int		seamfixupX16;
+	int		owncolormap;	// 1 = translated colormap follows the verts
+	int		vrectright, vrectbottom;
+} kcapalias_t;
+
+// one R_DrawSurface call, after R_BuildLightMap
+typedef struct
+{
+	int		surfmip;
+	int		surfwidth, surfheight;
+	int		rowbytes;
+	int		texwidth, texheight;	// of mip 0
+	int		texturemins[2];
+	int		extents[2];
+	int		lightsize;				// unsigned blocklights entries
+} kcapsurf_t;
+
+// one active mixer channel
+typedef struct
+{
+	int		leftvol, rightvol;
+	int		pos;
+	int		end;
+	int		length;
+	int		loopstart;
+	int		adpcm;			// payload is SFX_ADPCM_BYTES(length)
+} kcapsfx_t;
+
+extern qboolean	kcap_active;
+
+void KCap_Init (void);
+void KCap_BeginFrame (void);
+void KCap_EndFrame (void);
+void KCap_Spans (int kind, struct espan_s *pspan);
+void KCap_Sky (struct espan_s *pspan);
+void KCap_Alias (void);
+void KCap_Surface (void);
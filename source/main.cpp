@@ -74,6 +74,7 @@ static uint8_t ps2mouse_present = 0;
 
 extern "C" bool is_i2s_enabled;
 extern "C" int testPins(uint32_t pin0, uint32_t pin1);
+extern "C" void R_ParticleWorker(void);
 
 struct semaphore vga_start_semaphore;
 
@@ -764,6 +765,7 @@ void __scratch_x("render") render_core() {
 #if TFT
         refresh_lcd();
 #endif
+        R_ParticleWorker();
         tick = time_us_64();
     }
     __unreachable();
@@ -954,6 +956,12 @@ extern "C" void __time_critical_func() vsync_handler() {
 
 }
 
+// refresh_lcd() can last through the whole world render, so the particle
+// simulation posted under it is picked up between the rows
+extern "C" void __time_critical_func() refresh_poll_handler() {
+    R_ParticleWorker();
+}
+
 extern "C" uint8_t* __time_critical_func() get_line_buffer(int line) {
     return FRAME_BUF + QUAKEGENERIC_RES_X * line;
 }
@@ -995,6 +1003,39 @@ extern "C" void QG_DrawFrame(void *pixels) {
     repeat_me_for_input();
 #endif
     memcpy(FRAME_BUF, pixels, QUAKEGENERIC_RES_X * QUAKEGENERIC_RES_Y);
+#if TFT
+    graphics_set_dirty_rows(0, QUAKEGENERIC_RES_Y);
+#endif
+}
+
+// only the rows/columns the engine reports as changed are copied, and on TFT
+// only those rows are sent over SPI by refresh_lcd()
+extern "C" void QG_DrawFrameRects(void *pixels, const qg_rect_t *rects, int numrects) {
+#ifdef KBDUSB
+    repeat_me_for_input();
+#endif
+    for (int i = 0; i < numrects; i++) {
+        const qg_rect_t *r = &rects[i];
+        if (pixels && qg_warp) {
+            // underwater, the warp is gathered in the same pass
+            for (int y = r->y; y < r->y + r->height; y++)
+                QG_CopyRow(FRAME_BUF + y * QUAKEGENERIC_RES_X + r->x, (const uint8_t *)pixels, r->x, y, r->width);
+        } else if (pixels) {
+            const uint8_t *src = (const uint8_t *)pixels + r->y * QUAKEGENERIC_RES_X + r->x;
+            uint8_t *dst = FRAME_BUF + r->y * QUAKEGENERIC_RES_X + r->x;
+            if (r->width == QUAKEGENERIC_RES_X) {
+                memcpy(dst, src, QUAKEGENERIC_RES_X * r->height);
+            } else {
+                for (int y = 0; y < r->height; y++) {
+                    memcpy(dst, src, r->width);
+                    src += QUAKEGENERIC_RES_X; dst += QUAKEGENERIC_RES_X;
+                }
+            }
+        }
+#if TFT
+        graphics_set_dirty_rows(r->y, r->y + r->height);
+#endif
+    }
 }
 
 #if DVI_HSTX
@@ -1023,6 +1064,10 @@ extern "C" void QG_SetPalette(unsigned char palette[768]) {
 		    palette[i3 + 2]; // B
         graphics_set_palette(i, pal888);
 	}
+#if TFT
+    // palette is applied while sending, so every row has to go out again
+    graphics_set_dirty_rows(0, QUAKEGENERIC_RES_Y);
+#endif
 }
 
 #endif
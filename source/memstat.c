@@ -0,0 +1,192 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// memstat.c -- per frame memory telemetry
+
+#include "quakedef.h"
+#include "d_local.h"
+
+#define	MEMSTAT_HISTORY		128		// power of two, one graph column each
+#define	MEMGRAPH_HEIGHT		16
+#define	MEMGRAPH_BACK		0x30
+#define	MEMGRAPH_BAR		0xff
+#define	MEMGRAPH_WARN		0x6f	// surface cache wrapped
+#define	MEMGRAPH_BAD		0x49	// thrashed, or cache blocks thrown out
+
+cvar_t	scr_showmem = {"showmem", "0"};
+
+static memsample_t	memstat_history[MEMSTAT_HISTORY];
+static int			memstat_next;
+static int			memstat_lastframe = -2;
+static int			memstat_evictions;
+static unsigned		memstat_scallocated;
+static int			memstat_hunksize, memstat_zonesize;
+
+/*
+===============
+MemStat_Frame
+
+Called at the end of the frame
+===============
+*/
+void MemStat_Frame (memsample_t *s)
+{
+// the per frame counts start over if the last frame wasn't sampled
+	if (memstat_lastframe != host_framecount - 1)
+	{
+		memstat_evictions = cache_evictions;
+		memstat_scallocated = sc_allocated;
+	}
+	memstat_lastframe = host_framecount;
+
+	Hunk_Stats (&memstat_hunksize, &s->hunklow, &s->hunkhigh);
+	Z_Stats (&memstat_zonesize, &s->zonefree, &s->zonelargest);
+	Cache_Stats (&s->cachebytes, &s->cacheblocks);
+	s->cacheevicted = cache_evictions - memstat_evictions;
+	memstat_evictions = cache_evictions;
+	s->scbytes = sc_allocated - memstat_scallocated;
+	memstat_scallocated = sc_allocated;
+	s->scflags = (d_roverwrapped ? MS_SCWRAPPED : 0) | (r_cache_thrash ? MS_SCTHRASH : 0);
+	s->auxpeak = Arena_FramePeak (&aux_arena);
+	s->zbufferpeak = Arena_FramePeak (&zbuffer_arena);
+
+	memstat_history[memstat_next] = *s;
+	memstat_next = (memstat_next + 1) & (MEMSTAT_HISTORY - 1);
+}
+
+/*
+===============
+MemStat_Value
+
+One graph's value for a sample, how far it can go and its colour
+===============
+*/
+#define	MEMGRAPH_COUNT	6
+
+static const char *memgraph_names[MEMGRAPH_COUNT] =
+{
+	"hunk", "zone", "cache", "surf", "aux", "zbuf"
+};
+
+static int MemStat_Value (memsample_t *s, int graph, int *max, int *color)
+{
+	*color = MEMGRAPH_BAR;
+	switch (graph)
+	{
+	case 0:
+		*max = memstat_hunksize;
+		return s->hunklow + s->hunkhigh;
+	case 1:
+		*max = memstat_zonesize;
+		return memstat_zonesize - s->zonefree;
+	case 2:		// of the room between the hunk marks
+		*max = memstat_hunksize - s->hunklow - s->hunkhigh;
+		if (s->cacheevicted)
+			*color = MEMGRAPH_BAD;
+		return s->cachebytes;
+	case 3:
+		*max = sc_size;
+		if (s->scflags & MS_SCTHRASH)
+			*color = MEMGRAPH_BAD;
+		else if (s->scflags & MS_SCWRAPPED)
+			*color = MEMGRAPH_WARN;
+		return s->scbytes;
+	case 4:
+		*max = aux_arena.end - aux_arena.base;
+		return s->auxpeak;
+	default:
+		*max = zbuffer_arena.end - zbuffer_arena.base;
+		return s->zbufferpeak;
+	}
+}
+
+/*
+===============
+MemStat_Graph
+===============
+*/
+static void MemStat_Graph (int x, int y, int graph)
+{
+	memsample_t	*s;
+	byte		*dest;
+	int			i, j, h, value, max, color;
+
+	D_WarpOverdraw (x, y, MEMSTAT_HISTORY, MEMGRAPH_HEIGHT);
+	for (i=0 ; i<MEMSTAT_HISTORY ; i++)
+	{
+		s = &memstat_history[(memstat_next + i) & (MEMSTAT_HISTORY - 1)];	// oldest first
+		value = MemStat_Value (s, graph, &max, &color);
+		h = max > 0 ? (int)((float)value * MEMGRAPH_HEIGHT / max + 0.5f) : 0;
+		if (h > MEMGRAPH_HEIGHT)
+			h = MEMGRAPH_HEIGHT;
+
+		dest = vid.buffer + vid.rowbytes*(y + MEMGRAPH_HEIGHT - 1) + x + i;
+		for (j=0 ; j<MEMGRAPH_HEIGHT ; j++, dest -= vid.rowbytes)
+			*dest = j < h ? color : MEMGRAPH_BACK;
+	}
+}
+
+/*
+===============
+MemStat_Draw
+
+One graph per pool over the last frames, newest on the right, with the
+newest value in kilobytes
+===============
+*/
+void MemStat_Draw (void)
+{
+	memsample_t	*s;
+	char		str[32];
+	int			x, y, graph, value, max, color;
+
+	if (!scr_showmem.value || memstat_lastframe < 0)
+		return;
+	if (scr_vrect.width < 40 + MEMSTAT_HISTORY + 56)
+		return;
+
+	s = &memstat_history[(memstat_next - 1) & (MEMSTAT_HISTORY - 1)];
+	x = scr_vrect.x + 8;
+	y = scr_vrect.y + 32;		// under the ram icon
+	for (graph=0 ; graph<MEMGRAPH_COUNT ; graph++, y += MEMGRAPH_HEIGHT + 2)
+	{
+		if (y + MEMGRAPH_HEIGHT > scr_vrect.y + scr_vrect.height)
+			break;
+
+		Draw_String (x, y + (MEMGRAPH_HEIGHT - 8)/2, (char *)memgraph_names[graph]);
+		MemStat_Graph (x + 40, y, graph);
+
+		value = MemStat_Value (s, graph, &max, &color);
+		if (graph == 2 && s->cacheevicted)
+			sprintf (str, "%ik -%i", value / 1024, s->cacheevicted);
+		else
+			sprintf (str, "%ik", value / 1024);
+		Draw_String (x + 40 + MEMSTAT_HISTORY + 8, y + (MEMGRAPH_HEIGHT - 8)/2, str);
+	}
+}
+
+/*
+===============
+MemStat_Init
+===============
+*/
+void MemStat_Init (void)
+{
+	Cvar_RegisterVariable (&scr_showmem);
+}
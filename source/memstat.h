@@ -0,0 +1,44 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// memstat.h -- per frame memory telemetry
+//
+// Host_Frame takes a sample at the end of every frame while "showmem" is
+// set or a frametimedemo is running; showmem draws the last frames as a
+// graph over the view, frametimedemo logs them with the frame times.
+
+#define	MS_SCWRAPPED	1		// the surface cache rover wrapped this frame
+#define	MS_SCTHRASH		2		// and went past where the frame started
+
+typedef struct
+{
+	int		hunklow, hunkhigh;		// bytes used from either end
+	int		zonefree, zonelargest;	// largest free block
+	int		cachebytes, cacheblocks;
+	int		cacheevicted;			// blocks thrown out this frame
+	int		scbytes;				// surface cache allocated this frame
+	int		scflags;				// MS_SC*
+	int		auxpeak, zbufferpeak;	// arena high water this frame
+} memsample_t;
+
+extern cvar_t	scr_showmem;
+
+void MemStat_Init (void);
+void MemStat_Frame (memsample_t *s);
+void MemStat_Draw (void);
@@ -456,8 +456,11 @@ void M_ScanSaves (void)
 		f = Sys_File(h);
 		if (!f)
 			continue;
-		Sys_Fscanf (f, "%i\n", &version);
-		Sys_Fscanf (f, "%79s\n", name);
+		if (!Host_SnapshotComment (h, name))
+		{
+			Sys_Fscanf (f, "%i\n", &version);
+			Sys_Fscanf (f, "%79s\n", name);
+		}
 		strncpy (m_filenames[i], name, sizeof(m_filenames[i])-1);
 
 	// change _ back to space
@@ -33,6 +33,14 @@ bool is_i2s_enabled = false;
 extern "C" qboolean CDAudio_GetSamples(int16_t* buf, size_t n); // FIXME!!
 extern "C" void S_RenderSfx(int32_t *sfxbuf, int frames, uint32_t timestamp);
 
+// saturate to 16 bits, a single SSAT on the M33
+#if defined(__ARM_FEATURE_DSP)
+#include <arm_acle.h>
+#define CLAMP16(x) __ssat((x), 16)
+#else
+#define CLAMP16(x) MIN(MAX((x), -32768), 32767)
+#endif
+
 int __not_in_flash_func(audio_cb_common)(int16_t* dst, uint32_t frames, int volscale, int volbias) {
     if (frames == 0) return 0;
     
@@ -41,54 +49,27 @@ int __not_in_flash_func(audio_cb_common)(int16_t* dst, uint32_t frames, int vols
     S_RenderSfx(sfxbuf + 2, frames / SFX_DOWNSAMPLE_RATIO, timestamp / SFX_DOWNSAMPLE_RATIO);
     timestamp += frames;
 
-    // upsample sfx buffer, mix with CD audio and clamp
-    // TODO: linearly interpolate sfx buffer data
-
+    // upsample sfx buffer with linear interpolation, mix with CD audio and clamp
     int sfxvolume = cvar_volume.value * 32767.0f;
     register int sfx_l, sfx_r, dsfx_l, dsfx_r, dst_l, dst_r;
     int32_t *sfx = sfxbuf;
     do {
         sfx_l  = (sfxvolume * sfx[0]) >> 15;
         sfx_r  = (sfxvolume * sfx[1]) >> 15;
-        dsfx_l = (((sfxvolume * sfx[2]) >> 15) - sfx_l) >> 2;
-        dsfx_r = (((sfxvolume * sfx[3]) >> 15) - sfx_r) >> 2;
-
-        dst_l  = dst[0] + sfx_l;
-        dst_r  = dst[1] + sfx_r;
-        dst_l  = MIN(MAX(dst_l, -32768), 32767);
-        dst_r  = MIN(MAX(dst_r, -32768), 32767);
-        dst[0] = (volscale * (dst_l + volbias)) >> 15;
-        dst[1] = (volscale * (dst_r + volbias)) >> 15;
-
-        sfx_l += dsfx_l;
-        sfx_r += dsfx_r;
-        dst_l  = dst[2] + sfx_l;
-        dst_r  = dst[3] + sfx_r;
-        dst_l  = MIN(MAX(dst_l, -32768), 32767);
-        dst_r  = MIN(MAX(dst_r, -32768), 32767);
-        dst[2] = (volscale * (dst_l + volbias)) >> 15;
-        dst[3] = (volscale * (dst_r + volbias)) >> 15;
-
-        sfx_l += dsfx_l;
-        sfx_r += dsfx_r;
-        dst_l  = dst[4] + sfx_l;
-        dst_r  = dst[5] + sfx_r;
-        dst_l  = MIN(MAX(dst_l, -32768), 32767);
-        dst_r  = MIN(MAX(dst_r, -32768), 32767);
-        dst[4] = (volscale * (dst_l + volbias)) >> 15;
-        dst[5] = (volscale * (dst_r + volbias)) >> 15;
-
-        sfx_l += dsfx_l;
-        sfx_r += dsfx_r;
-        dst_l  = dst[6] + sfx_l;
-        dst_r  = dst[7] + sfx_r;
-        dst_l  = MIN(MAX(dst_l, -32768), 32767);
-        dst_r  = MIN(MAX(dst_r, -32768), 32767);
-        dst[6] = (volscale * (dst_l + volbias)) >> 15;
-        dst[7] = (volscale * (dst_r + volbias)) >> 15;
+        dsfx_l = (((sfxvolume * sfx[2]) >> 15) - sfx_l) >> SFX_DOWNSAMPLE_SHIFT;
+        dsfx_r = (((sfxvolume * sfx[3]) >> 15) - sfx_r) >> SFX_DOWNSAMPLE_SHIFT;
+
+        for (int i = 0; i < SFX_DOWNSAMPLE_RATIO; i++) {   // unrolled by the compiler
+            dst_l  = CLAMP16(dst[0] + sfx_l);
+            dst_r  = CLAMP16(dst[1] + sfx_r);
+            dst[0] = (volscale * (dst_l + volbias)) >> 15;
+            dst[1] = (volscale * (dst_r + volbias)) >> 15;
+            sfx_l += dsfx_l;
+            sfx_r += dsfx_r;
+            dst   += 2;
+        }
 
         sfx    += 2;
-        dst    += 2*SFX_DOWNSAMPLE_RATIO;
         frames -= SFX_DOWNSAMPLE_RATIO;
     } while (frames);
 
@@ -109,7 +90,7 @@ void mixer_init(int volume, int is_hdmi) {
     audio_config_t *cfg = audio_init_default_cfg();
 
     cfg->flags  = AUDIO_CFG_STEREO | (is_i2s_enabled ? AUDIO_CFG_I2S : AUDIO_CFG_PWM);
-    cfg->sample_freq = 44100;
+    cfg->sample_freq = SFX_OUTPUT_RATE;
     cfg->cb     = audio_cb;
     cfg->volume = (32767 * volume) / 100;
     cfg->dma_buffer     = audiobuf;
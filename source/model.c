@@ -44,6 +44,540 @@ __psram_bss ("model") int		mod_numknown;
 #define NL_NEEDS_LOADED	1
 #define NL_UNREFERENCED	2
 
+/*
+===============================================================================
+
+					RETAINED MODELS AND TEXTURES
+
+Alias models and world textures are kept in a region of the hunk taken
+below host_hunklevel, so they survive Host_ClearMemory. An entry counts
+the references from the current map; once a map change drops them to
+zero it stays until the space is needed, oldest map first, and the next
+map asking for the same model, or texture by name and crc, takes it
+without loading or copying anything.
+
+The region is sized with -modcache <kb> and is off by default. It is
+taken from the hunk for good, so it only pays when the same models and
+textures come back across maps. With -texpool the world textures are
+paged through the pool instead and are never retained, so the region
+then only holds alias models and the textures loaded with the map (sky,
+b_ models, and any too big for the pool) and can be sized for those.
+
+===============================================================================
+*/
+
+#define	MAX_RETAINED		192
+#define	RETAINED_DEFAULT	0		// kilobytes, -modcache
+
+#define	RT_ALIAS			0
+#define	RT_TEXTURE			1
+
+typedef struct
+{
+	char			name[MAX_QPATH];	// empty when the slot is free
+	int				kind;
+	unsigned short	crc;				// textures only
+	int				offset, size;		// in mod_retained
+	int				refs;				// by the current map
+	int				lastmap;			// mod_mapcount when last referenced
+} retained_t;
+
+__psram_bss ("model") retained_t	mod_retainedents[MAX_RETAINED];
+__psram_bss ("model") short		mod_retainedorder[MAX_RETAINED];	// by offset
+static int		mod_numretained;
+static byte		*mod_retained;
+static int		mod_retainedsize;
+static int		mod_mapcount;
+static int		mod_hits[2], mod_misses[2];
+
+static void *Mod_RetainedData (int ent)
+{
+	return mod_retained + mod_retainedents[ent].offset;
+}
+
+/*
+===============
+Mod_RetainedFree
+===============
+*/
+static void Mod_RetainedFree (int ent)
+{
+	int		i;
+	model_t	*mod;
+
+	for (i=0 ; i<mod_numretained ; i++)
+		if (mod_retainedorder[i] == ent)
+			break;
+	if (i == mod_numretained)
+		Sys_Error ("Mod_RetainedFree: %i not in use", ent);
+	memmove (&mod_retainedorder[i], &mod_retainedorder[i+1],
+			(mod_numretained-i-1) * sizeof(mod_retainedorder[0]));
+	mod_numretained--;
+
+	if (mod_retainedents[ent].kind == RT_ALIAS)
+	{
+		for (i=0, mod=mod_known ; i<mod_numknown ; i++, mod++)
+			if (mod->retained == ent+1)
+				mod->retained = 0;
+	}
+	mod_retainedents[ent].name[0] = 0;
+}
+
+/*
+===============
+Mod_RetainedAlloc
+
+First fit, evicting the unreferenced entries of the oldest maps until it
+fits. Returns -1 if everything left is in use by the current map.
+===============
+*/
+static int Mod_RetainedAlloc (int kind, char *name, unsigned short crc, int size)
+{
+	int			i, ent, offset, next, oldest;
+	retained_t	*rt;
+
+	size = (size + 15) & ~15;
+	if (size > mod_retainedsize)
+		return -1;
+
+	while (1)
+	{
+		offset = 0;
+		for (i=0 ; i<mod_numretained ; i++)
+		{
+			rt = &mod_retainedents[mod_retainedorder[i]];
+			if (rt->offset - offset >= size)
+				break;
+			offset = rt->offset + rt->size;
+		}
+		if (i < mod_numretained || mod_retainedsize - offset >= size)
+			break;
+
+		oldest = -1;
+		for (i=0 ; i<mod_numretained ; i++)
+		{
+			next = mod_retainedorder[i];
+			if (mod_retainedents[next].refs)
+				continue;
+			if (oldest < 0 || mod_retainedents[next].lastmap < mod_retainedents[oldest].lastmap)
+				oldest = next;
+		}
+		if (oldest < 0)
+			return -1;
+		Mod_RetainedFree (oldest);
+	}
+
+	for (ent=0 ; ent<MAX_RETAINED ; ent++)
+		if (!mod_retainedents[ent].name[0])
+			break;
+	if (ent == MAX_RETAINED)
+		return -1;
+
+	memmove (&mod_retainedorder[i+1], &mod_retainedorder[i],
+			(mod_numretained-i) * sizeof(mod_retainedorder[0]));
+	mod_retainedorder[i] = ent;
+	mod_numretained++;
+
+	rt = &mod_retainedents[ent];
+	Q_strncpy (rt->name, name, sizeof(rt->name)-1);
+	rt->kind = kind;
+	rt->crc = crc;
+	rt->offset = offset;
+	rt->size = size;
+	rt->refs = 1;
+	rt->lastmap = mod_mapcount;
+	return ent;
+}
+
+static void Mod_RetainedRef (int ent)
+{
+	mod_retainedents[ent].refs++;
+	mod_retainedents[ent].lastmap = mod_mapcount;
+}
+
+/*
+===============
+Mod_RetainedTexture
+
+finds a world texture kept from an earlier map
+===============
+*/
+static texture_t *Mod_RetainedTexture (char *name, unsigned short crc, int size)
+{
+	int			i, ent;
+	retained_t	*rt;
+	texture_t	*tx;
+
+	for (i=0 ; i<mod_numretained ; i++)
+	{
+		ent = mod_retainedorder[i];
+		rt = &mod_retainedents[ent];
+		if (rt->kind != RT_TEXTURE || rt->crc != crc || rt->size != ((size + 15) & ~15))
+			continue;
+		if (Q_strncmp (rt->name, name, 16))
+			continue;
+
+		Mod_RetainedRef (ent);
+		tx = Mod_RetainedData (ent);
+	// sequenced again by Mod_LoadTextures for this map
+		tx->anim_total = tx->anim_min = tx->anim_max = 0;
+		tx->anim_next = tx->alternate_anims = NULL;
+		return tx;
+	}
+	return NULL;
+}
+
+/*
+===============
+Mod_ModelCache_f
+===============
+*/
+static void Mod_ModelCache_f (void)
+{
+	int			i, used, refd;
+	retained_t	*rt;
+
+	used = refd = 0;
+	for (i=0 ; i<mod_numretained ; i++)
+	{
+		rt = &mod_retainedents[mod_retainedorder[i]];
+		used += rt->size;
+		if (rt->refs)
+			refd++;
+		if (Cmd_Argc() > 1 && !Q_strcmp (Cmd_Argv(1), "list"))
+			Con_Printf ("%7i %c %2i %s\n", rt->size, rt->kind == RT_ALIAS ? 'M' : 'T',
+					rt->refs, rt->name);
+	}
+
+	Con_Printf ("retained: %iK of %iK, %i entries, %i in use\n",
+			used >> 10, mod_retainedsize >> 10, mod_numretained, refd);
+	Con_Printf ("models:   %i hits %i misses\n", mod_hits[RT_ALIAS], mod_misses[RT_ALIAS]);
+	Con_Printf ("textures: %i hits %i misses\n", mod_hits[RT_TEXTURE], mod_misses[RT_TEXTURE]);
+}
+
+/*
+===============================================================================
+
+					LAZY TEXTURES
+
+With a texture pool (-texpool <kb>, off by default) only the texture_t
+headers of the world are loaded and every mip level is read from the map
+file the first time Mod_TextureMip asks for it. The pool is allocated with
+a rover like the surface cache, but blocks used in the last two frames
+get a second chance and are stepped over, so what is on screen stays
+resident while the rest ages out. When the view leaf changes the textures
+of the new PVS are queued, at the mip their distance calls for, and read
+a few per frame ahead of the surfaces that need them.
+A texture whose largest mip would not fit in the pool is loaded with the
+map as before.
+
+===============================================================================
+*/
+
+#define	TEXPOOL_DEFAULT		0		// kilobytes, -texpool
+#define	TEXBLOCK_MIN		64		// smallest free block worth splitting off
+#define	TEXBLOCK_SIZE(s)	(((s) + (int)sizeof(texblock_t) + 15) & ~15)
+
+typedef struct texblock_s
+{
+	struct texblock_s	*next;		// in address order, NULL for the last
+	byte				**owner;	// NULL if free
+	int					size;		// including the header
+	int					lastframe;
+} texblock_t;
+
+cvar_t	r_texprefetch = {"r_texprefetch", "16384"};	// bytes read ahead per frame
+
+static texblock_t	*mod_texpool, *mod_texrover;
+static int			mod_texpoolsize;
+static int			mod_texhandle = -1;
+static int			mod_texfetches, mod_texbytes, mod_texevicts, mod_texforced;
+
+static texture_t	*mod_prefetch[MAX_MAP_TEXTURES];
+static int			mod_numprefetch, mod_prefetchnext;
+
+/*
+===============
+Mod_TexPoolFlush
+
+the textures owning blocks are gone with the hunk, so nothing is unlinked
+===============
+*/
+static void Mod_TexPoolFlush (void)
+{
+	if (mod_texhandle != -1)
+	{
+		COM_CloseFile (mod_texhandle);
+		mod_texhandle = -1;
+	}
+	mod_numprefetch = mod_prefetchnext = 0;
+
+	if (!mod_texpool)
+		return;
+	mod_texpool->next = NULL;
+	mod_texpool->owner = NULL;
+	mod_texpool->size = mod_texpoolsize;
+	mod_texpool->lastframe = 0;
+	mod_texrover = mod_texpool;
+}
+
+/*
+===============
+Mod_TexPoolAlloc
+
+Takes size bytes at the rover, evicting what is in the way. Unless forced,
+a run is restarted past any block used in the last two frames and NULL is
+returned once the rover comes around.
+===============
+*/
+static texblock_t *Mod_TexPoolAlloc (int size, qboolean force)
+{
+	texblock_t	*start, *b, *next, *nb;
+	int			total;
+	qboolean	wrapped;
+
+	size = TEXBLOCK_SIZE(size);
+	if (size > mod_texpoolsize)
+		Sys_Error ("Mod_TexPoolAlloc: %i is bigger than the pool", size);
+
+	start = mod_texrover;
+	wrapped = false;
+	while (1)
+	{
+		total = 0;
+		for (b=start ; b && total < size ; b=b->next)
+		{
+			if (!force && b->owner && b->lastframe >= r_framecount - 1)
+				break;
+			total += b->size;
+		}
+		if (total >= size)
+			break;
+
+		start = b ? b->next : NULL;
+		if (!start)
+		{
+			if (wrapped)
+				return NULL;
+			start = mod_texpool;
+			wrapped = true;
+		}
+		if (wrapped && start >= mod_texrover)
+			return NULL;
+	}
+
+// evict the run and merge it
+	for (nb=start ; nb != b ; nb=next)
+	{
+		next = nb->next;
+		if (nb->owner)
+		{
+			*nb->owner = NULL;
+			mod_texevicts++;
+		}
+	}
+	start->next = b;
+	start->size = total;
+	start->owner = NULL;
+
+	if (total - size >= TEXBLOCK_MIN)
+	{
+		nb = (texblock_t *)((byte *)start + size);
+		nb->next = b;
+		nb->owner = NULL;
+		nb->size = total - size;
+		nb->lastframe = 0;
+		start->next = nb;
+		start->size = size;
+	}
+
+	mod_texrover = start->next ? start->next : mod_texpool;
+	return start;
+}
+
+/*
+===============
+Mod_FetchMip
+===============
+*/
+static byte *Mod_FetchMip (texture_t *tx, int mip, qboolean force)
+{
+	texblock_t	*b;
+	int			size;
+
+	size = (tx->width >> mip) * (tx->height >> mip);
+	b = Mod_TexPoolAlloc (size, false);
+	if (!b)
+	{
+		if (!force)
+			return NULL;
+		mod_texforced++;
+		b = Mod_TexPoolAlloc (size, true);
+	}
+	b->owner = &tx->mips[mip];
+	b->lastframe = r_framecount;
+	tx->mips[mip] = (byte *)(b + 1);
+
+	Sys_FileSeek (mod_texhandle, tx->fileofs + tx->offsets[mip]);
+	if (Sys_FileRead (mod_texhandle, tx->mips[mip], size) != size)
+		Sys_Error ("Mod_FetchMip: couldn't read %s", tx->name);
+
+	mod_texfetches++;
+	mod_texbytes += size;
+	return tx->mips[mip];
+}
+
+/*
+===============
+Mod_TextureMip
+===============
+*/
+byte *Mod_TextureMip (texture_t *tx, int mip)
+{
+	if (!tx->mips[mip])
+		return Mod_FetchMip (tx, mip, true);
+
+	if (tx->fileofs)
+		((texblock_t *)tx->mips[mip] - 1)->lastframe = r_framecount;
+	return tx->mips[mip];
+}
+
+static void Mod_WantTexture (texture_t *tx, int mip)
+{
+	int		count;
+
+	for (count=0 ; tx && count<10 ; tx=tx->anim_next, count++)
+	{
+		if (mip < tx->wantmip)
+			tx->wantmip = mip;
+		if (tx->alternate_anims && mip < tx->alternate_anims->wantmip)
+			tx->alternate_anims->wantmip = mip;
+	}
+}
+
+/*
+===============
+Mod_PrefetchTextures
+
+Queues the textures of the surfaces in the PVS that are not resident,
+nearest mip levels first. Called by R_MarkLeaves when the leaf changes.
+===============
+*/
+void Mod_PrefetchTextures (model_t *model, byte *vis)
+{
+	int			i, j, mip;
+	float		d, dist;
+	mleaf_t		*leaf;
+	msurface_t	*surf;
+	texture_t	*tx;
+
+	mod_numprefetch = mod_prefetchnext = 0;
+	if (!mod_texpool || !r_texprefetch.value || !model->textures)
+		return;
+
+	for (i=0 ; i<model->numtextures ; i++)
+		if (model->textures[i])
+			model->textures[i]->wantmip = MIPLEVELS;
+
+	for (i=0 ; i<model->numleafs ; i++)
+	{
+		if (!(vis[i>>3] & (1<<(i&7))))
+			continue;
+		leaf = &model->leafs[i+1];
+
+	// distance to the nearest point of the leaf
+		dist = 0;
+		for (j=0 ; j<3 ; j++)
+		{
+			if (r_origin[j] < leaf->minmaxs[j])
+				d = leaf->minmaxs[j] - r_origin[j];
+			else if (r_origin[j] > leaf->minmaxs[3+j])
+				d = r_origin[j] - leaf->minmaxs[3+j];
+			else
+				continue;
+			dist += d*d;
+		}
+		if (dist < 384*384)
+			mip = 0;
+		else if (dist < 768*768)
+			mip = 1;
+		else if (dist < 1536*1536)
+			mip = 2;
+		else
+			mip = 3;
+
+		for (j=0 ; j<leaf->nummarksurfaces ; j++)
+		{
+			surf = model->surfaces + leaf->firstmarksurface[j];
+			Mod_WantTexture (surf->texinfo->texture, (surf->flags & SURF_DRAWTURB) ? 0 : mip);
+		}
+	}
+
+	for (mip=0 ; mip<MIPLEVELS ; mip++)
+		for (i=0 ; i<model->numtextures ; i++)
+		{
+			tx = model->textures[i];
+			if (tx && tx->fileofs && tx->wantmip == mip && !tx->mips[mip])
+				mod_prefetch[mod_numprefetch++] = tx;
+		}
+}
+
+/*
+===============
+Mod_PrefetchStep
+
+reads up to r_texprefetch bytes of the queue, without pushing out
+anything that is on screen
+===============
+*/
+void Mod_PrefetchStep (void)
+{
+	int			budget;
+	texture_t	*tx;
+
+	budget = r_texprefetch.value;
+	while (budget > 0 && mod_prefetchnext < mod_numprefetch)
+	{
+		tx = mod_prefetch[mod_prefetchnext];
+		if (!tx->mips[tx->wantmip])
+		{
+			if (!Mod_FetchMip (tx, tx->wantmip, false))
+				return;		// the pool is all in use, try next frame
+			budget -= (tx->width >> tx->wantmip) * (tx->height >> tx->wantmip);
+		}
+		mod_prefetchnext++;
+	}
+}
+
+/*
+===============
+Mod_TexPool_f
+===============
+*/
+static void Mod_TexPool_f (void)
+{
+	texblock_t	*b;
+	int			used, blocks;
+
+	if (!mod_texpool)
+	{
+		Con_Printf ("texture pool is off\n");
+		return;
+	}
+
+	used = blocks = 0;
+	for (b=mod_texpool ; b ; b=b->next)
+		if (b->owner)
+		{
+			used += b->size;
+			blocks++;
+		}
+	Con_Printf ("texture pool: %iK of %iK in %i mips\n", used >> 10, mod_texpoolsize >> 10, blocks);
+	Con_Printf ("%i reads, %iK, %i evicted, %i forced\n", mod_texfetches,
+			mod_texbytes >> 10, mod_texevicts, mod_texforced);
+	Con_Printf ("prefetch: %i of %i queued\n", mod_prefetchnext, mod_numprefetch);
+}
+
 /*
 ===============
 Mod_Init
@@ -51,7 +585,34 @@ Mod_Init
 */
 void Mod_Init (void)
 {
+	int		i;
+
 	memset (mod_novis, 0xff, sizeof(mod_novis));
+
+	mod_retainedsize = RETAINED_DEFAULT*1024;
+	i = COM_CheckParm ("-modcache");
+	if (i && i < com_argc-1)
+		mod_retainedsize = Q_atoi (com_argv[i+1]) * 1024;
+	if (mod_retainedsize > 0)
+		mod_retained = Hunk_AllocName (mod_retainedsize, "retained");
+	else
+		mod_retainedsize = 0;
+
+	mod_texpoolsize = TEXPOOL_DEFAULT*1024;
+	i = COM_CheckParm ("-texpool");
+	if (i && i < com_argc-1)
+		mod_texpoolsize = Q_atoi (com_argv[i+1]) * 1024;
+	if (mod_texpoolsize > 0)
+	{
+		mod_texpool = Hunk_AllocName (mod_texpoolsize, "texpool");
+		Mod_TexPoolFlush ();
+	}
+	else
+		mod_texpoolsize = 0;
+
+	Cvar_RegisterVariable (&r_texprefetch);
+	Cmd_AddCommand ("modelcache", Mod_ModelCache_f);
+	Cmd_AddCommand ("texpool", Mod_TexPool_f);
 }
 
 /*
@@ -65,12 +626,17 @@ void *Mod_Extradata (model_t *mod)
 {
 	void	*r;
 	
+	if (mod->retained)
+		return Mod_RetainedData (mod->retained - 1);
+
 	r = Cache_Check (&mod->cache);
 	if (r)
 		return r;
 
 	Mod_LoadModel (mod, true);
 	
+	if (mod->retained)
+		return Mod_RetainedData (mod->retained - 1);
 	if (!mod->cache.data)
 		Sys_Error ("Mod_Extradata: caching failed");
 	return mod->cache.data;
@@ -176,6 +742,13 @@ void Mod_ClearAll (void)
 //FIX FOR CACHE_ALLOC ERRORS:
 		if (mod->type == mod_sprite) mod->cache.data = NULL;
 	}
+
+	Mod_TexPoolFlush ();
+
+// the next map takes its own references
+	mod_mapcount++;
+	for (i=0 ; i<mod_numretained ; i++)
+		mod_retainedents[mod_retainedorder[i]].refs = 0;
 }
 
 /*
@@ -212,6 +785,8 @@ model_t *Mod_FindName (char *name)
 			if (avail)
 			{
 				mod = avail;
+				if (mod->retained)
+					Mod_RetainedFree (mod->retained - 1);
 				if (mod->type == mod_alias)
 					if (Cache_Check (&mod->cache))
 						Cache_Free (&mod->cache);
@@ -242,7 +817,7 @@ void Mod_TouchModel (char *name)
 	
 	if (mod->needload == NL_PRESENT)
 	{
-		if (mod->type == mod_alias)
+		if (mod->type == mod_alias && !mod->retained)
 			Cache_Check (&mod->cache);
 	}
 }
@@ -258,8 +833,14 @@ model_t *Mod_LoadModel (model_t *mod, qboolean crash)
 {
 	if (mod->type == mod_alias)
 	{
-		if (Cache_Check (&mod->cache))
+		if (mod->retained || Cache_Check (&mod->cache))
 		{
+			if (mod->needload != NL_PRESENT)
+			{
+				mod_hits[RT_ALIAS]++;
+				if (mod->retained)
+					Mod_RetainedRef (mod->retained - 1);
+			}
 			mod->needload = NL_PRESENT;
 			return mod;
 		}
@@ -349,6 +930,16 @@ model_t *Mod_ForName (char *name, qboolean crash)
 __psram_bss ("model") byte	*mod_base;
 
 
+static unsigned short Mod_TextureCRC (byte *data, int count)
+{
+	unsigned short	crc;
+
+	CRC_Init (&crc);
+	while (count--)
+		CRC_ProcessByte (&crc, *data++);
+	return CRC_Value (crc);
+}
+
 /*
 =================
 Mod_LoadTextures
@@ -356,12 +947,15 @@ Mod_LoadTextures
 */
 void Mod_LoadTextures (lump_t *l)
 {
-	int		i, j, pixels, num, max, altmax;
+	int		i, j, pixels, num, max, altmax, ent;
+	unsigned short	crc;
 	miptex_t	*mt;
 	texture_t	*tx, *tx2;
 	texture_t	*anims[10];
 	texture_t	*altanims[10];
 	dmiptexlump_t *m;
+	qboolean	lazy;
+	int			filestart;
 
 	if (!l->filelen)
 	{
@@ -369,6 +963,17 @@ void Mod_LoadTextures (lump_t *l)
 		return;
 	}
 	m = (dmiptexlump_t *)(mod_base + l->fileofs);
+
+// the world is the first brush model of a map, its textures are paged in
+// from the file it stays open on; the b_ models are small enough to load
+	lazy = false;
+	filestart = 0;
+	if (mod_texpool && mod_texhandle == -1)
+	{
+		COM_OpenFile (loadmodel->name, &mod_texhandle);
+		lazy = mod_texhandle != -1;
+		filestart = com_filestart;
+	}
 	
 	m->nummiptex = LittleLong (m->nummiptex);
 	
@@ -389,7 +994,43 @@ void Mod_LoadTextures (lump_t *l)
 		if ( (mt->width & 15) || (mt->height & 15) )
 			Sys_Error ("Texture %s is not 16 aligned", mt->name);
 		pixels = mt->width*mt->height/64*85;
-		tx = Hunk_AllocName (sizeof(texture_t) +pixels, loadname );
+
+	// a mip that would not fit in the pool is loaded with the map instead
+		if (lazy && Q_strncmp(mt->name,"sky",3)
+		&& TEXBLOCK_SIZE(mt->width*mt->height) <= mod_texpoolsize)
+		{
+			tx = Hunk_AllocName (sizeof(texture_t), loadname);
+			loadmodel->textures[i] = tx;
+			memcpy (tx->name, mt->name, sizeof(tx->name));
+			tx->width = mt->width;
+			tx->height = mt->height;
+			for (j=0 ; j<MIPLEVELS ; j++)
+				tx->offsets[j] = mt->offsets[j] + sizeof(texture_t) - sizeof(miptex_t);
+			tx->fileofs = filestart + ((byte *)mt - mod_base) + sizeof(miptex_t) - sizeof(texture_t);
+			continue;
+		}
+
+	// shared with an earlier map?
+		crc = Mod_TextureCRC ((byte *)(mt+1), pixels);
+		tx = Mod_RetainedTexture (mt->name, crc, sizeof(texture_t) + pixels);
+		if (tx)
+		{
+			mod_hits[RT_TEXTURE]++;
+			loadmodel->textures[i] = tx;
+			if (!Q_strncmp(mt->name,"sky",3))	
+				R_InitSky (tx);
+			continue;
+		}
+		mod_misses[RT_TEXTURE]++;
+
+		ent = Mod_RetainedAlloc (RT_TEXTURE, mt->name, crc, sizeof(texture_t) + pixels);
+		if (ent >= 0)
+		{
+			tx = Mod_RetainedData (ent);
+			memset (tx, 0, sizeof(texture_t));
+		}
+		else
+			tx = Hunk_AllocName (sizeof(texture_t) +pixels, loadname );
 		loadmodel->textures[i] = tx;
 
 		memcpy (tx->name, mt->name, sizeof(tx->name));
@@ -399,6 +1040,8 @@ void Mod_LoadTextures (lump_t *l)
 			tx->offsets[j] = mt->offsets[j] + sizeof(texture_t) - sizeof(miptex_t);
 		// the pixels immediately follow the structures
 		memcpy ( tx+1, mt+1, pixels);
+		for (j=0 ; j<MIPLEVELS ; j++)
+			tx->mips[j] = (byte *)tx + tx->offsets[j];
 		
 		if (!Q_strncmp(mt->name,"sky",3))	
 			R_InitSky (tx);
@@ -937,6 +1580,21 @@ void Mod_LoadLeafs (lump_t *l)
 	}	
 }
 
+/*
+=================
+Mod_PackClipnode
+
+Copies the splitting plane into the clipnode itself
+=================
+*/
+void Mod_PackClipnode (mclipnode_t *out, mplane_t *plane)
+{
+	VectorCopy (plane->normal, out->normal);
+	out->dist = plane->dist;
+	out->type = plane->type;
+	out->pad[0] = out->pad[1] = out->pad[2] = 0;
+}
+
 /*
 =================
 Mod_LoadClipnodes
@@ -944,7 +1602,9 @@ Mod_LoadClipnodes
 */
 void Mod_LoadClipnodes (lump_t *l)
 {
-	dclipnode_t *in, *out;
+	dclipnode_t *in;
+	mclipnode_t	*out;
+	mplane_t	*plane;
 	int			i, count;
 	hull_t		*hull;
 
@@ -961,7 +1621,6 @@ void Mod_LoadClipnodes (lump_t *l)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 	hull->clip_mins[0] = -16;
 	hull->clip_mins[1] = -16;
 	hull->clip_mins[2] = -24;
@@ -973,7 +1632,6 @@ void Mod_LoadClipnodes (lump_t *l)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 	hull->clip_mins[0] = -32;
 	hull->clip_mins[1] = -32;
 	hull->clip_mins[2] = -24;
@@ -983,7 +1641,8 @@ void Mod_LoadClipnodes (lump_t *l)
 
 	for (i=0 ; i<count ; i++, out++, in++)
 	{
-		out->planenum = LittleLong(in->planenum);
+		plane = loadmodel->planes + LittleLong(in->planenum);
+		Mod_PackClipnode (out, plane);
 		out->children[0] = LittleShort(in->children[0]);
 		out->children[1] = LittleShort(in->children[1]);
 	}
@@ -999,7 +1658,7 @@ Deplicate the drawing hull structure as a clipping hull
 void Mod_MakeHull0 (void)
 {
 	mnode_t		*in, *child;
-	dclipnode_t *out;
+	mclipnode_t *out;
 	int			i, j, count;
 	hull_t		*hull;
 	
@@ -1012,11 +1671,10 @@ void Mod_MakeHull0 (void)
 	hull->clipnodes = out;
 	hull->firstclipnode = 0;
 	hull->lastclipnode = count-1;
-	hull->planes = loadmodel->planes;
 
 	for (i=0 ; i<count ; i++, out++, in++)
 	{
-		out->planenum = in->plane - loadmodel->planes;
+		Mod_PackClipnode (out, in->plane);
 		for (j=0 ; j<2 ; j++)
 		{
 			child = in->children[j];
@@ -1420,6 +2078,190 @@ void * Mod_LoadAliasSkinGroup (void * pin, int *pskinindex, int skinsize,
 }
 
 
+/*
+=================
+Mod_AliasFrameVerts
+
+first vertex set of frame i, for a group the first frame of the group
+=================
+*/
+static trivertx_t *Mod_AliasFrameVerts (aliashdr_t *pheader, int i)
+{
+	maliasgroup_t	*paliasgroup;
+
+	if (pheader->frames[i].type == ALIAS_SINGLE)
+		return (trivertx_t *)((byte *)pheader + pheader->frames[i].frame);
+
+	paliasgroup = (maliasgroup_t *)((byte *)pheader + pheader->frames[i].frame);
+	return (trivertx_t *)((byte *)pheader + paliasgroup->frames[0].frame);
+}
+
+/*
+=================
+Mod_AliasVertsStayClose
+
+true if verts a and b are less than cell apart on every axis in every
+frame, so merging them can't tear an animation apart
+=================
+*/
+static qboolean Mod_AliasVertsStayClose (aliashdr_t *pheader, mdl_t *pmodel,
+	int a, int b, int cell)
+{
+	int				i, j, k;
+	trivertx_t		*pverts;
+	maliasgroup_t	*paliasgroup;
+
+	for (i=0 ; i<pmodel->numframes ; i++)
+	{
+		if (pheader->frames[i].type == ALIAS_SINGLE)
+		{
+			pverts = (trivertx_t *)((byte *)pheader + pheader->frames[i].frame);
+			for (k=0 ; k<3 ; k++)
+				if (abs (pverts[a].v[k] - pverts[b].v[k]) >= cell)
+					return false;
+			continue;
+		}
+
+		paliasgroup = (maliasgroup_t *)((byte *)pheader + pheader->frames[i].frame);
+		for (j=0 ; j<paliasgroup->numframes ; j++)
+		{
+			pverts = (trivertx_t *)((byte *)pheader + paliasgroup->frames[j].frame);
+			for (k=0 ; k<3 ; k++)
+				if (abs (pverts[a].v[k] - pverts[b].v[k]) >= cell)
+					return false;
+		}
+	}
+
+	return true;
+}
+
+static __psram_bss ("model") short	lodmap[MAXALIASVERTS];
+static __psram_bss ("model") short	lodreps[MAXALIASVERTS];
+
+/*
+=================
+Mod_LoadAliasLod
+
+Vertex clustering on a grid of cell units in the compressed vertex space.
+Verts only merge when they share a grid cell in the first frame, stay
+within a cell of each other in all frames, have the same onseam flag and
+map to nearby skin texels, so skin seams are left alone. Triangles that
+collapse are dropped. Returns false if the level saves less than a
+quarter of maxtris.
+=================
+*/
+static qboolean Mod_LoadAliasLod (aliashdr_t *pheader, mdl_t *pmodel,
+	maliaslod_t *plod, int cell, int maxtris)
+{
+	int				i, j, r, numreps, numtris;
+	int				stol, ttol;
+	trivertx_t		*pbase, *pv, *prep;
+	stvert_t		*pstverts, *plodstverts;
+	mtriangle_t		*ptri, *plodtri;
+	unsigned short	*pvertmap;
+
+	pbase = Mod_AliasFrameVerts (pheader, 0);
+	pstverts = (stvert_t *)((byte *)pheader + pheader->stverts);
+	ptri = (mtriangle_t *)((byte *)pheader + pheader->triangles);
+
+// texel tolerance scales with the cell, s and t are 16.16
+	stol = (cell * pmodel->skinwidth / 256) << 16;
+	ttol = (cell * pmodel->skinheight / 256) << 16;
+
+	numreps = 0;
+	for (i=0 ; i<pmodel->numverts ; i++)
+	{
+		pv = &pbase[i];
+		for (r=0 ; r<numreps ; r++)
+		{
+			prep = &pbase[lodreps[r]];
+			if (pv->v[0] / cell != prep->v[0] / cell ||
+				pv->v[1] / cell != prep->v[1] / cell ||
+				pv->v[2] / cell != prep->v[2] / cell)
+				continue;
+			if (pstverts[i].onseam != pstverts[lodreps[r]].onseam)
+				continue;
+			if (abs (pstverts[i].s - pstverts[lodreps[r]].s) > stol ||
+				abs (pstverts[i].t - pstverts[lodreps[r]].t) > ttol)
+				continue;
+			if (!Mod_AliasVertsStayClose (pheader, pmodel, i, lodreps[r], cell))
+				continue;
+			break;
+		}
+
+		if (r == numreps)
+			lodreps[numreps++] = i;
+		lodmap[i] = r;
+	}
+
+	numtris = 0;
+	for (i=0 ; i<pmodel->numtris ; i++)
+	{
+		if (lodmap[ptri[i].vertindex[0]] != lodmap[ptri[i].vertindex[1]] &&
+			lodmap[ptri[i].vertindex[1]] != lodmap[ptri[i].vertindex[2]] &&
+			lodmap[ptri[i].vertindex[2]] != lodmap[ptri[i].vertindex[0]])
+			numtris++;
+	}
+
+	if (!numtris || numtris > maxtris - maxtris / 4)
+		return false;
+
+	pvertmap = Hunk_AllocName (numreps * sizeof(*pvertmap), loadname);
+	plodstverts = Hunk_AllocName (numreps * sizeof(*plodstverts), loadname);
+	plodtri = Hunk_AllocName (numtris * sizeof(*plodtri), loadname);
+
+	plod->numverts = numreps;
+	plod->numtris = numtris;
+	plod->vertmap = (byte *)pvertmap - (byte *)pheader;
+	plod->stverts = (byte *)plodstverts - (byte *)pheader;
+	plod->triangles = (byte *)plodtri - (byte *)pheader;
+
+	for (r=0 ; r<numreps ; r++)
+	{
+		pvertmap[r] = lodreps[r];
+		plodstverts[r] = pstverts[lodreps[r]];
+	}
+
+	for (i=0 ; i<pmodel->numtris ; i++)
+	{
+		if (lodmap[ptri[i].vertindex[0]] == lodmap[ptri[i].vertindex[1]] ||
+			lodmap[ptri[i].vertindex[1]] == lodmap[ptri[i].vertindex[2]] ||
+			lodmap[ptri[i].vertindex[2]] == lodmap[ptri[i].vertindex[0]])
+			continue;
+
+		plodtri->facesfront = ptri[i].facesfront;
+		for (j=0 ; j<3 ; j++)
+			plodtri->vertindex[j] = lodmap[ptri[i].vertindex[j]];
+		plodtri++;
+	}
+
+	return true;
+}
+
+/*
+=================
+Mod_LoadAliasLods
+
+up to MAX_ALIAS_LODS progressively coarser meshes for distant models
+=================
+*/
+static void Mod_LoadAliasLods (aliashdr_t *pheader, mdl_t *pmodel)
+{
+	static const int	lodcells[MAX_ALIAS_LODS] = { 12, 24 };
+	int					i, maxtris;
+
+	pheader->numlods = 0;
+	maxtris = pmodel->numtris;
+
+	for (i=0 ; i<MAX_ALIAS_LODS ; i++)
+	{
+		if (!Mod_LoadAliasLod (pheader, pmodel, &pheader->lods[i], lodcells[i], maxtris))
+			break;
+		maxtris = pheader->lods[i].numtris;
+		pheader->numlods++;
+	}
+}
+
 /*
 =================
 Mod_LoadAliasModel
@@ -1439,8 +2281,9 @@ void Mod_LoadAliasModel (model_t *mod, void *buffer)
 	daliasskintype_t	*pskintype;
 	maliasskindesc_t	*pskindesc;
 	int					skinsize;
-	int					start, end, total;
+	int					start, end, total, ent;
 	
+	mod_misses[RT_ALIAS]++;
 	start = Hunk_LowMark ();
 
 	pinmodel = (mdl_t *)buffer;
@@ -1625,6 +2468,11 @@ void Mod_LoadAliasModel (model_t *mod, void *buffer)
 		}
 	}
 
+//
+// build the distance meshes
+//
+	Mod_LoadAliasLods (pheader, pmodel);
+
 	mod->type = mod_alias;
 
 // FIXME: do this right
@@ -1637,6 +2485,15 @@ void Mod_LoadAliasModel (model_t *mod, void *buffer)
 	end = Hunk_LowMark ();
 	total = end - start;
 	
+	ent = Mod_RetainedAlloc (RT_ALIAS, mod->name, 0, total);
+	if (ent >= 0)
+	{
+		mod->retained = ent + 1;
+		memcpy (Mod_RetainedData (ent), pheader, total);
+		Hunk_FreeToLowMark (start);
+		return;
+	}
+
 	Cache_Alloc (&mod->cache, total, loadname);
 	if (!mod->cache.data)
 		return;
@@ -1832,7 +2689,7 @@ void Mod_Print (void)
 	Con_Printf ("Cached models:\n");
 	for (i=0, mod=mod_known ; i < mod_numknown ; i++, mod++)
 	{
-		Con_Printf ("%8p : %s",mod->cache.data, mod->name);
+		Con_Printf ("%8p : %s", mod->retained ? Mod_RetainedData (mod->retained - 1) : mod->cache.data, mod->name);
 		if (mod->needload & NL_UNREFERENCED)
 			Con_Printf (" (!R)");
 		if (mod->needload & NL_NEEDS_LOADED)
@@ -74,6 +74,9 @@ typedef struct texture_s
 	struct texture_s *anim_next;		// in the animation sequence
 	struct texture_s *alternate_anims;	// bmodels in frmae 1 use these
 	unsigned	offsets[MIPLEVELS];		// four mip maps stored
+	byte		*mips[MIPLEVELS];		// only access through Mod_TextureMip
+	int			fileofs;				// lazy: map file position offsets are from
+	int			wantmip;				// finest mip the PVS needs, for prefetch
 } texture_t;
 
 
@@ -164,11 +167,21 @@ typedef struct mleaf_s
 	byte		ambient_sound_level[NUM_AMBIENTS];
 } mleaf_t;
 
+// clipping hull node with its plane inlined, so a hull walk touches one
+// record per node instead of a dclipnode_t plus a random mplane_t fetch
+typedef struct
+{
+	vec3_t		normal;
+	float		dist;
+	short		children[2];	// negative numbers are contents
+	byte		type;			// plane type, < 3 is axial
+	byte		pad[3];
+} mclipnode_t;
+
 // !!! if this is changed, it must be changed in asm_i386.h too !!!
 typedef struct
 {
-	dclipnode_t	*clipnodes;
-	mplane_t	*planes;
+	mclipnode_t	*clipnodes;
 	int			firstclipnode;
 	int			lastclipnode;
 	vec3_t		clip_mins;
@@ -271,11 +284,26 @@ typedef struct mtriangle_s {
 	int					vertindex[3];
 } mtriangle_t;
 
+// a reduced mesh built at load time. It reuses the frame vertices through
+// vertmap, so only stverts and triangles are stored per level
+#define	MAX_ALIAS_LODS	2
+
+typedef struct
+{
+	int					numverts;
+	int					numtris;
+	int					vertmap;		// unsigned short[numverts], into the frame verts
+	int					stverts;
+	int					triangles;
+} maliaslod_t;
+
 typedef struct {
 	int					model;
 	int					stverts;
 	int					skindesc;
 	int					triangles;
+	int					numlods;
+	maliaslod_t			lods[MAX_ALIAS_LODS];
 	maliasframedesc_t	frames[1];
 } aliashdr_t;
 
@@ -347,7 +375,7 @@ typedef struct model_s
 	int			*surfedges;
 
 	int			numclipnodes;
-	dclipnode_t	*clipnodes;
+	mclipnode_t	*clipnodes;
 
 	int			nummarksurfaces;
 	uint16_t	*marksurfaces;
@@ -366,6 +394,7 @@ typedef struct model_s
 // additional model data
 //
 	cache_user_t	cache;		// only access through Mod_Extradata
+	int				retained;	// 1 + retained entry holding it instead, or 0
 
 } model_t;
 
@@ -377,6 +406,10 @@ model_t *Mod_ForName (char *name, qboolean crash);
 void	*Mod_Extradata (model_t *mod);	// handles caching
 void	Mod_TouchModel (char *name);
 
+byte	*Mod_TextureMip (texture_t *tx, int mip);	// pages lazy textures in
+void	Mod_PrefetchTextures (model_t *model, byte *vis);
+void	Mod_PrefetchStep (void);
+
 mleaf_t *Mod_PointInLeaf (float *p, model_t *model);
 byte	*Mod_LeafPVS (mleaf_t *leaf, model_t *model);
 
@@ -0,0 +1,366 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// pcprof.c -- sampled profile of a timedemo, input of tools/placement.py
+
+#include "quakedef.h"
+#include "pcprof.h"
+
+#if defined(PCPROF) || defined(PCPROF_INSTRUMENT)
+
+#define NO_INSTRUMENT	__attribute__((no_instrument_function))
+
+cvar_t	pcprof_hz = {"pcprof_hz", "2000"};
+
+static qboolean	pcprof_armed;
+static char		pcprof_name[MAX_OSPATH];
+static volatile qboolean	pcprof_running;
+
+static int		pcprof_file = -1;
+static char		pcprof_line[4096];
+static int		pcprof_linelen;
+
+static void NO_INSTRUMENT PCProf_Printf (char *fmt, ...)
+{
+	va_list		argptr;
+
+	if (pcprof_linelen > sizeof(pcprof_line) - 128)
+	{
+		Sys_FileWrite (pcprof_file, pcprof_line, pcprof_linelen);
+		pcprof_linelen = 0;
+	}
+	va_start (argptr, fmt);
+	pcprof_linelen += vsnprintf (pcprof_line + pcprof_linelen,
+			sizeof(pcprof_line) - pcprof_linelen, fmt, argptr);
+	va_end (argptr);
+}
+
+static qboolean NO_INSTRUMENT PCProf_Open (char *target)
+{
+	pcprof_file = Sys_FileOpenWrite (pcprof_name);
+	if (pcprof_file == -1)
+	{
+		Con_Printf ("ERROR: couldn't open %s\n", pcprof_name);
+		return false;
+	}
+	pcprof_linelen = 0;
+	PCProf_Printf ("pcprof 1 %s\n", target);
+	PCProf_Printf ("anchor PCProf_Begin %lx\n", (unsigned long)(uintptr_t)PCProf_Begin);
+	return true;
+}
+
+static void NO_INSTRUMENT PCProf_Close (void)
+{
+	Sys_FileWrite (pcprof_file, pcprof_line, pcprof_linelen);
+	Sys_FileClose (pcprof_file);
+	pcprof_file = -1;
+}
+
+#ifdef PCPROF_INSTRUMENT
+/*
+==============================================================================
+
+HOST INSTRUMENTATION
+
+Every function entry and exit closes an interval, the time is charged to
+the function on top of the shadow stack.
+
+==============================================================================
+*/
+
+#include <time.h>
+
+#define PCPROF_FUNCS	8192		// power of two
+#define PCPROF_DEPTH	256
+
+typedef struct
+{
+	void		*fn;
+	uint64_t	usec;
+} pcproffunc_t;
+
+static pcproffunc_t	pcprof_funcs[PCPROF_FUNCS];
+static void			*pcprof_stack[PCPROF_DEPTH];
+static int			pcprof_depth;
+static uint64_t		pcprof_last;
+
+static uint64_t NO_INSTRUMENT PCProf_Usec (void)
+{
+	struct timespec	ts;
+
+	clock_gettime (CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void NO_INSTRUMENT PCProf_Charge (void)
+{
+	uint64_t		now;
+	unsigned		h;
+	void			*fn;
+
+	now = PCProf_Usec ();
+	if (pcprof_running && pcprof_depth > 0 && pcprof_depth <= PCPROF_DEPTH)
+	{
+		fn = pcprof_stack[pcprof_depth-1];
+		h = ((uintptr_t)fn >> 2) * 2654435761u;
+		for (h &= PCPROF_FUNCS-1 ; ; h = (h+1) & (PCPROF_FUNCS-1))
+		{
+			if (pcprof_funcs[h].fn == fn)
+				break;
+			if (!pcprof_funcs[h].fn)
+			{
+				pcprof_funcs[h].fn = fn;
+				break;
+			}
+		}
+		pcprof_funcs[h].usec += now - pcprof_last;
+	}
+	pcprof_last = now;
+}
+
+void NO_INSTRUMENT __cyg_profile_func_enter (void *fn, void *site)
+{
+	PCProf_Charge ();
+	if (pcprof_depth < PCPROF_DEPTH)
+		pcprof_stack[pcprof_depth] = fn;
+	pcprof_depth++;
+}
+
+void NO_INSTRUMENT __cyg_profile_func_exit (void *fn, void *site)
+{
+	PCProf_Charge ();
+	if (pcprof_depth > 0)
+		pcprof_depth--;
+}
+
+static void NO_INSTRUMENT PCProf_Start (void)
+{
+	memset (pcprof_funcs, 0, sizeof(pcprof_funcs));
+	pcprof_last = PCProf_Usec ();
+	pcprof_running = true;
+}
+
+static void NO_INSTRUMENT PCProf_Write (void)
+{
+	int		i;
+
+	pcprof_running = false;
+	if (!PCProf_Open ("host"))
+		return;
+	for (i=0 ; i<PCPROF_FUNCS ; i++)
+		if (pcprof_funcs[i].fn && pcprof_funcs[i].usec)
+			PCProf_Printf ("code %lx %lu\n", (unsigned long)(uintptr_t)pcprof_funcs[i].fn,
+					(unsigned long)pcprof_funcs[i].usec);
+	PCProf_Close ();
+	Con_Printf ("wrote %s\n", pcprof_name);
+}
+
+#else
+/*
+==============================================================================
+
+DEVICE SAMPLING
+
+The SysTick interrupt keeps the pc and r0-r3/r12 of core 0. When the
+buffer fills every other sample is dropped and only every second tick is
+kept from then on, so a long demo stays evenly covered.
+
+==============================================================================
+*/
+
+#define PCPROF_SAMPLES	32768
+
+typedef struct
+{
+	uint32_t	pc;
+	uint32_t	regs[5];		// r0-r3, r12
+} pcsample_t;
+
+static __psram_bss("pcprof") pcsample_t	pcprof_samples[PCPROF_SAMPLES];
+static volatile int	pcprof_count;
+static int			pcprof_stride, pcprof_tick;
+
+static void __not_in_flash_func(PCProf_Sample) (const uint32_t *frame)
+{
+	pcsample_t	*s;
+	int			i;
+
+	if (!pcprof_running || ++pcprof_tick < pcprof_stride)
+		return;
+	pcprof_tick = 0;
+
+	if (pcprof_count == PCPROF_SAMPLES)
+	{
+		for (i=0 ; i<PCPROF_SAMPLES/2 ; i++)
+			pcprof_samples[i] = pcprof_samples[i*2];
+		pcprof_count = PCPROF_SAMPLES/2;
+		pcprof_stride *= 2;
+	}
+
+	s = &pcprof_samples[pcprof_count++];
+	s->pc = frame[6];
+	s->regs[0] = frame[0];
+	s->regs[1] = frame[1];
+	s->regs[2] = frame[2];
+	s->regs[3] = frame[3];
+	s->regs[4] = frame[4];
+}
+
+static void PCProf_Start (void)
+{
+	pcprof_count = 0;
+	pcprof_stride = 1;
+	pcprof_tick = 0;
+	pcprof_running = true;
+	Sys_StartSampler ((int)pcprof_hz.value, PCProf_Sample);
+}
+
+static int PCProf_ComparePC (const void *a, const void *b)
+{
+	uint32_t	x = ((const pcsample_t *)a)->pc;
+	uint32_t	y = ((const pcsample_t *)b)->pc;
+
+	return x < y ? -1 : x > y;
+}
+
+static int PCProf_Compare (const void *a, const void *b)
+{
+	uint32_t	x = *(const uint32_t *)a;
+	uint32_t	y = *(const uint32_t *)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void PCProf_Write (void)
+{
+	uint32_t	*words, r;
+	int			i, j, run, count, numdata;
+
+	pcprof_running = false;
+	Sys_StopSampler ();
+	count = pcprof_count;
+
+	if (!PCProf_Open ("device"))
+		return;
+	PCProf_Printf ("hz %i\n", (int)pcprof_hz.value / pcprof_stride);
+
+	qsort (pcprof_samples, count, sizeof(pcsample_t), PCProf_ComparePC);
+	for (i=0 ; i<count ; i+=run)
+	{
+		for (run=1 ; i+run<count && pcprof_samples[i+run].pc == pcprof_samples[i].pc ; run++)
+			;
+		PCProf_Printf ("code %lx %i\n", (unsigned long)pcprof_samples[i].pc, run);
+	}
+
+// the register values pointing into ram are packed to the front of the
+// buffer, never past the sample they are read from, and sorted there
+	words = (uint32_t *)pcprof_samples;
+	numdata = 0;
+	for (i=0 ; i<count ; i++)
+		for (j=0 ; j<5 ; j++)
+		{
+			r = pcprof_samples[i].regs[j];
+			if ((r >= 0x20000000 && r < 0x20082000) || (r >= 0x11000000 && r < 0x12000000))
+				words[numdata++] = r;
+		}
+	qsort (words, numdata, sizeof(uint32_t), PCProf_Compare);
+	for (i=0 ; i<numdata ; i+=run)
+	{
+		for (run=1 ; i+run<numdata && words[i+run] == words[i] ; run++)
+			;
+		PCProf_Printf ("data %lx %i\n", (unsigned long)words[i], run);
+	}
+
+	PCProf_Close ();
+	Con_Printf ("wrote %s: %i samples\n", pcprof_name, count);
+}
+#endif
+
+/*
+===============
+PCProf_Begin
+
+timedemo started
+===============
+*/
+void NO_INSTRUMENT PCProf_Begin (void)
+{
+	if (!pcprof_armed)
+		return;
+	pcprof_armed = false;
+	PCProf_Start ();
+}
+
+/*
+===============
+PCProf_End
+
+timedemo finished
+===============
+*/
+void NO_INSTRUMENT PCProf_End (void)
+{
+	if (pcprof_running)
+		PCProf_Write ();
+}
+
+/*
+===============
+PCProf_f
+===============
+*/
+static void PCProf_f (void)
+{
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("pcprof <name> : profile the next timedemo\n");
+		return;
+	}
+
+	sprintf (pcprof_name, "%s/%s", com_gamedir, Cmd_Argv(1));
+	COM_DefaultExtension (pcprof_name, ".pcp");
+	pcprof_armed = true;
+}
+
+/*
+===============
+PCProf_Init
+===============
+*/
+void PCProf_Init (void)
+{
+	Cvar_RegisterVariable (&pcprof_hz);
+	Cmd_AddCommand ("pcprof", PCProf_f);
+}
+
+#else
+
+void PCProf_Init (void)
+{
+}
+
+void PCProf_Begin (void)
+{
+}
+
+void PCProf_End (void)
+{
+}
+
+#endif
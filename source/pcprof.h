@@ -0,0 +1,37 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// pcprof.h -- sampled code and data profile of a timedemo
+//
+// "pcprof <name>" arms it, the next timedemo is profiled and written to
+// <gamedir>/<name>.pcp for tools/placement.py. The text file holds
+//
+//   pcprof 1 <device|host>
+//   anchor PCProf_Begin <address>	address of that function in this run
+//   hz <rate>						device only, samples per second kept
+//   code <address> <weight>		sampled pc, or instrumented function
+//   data <address> <weight>		register values pointing into ram
+//
+// The device build (PCPROF) samples the pc and r0-r3/r12 of core 0 from
+// SysTick, the host build (PCPROF_INSTRUMENT, -finstrument-functions)
+// charges the time between calls to the function running, in microseconds.
+
+void PCProf_Init (void);
+void PCProf_Begin (void);
+void PCProf_End (void);
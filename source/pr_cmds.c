@@ -837,6 +837,55 @@ void PF_cvar_set (void)
 	Cvar_Set (var, val);
 }
 
+#define	MAX_FINDRADIUS	128
+
+static edict_t	*findradius_list[MAX_FINDRADIUS];
+
+/*
+=================
+PF_InRadius
+=================
+*/
+static qboolean PF_InRadius (edict_t *ent, float *org, float rad)
+{
+	vec3_t	eorg;
+	int		j;
+
+	if (ent->free || ent->v.solid == SOLID_NOT)
+		return false;
+	for (j=0 ; j<3 ; j++)
+		eorg[j] = org[j] - (ent->v.origin[j] + (ent->v.mins[j] + ent->v.maxs[j])*0.5);			
+	return Length(eorg) <= rad;
+}
+
+/*
+=================
+PF_CheckFindradius
+
+pr_findindex 2 compares the area node result with the full scan
+=================
+*/
+static void PF_CheckFindradius (float *org, float rad, int count)
+{
+	edict_t	*ent;
+	int		i, j;
+
+	j = 0;
+	ent = NEXT_EDICT(sv.edicts);
+	for (i=1 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
+	{
+		if (!PF_InRadius (ent, org, rad))
+			continue;
+		if (j == count || findradius_list[j] != ent)
+			break;
+		j++;
+	}
+
+	if (i < sv.num_edicts || j != count)
+		Con_Printf ("findradius: area nodes differ from the scan at '%5.1f %5.1f %5.1f' %5.1f\n",
+			org[0], org[1], org[2], rad);
+}
+
 /*
 =================
 PF_findradius
@@ -851,26 +900,67 @@ void PF_findradius (void)
 	edict_t	*ent, *chain;
 	float	rad;
 	float	*org;
-	vec3_t	eorg;
-	int		i, j;
+	vec3_t	mins, maxs;
+	int		i, j, count;
 
 	chain = (edict_t *)sv.edicts;
 	
 	org = G_VECTOR(OFS_PARM0);
 	rad = G_FLOAT(OFS_PARM1);
 
-	ent = NEXT_EDICT(sv.edicts);
-	for (i=1 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
+// an edict within the sphere has its center inside its linked box, so only
+// the boxes touching the bounding box of the sphere need a check, and the
+// edicts that moved without a relink (see SV_AreaStale)
+	count = -1;
+	if (pr_findindex.value)
 	{
-		if (ent->free)
-			continue;
-		if (ent->v.solid == SOLID_NOT)
-			continue;
 		for (j=0 ; j<3 ; j++)
-			eorg[j] = org[j] - (ent->v.origin[j] + (ent->v.mins[j] + ent->v.maxs[j])*0.5);			
-		if (Length(eorg) > rad)
-			continue;
-			
+		{
+			mins[j] = org[j] - rad;
+			maxs[j] = org[j] + rad;
+		}
+		count = SV_AreaEdicts (mins, maxs, findradius_list, MAX_FINDRADIUS);
+	}
+
+	if (count < 0)
+	{
+		ent = NEXT_EDICT(sv.edicts);
+		for (i=1 ; i<sv.num_edicts ; i++, ent = NEXT_EDICT(ent))
+		{
+			if (!PF_InRadius (ent, org, rad))
+				continue;
+				
+			ent->v.chain = EDICT_TO_PROG(chain);
+			chain = ent;
+		}
+
+		RETURN_EDICT(chain);
+		return;
+	}
+
+// keep the chain in edict order, like the full scan builds it
+	for (i=1 ; i<count ; i++)
+	{
+		ent = findradius_list[i];
+		for (j=i ; j>0 && findradius_list[j-1] > ent ; j--)
+			findradius_list[j] = findradius_list[j-1];
+		findradius_list[j] = ent;
+	}
+
+	for (i=0, j=0 ; i<count ; i++)
+	{
+		ent = findradius_list[i];
+		if (PF_InRadius (ent, org, rad))
+			findradius_list[j++] = ent;
+	}
+	count = j;
+
+	if (pr_findindex.value == 2)
+		PF_CheckFindradius (org, rad, count);
+
+	for (i=0 ; i<count ; i++)
+	{
+		ent = findradius_list[i];
 		ent->v.chain = EDICT_TO_PROG(chain);
 		chain = ent;
 	}
@@ -932,20 +1022,18 @@ void PF_Remove (void)
 }
 
 
-// entity (entity start, .string field, string match) find = #5;
-void PF_Find (void)
+/*
+=================
+PF_FindScan
+
+The first edict after e whose string field f matches s, or the world
+=================
+*/
+static edict_t *PF_FindScan (int e, int f, char *s)
 {
-	int		e;	
-	int		f;
-	char	*s, *t;
 	edict_t	*ed;
+	char	*t;
 
-	e = G_EDICTNUM(OFS_PARM0);
-	f = G_INT(OFS_PARM1);
-	s = G_STRING(OFS_PARM2);
-	if (!s)
-		PR_RunError ("PF_Find: bad search string");
-		
 	for (e++ ; e < sv.num_edicts ; e++)
 	{
 		ed = EDICT_NUM(e);
@@ -955,13 +1043,41 @@ void PF_Find (void)
 		if (!t)
 			continue;
 		if (!strcmp(t,s))
+			return ed;
+	}
+
+	return sv.edicts;
+}
+
+// entity (entity start, .string field, string match) find = #5;
+void PF_Find (void)
+{
+	int		e;	
+	int		f;
+	char	*s;
+	edict_t	*ed, *found;
+
+	e = G_EDICTNUM(OFS_PARM0);
+	f = G_INT(OFS_PARM1);
+	s = G_STRING(OFS_PARM2);
+	if (!s)
+		PR_RunError ("PF_Find: bad search string");
+
+	if (!ED_FindIndexed (f, s, e, &ed))
+		ed = PF_FindScan (e, f, s);
+	else if (pr_findindex.value == 2)
+	{
+	// compare with the scan
+		found = PF_FindScan (e, f, s);
+		if (found != ed)
 		{
-			RETURN_EDICT(ed);
-			return;
+			Con_Printf ("find: index gave edict %i, the scan %i for \"%s\"\n",
+				NUM_FOR_EDICT(ed), NUM_FOR_EDICT(found), s);
+			ed = found;
 		}
 	}
 
-	RETURN_EDICT(sv.edicts);
+	RETURN_EDICT(ed);
 }
 
 void PR_CheckEmptyString (char *s)
@@ -49,6 +49,7 @@ cvar_t	saved1 = {"saved1", "0", true};
 cvar_t	saved2 = {"saved2", "0", true};
 cvar_t	saved3 = {"saved3", "0", true};
 cvar_t	saved4 = {"saved4", "0", true};
+cvar_t	pr_findindex = {"pr_findindex", "1"};	// 2 checks every lookup against the scan
 
 #define	MAX_FIELD_LEN	64
 #define GEFV_CACHESIZE	2
@@ -71,6 +72,7 @@ void ED_ClearEdict (edict_t *e)
 {
 	memset (&e->v, 0, progs->entityfields * 4);
 	e->free = false;
+	ED_IndexEdict (e);
 }
 
 /*
@@ -136,6 +138,270 @@ void ED_Free (edict_t *ed)
 	ed->v.solid = 0;
 	
 	ed->freetime = sv.time;
+
+	ED_UnindexEdict (ed);
+}
+
+/*
+===============================================================================
+
+STRING FIELD INDEX
+
+find() is called by the progs every think to resolve targets, and scanning
+all edicts for a string compare drags the whole edict block out of PSRAM.
+The fields the progs search by almost exclusively are hashed by their string
+contents instead.  Every chain is kept sorted by edict number, so find()
+still returns the same edict as the linear scan would.
+
+The index is updated by whoever writes these fields: ED_ClearEdict,
+ED_ParseEdict and the OP_STOREP_S opcode.  A field can also point into a
+buffer that is rewritten in place, the ftos/vtos result or a client name,
+and then its contents change without a store.  Those edicts are not hashed
+but kept on a short list that find() compares one by one.
+
+===============================================================================
+*/
+
+#define	EDICT_INDEX_HASH	128		// must be a power of two
+
+typedef struct
+{
+	int		ofs;						// field offset in entvars, in ints
+	short	hash[EDICT_INDEX_HASH];		// first edict of every chain, -1 = empty
+	short	next[MAX_EDICTS];			// next edict in the same chain
+	short	chain[MAX_EDICTS];			// chain the edict is linked in, -1 = none
+	short	unhashed[MAX_EDICTS];		// edicts with chain EDICT_UNHASHED
+	int		numunhashed;
+} edictindex_t;
+
+#define	EDICT_UNHASHED		-2
+
+#define	NUM_EDICT_INDEXES	3
+
+static edictindex_t	ed_index[NUM_EDICT_INDEXES] __psram_bss("pr_index");
+
+static int ED_IndexNum (edict_t *ed)
+{
+	return ((byte *)ed - (byte *)sv.edicts) / pr_edict_size;
+}
+
+static unsigned ED_HashString (char *s)
+{
+	unsigned	h;
+
+	for (h = 0 ; *s ; s++)
+		h = h*31 + *s;
+	return (h ^ (h >> 7)) & (EDICT_INDEX_HASH-1);
+}
+
+/*
+=================
+ED_VolatileString
+
+True for the buffers that are written over without a store to the field
+=================
+*/
+static qboolean ED_VolatileString (char *s)
+{
+	extern char	pr_string_temp[128];
+
+	if (s >= pr_string_temp && s < pr_string_temp + sizeof(pr_string_temp))
+		return true;
+	if ((byte *)s >= (byte *)svs.clients && (byte *)s < (byte *)(svs.clients + svs.maxclientslimit))
+		return true;
+	return false;
+}
+
+static void ED_UnlinkIndex (edictindex_t *ix, int num)
+{
+	short	*link;
+	int		i;
+
+	if (ix->chain[num] == EDICT_UNHASHED)
+	{
+		for (i=0 ; ix->unhashed[i] != num ; i++)
+			;
+		ix->unhashed[i] = ix->unhashed[--ix->numunhashed];
+		ix->chain[num] = -1;
+		return;
+	}
+
+	if (ix->chain[num] < 0)
+		return;
+
+	for (link = &ix->hash[ix->chain[num]] ; *link != num ; link = &ix->next[*link])
+		;
+	*link = ix->next[num];
+	ix->chain[num] = -1;
+}
+
+static void ED_LinkIndex (edictindex_t *ix, int num, edict_t *ed)
+{
+	char	*s;
+	short	*link;
+	int		h;
+
+	ED_UnlinkIndex (ix, num);
+
+	s = E_STRING(ed, ix->ofs);
+	if (ED_VolatileString (s))
+	{
+		ix->unhashed[ix->numunhashed++] = num;
+		ix->chain[num] = EDICT_UNHASHED;
+		return;
+	}
+	if (!s[0])
+		return;		// never indexed, find() scans for empty strings
+
+	h = ED_HashString (s);
+	for (link = &ix->hash[h] ; *link >= 0 && *link < num ; link = &ix->next[*link])
+		;
+	ix->next[num] = *link;
+	*link = num;
+	ix->chain[num] = h;
+}
+
+/*
+=================
+ED_ClearIndex
+
+Called when a new edict block is allocated
+=================
+*/
+void ED_ClearIndex (void)
+{
+	int		i;
+
+	ed_index[0].ofs = offsetof(entvars_t, classname) / 4;
+	ed_index[1].ofs = offsetof(entvars_t, targetname) / 4;
+	ed_index[2].ofs = offsetof(entvars_t, target) / 4;
+
+	for (i=0 ; i<NUM_EDICT_INDEXES ; i++)
+	{
+		memset (ed_index[i].hash, -1, sizeof(ed_index[i].hash));
+		memset (ed_index[i].chain, -1, sizeof(ed_index[i].chain));
+		ed_index[i].numunhashed = 0;
+	}
+}
+
+/*
+=================
+ED_IndexEdict
+
+Relinks all indexed fields of an edict after it was rewritten
+=================
+*/
+void ED_IndexEdict (edict_t *ed)
+{
+	int		i, num;
+
+	num = ED_IndexNum (ed);
+	for (i=0 ; i<NUM_EDICT_INDEXES ; i++)
+		ED_LinkIndex (&ed_index[i], num, ed);
+}
+
+/*
+=================
+ED_UnindexEdict
+=================
+*/
+void ED_UnindexEdict (edict_t *ed)
+{
+	int		i, num;
+
+	num = ED_IndexNum (ed);
+	for (i=0 ; i<NUM_EDICT_INDEXES ; i++)
+		ED_UnlinkIndex (&ed_index[i], num);
+}
+
+/*
+=================
+ED_IndexStore
+
+Called after the progs stored a string through an edict field pointer,
+ofs is the byte offset from sv.edicts
+=================
+*/
+void ED_IndexStore (int ofs)
+{
+	int		i, num, field;
+
+	num = ofs / pr_edict_size;
+	if (num < 0 || num >= sv.max_edicts)
+		return;
+	field = (ofs - num*pr_edict_size - (int)offsetof(edict_t, v)) >> 2;
+
+	for (i=0 ; i<NUM_EDICT_INDEXES ; i++)
+	{
+		if (ed_index[i].ofs == field)
+		{
+			ED_LinkIndex (&ed_index[i], num, EDICT_NUM(num));
+			return;
+		}
+	}
+}
+
+/*
+=================
+ED_FindIndexed
+
+Finds the first edict after start whose string field at ofs matches s.
+Returns false if that field is not indexed and the caller has to scan.
+=================
+*/
+qboolean ED_FindIndexed (int ofs, char *s, int start, edict_t **found)
+{
+	edictindex_t	*ix;
+	edict_t			*ed;
+	int				i, h, num, best;
+
+	if (!pr_findindex.value || !s[0])
+		return false;
+
+	for (i=0, ix=ed_index ; i<NUM_EDICT_INDEXES ; i++, ix++)
+		if (ix->ofs == ofs)
+			break;
+	if (i == NUM_EDICT_INDEXES)
+		return false;
+
+// the first unhashed match bounds the chain walk
+	best = sv.num_edicts;
+	for (i=0 ; i<ix->numunhashed ; i++)
+	{
+		num = ix->unhashed[i];
+		if (num <= start || num >= best)
+			continue;
+		ed = EDICT_NUM(num);
+		if (ed->free)
+			continue;
+		if (!strcmp (E_STRING(ed, ofs), s))
+			best = num;
+	}
+
+	h = ED_HashString (s);
+
+// the previous match is usually in this chain already, continue from it
+	if (start > 0 && start < sv.max_edicts && ix->chain[start] == h)
+		num = ix->next[start];
+	else
+		num = ix->hash[h];
+
+	for ( ; num >= 0 && num < best ; num = ix->next[num])
+	{
+		if (num <= start)
+			continue;
+		ed = EDICT_NUM(num);
+		if (ed->free)
+			continue;
+		if (!strcmp (E_STRING(ed, ofs), s))
+		{
+			best = num;
+			break;
+		}
+	}
+
+	*found = best < sv.num_edicts ? EDICT_NUM(best) : sv.edicts;
+	return true;
 }
 
 //===========================================================================
@@ -178,23 +444,108 @@ ddef_t *ED_FieldAtOfs (int ofs)
 	return NULL;
 }
 
+/*
+===============================================================================
+
+PROGS NAME HASH
+
+The spawner resolves every key and classname of the map by name, and the
+defs were searched with a strcmp per entry.  The names are hashed once in
+PR_LoadProgs instead.  Chains are linked back to front so the first def of
+a name is still the one found, as with the linear scan.
+
+===============================================================================
+*/
+
+#define	PR_NAME_HASH	1024		// must be a power of two
+
+typedef struct
+{
+	byte	*names;					// s_name of the first def
+	int		stride;					// bytes between defs
+	int		hash[PR_NAME_HASH];		// first def of every chain, -1 = empty
+	int		*next;					// next def in the same chain, on the hunk
+} prnamehash_t;
+
+static prnamehash_t	pr_fieldhash __psram_bss("pr_names");
+static prnamehash_t	pr_globalhash __psram_bss("pr_names");
+static prnamehash_t	pr_functionhash __psram_bss("pr_names");
+
+static unsigned PR_HashName (char *s, int len)
+{
+	unsigned	h;
+
+	for (h = 0 ; len ; len--, s++)
+		h = h*31 + *s;
+	return (h ^ (h >> 10)) & (PR_NAME_HASH-1);
+}
+
+#define	PR_DEFNAME(nh,i)	(pr_strings + *(int *)((nh)->names + (i)*(nh)->stride))
+
 /*
 ============
-ED_FindField
+PR_HashNames
+
+names points at the s_name of the first of count defs
 ============
 */
-ddef_t *ED_FindField (char *name)
+static void PR_HashNames (prnamehash_t *nh, void *names, int stride, int count)
 {
-	ddef_t		*def;
 	int			i;
-	
-	for (i=0 ; i<progs->numfielddefs ; i++)
+	unsigned	h;
+	char		*s;
+
+	nh->names = names;
+	nh->stride = stride;
+	nh->next = Hunk_AllocName (count * sizeof(int), "prhash");
+	memset (nh->hash, -1, sizeof(nh->hash));
+
+	for (i=count-1 ; i>=0 ; i--)
 	{
-		def = &pr_fielddefs[i];
-		if (!strcmp(pr_strings + def->s_name,name) )
-			return def;
+		s = PR_DEFNAME(nh, i);
+		h = PR_HashName (s, strlen(s));
+		nh->next[i] = nh->hash[h];
+		nh->hash[h] = i;
 	}
-	return NULL;
+}
+
+/*
+============
+PR_FindName
+
+name need not be terminated, returns the def number or -1
+============
+*/
+static int PR_FindName (prnamehash_t *nh, char *name, int len)
+{
+	int		i;
+	char	*s;
+
+	for (i = nh->hash[PR_HashName (name, len)] ; i >= 0 ; i = nh->next[i])
+	{
+		s = PR_DEFNAME(nh, i);
+		if (!strncmp (s, name, len) && !s[len])
+			return i;
+	}
+	return -1;
+}
+
+/*
+============
+ED_FindField
+============
+*/
+static ddef_t *ED_FindFieldLen (char *name, int len)
+{
+	int		i;
+
+	i = PR_FindName (&pr_fieldhash, name, len);
+	return i < 0 ? NULL : &pr_fielddefs[i];
+}
+
+ddef_t *ED_FindField (char *name)
+{
+	return ED_FindFieldLen (name, strlen(name));
 }
 
 
@@ -205,16 +556,10 @@ ED_FindGlobal
 */
 ddef_t *ED_FindGlobal (char *name)
 {
-	ddef_t		*def;
-	int			i;
-	
-	for (i=0 ; i<progs->numglobaldefs ; i++)
-	{
-		def = &pr_globaldefs[i];
-		if (!strcmp(pr_strings + def->s_name,name) )
-			return def;
-	}
-	return NULL;
+	int		i;
+
+	i = PR_FindName (&pr_globalhash, name, strlen(name));
+	return i < 0 ? NULL : &pr_globaldefs[i];
 }
 
 
@@ -223,18 +568,17 @@ ddef_t *ED_FindGlobal (char *name)
 ED_FindFunction
 ============
 */
+static dfunction_t *ED_FindFunctionLen (char *name, int len)
+{
+	int		i;
+
+	i = PR_FindName (&pr_functionhash, name, len);
+	return i < 0 ? NULL : &pr_functions[i];
+}
+
 dfunction_t *ED_FindFunction (char *name)
 {
-	dfunction_t		*func;
-	int				i;
-	
-	for (i=0 ; i<progs->numfunctions ; i++)
-	{
-		func = &pr_functions[i];
-		if (!strcmp(pr_strings + func->s_name,name) )
-			return func;
-	}
-	return NULL;
+	return ED_FindFunctionLen (name, strlen(name));
 }
 
 
@@ -690,13 +1034,12 @@ void ED_ParseGlobals (char *data)
 ED_NewString
 =============
 */
-char *ED_NewString (char *string)
+static char *ED_NewStringLen (char *string, int l)
 {
 	char	*new, *new_p;
-	int		i,l;
+	int		i;
 	
-	l = strlen(string) + 1;
-	new = Hunk_Alloc (l);
+	new = Hunk_Alloc (l + 1);
 	new_p = new;
 
 	for (i=0 ; i< l ; i++)
@@ -712,25 +1055,33 @@ char *ED_NewString (char *string)
 		else
 			*new_p++ = string[i];
 	}
+	*new_p = 0;
 	
 	return new;
 }
 
+char *ED_NewString (char *string)
+{
+	return ED_NewStringLen (string, strlen(string));
+}
+
 
 /*
 =============
-ED_ParseEval
+ED_ParseValue
 
-Can parse either fields or globals
-returns false if error
+Converts len characters at s, which need not be terminated; numbers stop
+at the closing quote of the token by themselves.  Vector components are
+separated by single spaces, anglehack stores a scalar as the yaw of a
+vector.  Returns false if error.
 =============
 */
-qboolean	ED_ParseEpair (void *base, ddef_t *key, char *s)
+static qboolean ED_ParseValue (void *base, ddef_t *key, char *s, int len, qboolean anglehack)
 {
 	int		i;
-	char	string[128];
 	ddef_t	*def;
-	char	*v, *w;
+	char	*end;
+	float	*v;
 	void	*d;
 	dfunction_t	*func;
 	
@@ -739,46 +1090,47 @@ qboolean	ED_ParseEpair (void *base, ddef_t *key, char *s)
 	switch (key->type & ~DEF_SAVEGLOBAL)
 	{
 	case ev_string:
-		*(string_t *)d = ED_NewString (s) - pr_strings;
+		*(string_t *)d = ED_NewStringLen (s, len) - pr_strings;
 		break;
 		
 	case ev_float:
-		*(float *)d = atof (s);
+		*(float *)d = anglehack ? 0 : strtod (s, NULL);
 		break;
 		
 	case ev_vector:
-		strcpy (string, s);
-		v = string;
-		w = string;
-		for (i=0 ; i<3 ; i++)
+		v = (float *)d;
+		end = s + len;
+		i = 0;
+		if (anglehack)
+			v[i++] = 0;
+		for ( ; i<3 ; i++)
 		{
-			while (*v && *v != ' ')
-				v++;
-			*v = 0;
-			((float *)d)[i] = atof (w);
-			w = v = v+1;
+			v[i] = (s < end && *s != ' ') ? strtod (s, NULL) : 0;
+			while (s < end && *s != ' ')
+				s++;
+			s++;
 		}
 		break;
 		
 	case ev_entity:
-		*(int *)d = EDICT_TO_PROG(EDICT_NUM(atoi (s)));
+		*(int *)d = EDICT_TO_PROG(EDICT_NUM(strtol (s, NULL, 10)));
 		break;
 		
 	case ev_field:
-		def = ED_FindField (s);
+		def = ED_FindFieldLen (s, len);
 		if (!def)
 		{
-			Con_Printf ("Can't find field %s\n", s);
+			Con_Printf ("Can't find field %.*s\n", len, s);
 			return false;
 		}
 		*(int *)d = G_INT(def->ofs);
 		break;
 	
 	case ev_function:
-		func = ED_FindFunction (s);
+		func = ED_FindFunctionLen (s, len);
 		if (!func)
 		{
-			Con_Printf ("Can't find function %s\n", s);
+			Con_Printf ("Can't find function %.*s\n", len, s);
 			return false;
 		}
 		*(func_t *)d = func - pr_functions;
@@ -790,6 +1142,87 @@ qboolean	ED_ParseEpair (void *base, ddef_t *key, char *s)
 	return true;
 }
 
+/*
+=============
+ED_ParseEval
+
+Can parse either fields or globals
+returns false if error
+=============
+*/
+qboolean	ED_ParseEpair (void *base, ddef_t *key, char *s)
+{
+	return ED_ParseValue (base, key, s, strlen(s), false);
+}
+
+/*
+=============
+ED_ParseToken
+
+COM_Parse without the copy into com_token: the token is returned in place
+as a start and a length, the entity text is not modified.  Returns NULL at
+the end of the data.
+=============
+*/
+static char *ED_ParseToken (char *data, char **token, int *len)
+{
+	int		c;
+
+	*token = data;
+	*len = 0;
+
+	if (!data)
+		return NULL;
+
+// skip whitespace
+skipwhite:
+	while ( (c = *data) <= ' ')
+	{
+		if (c == 0)
+			return NULL;
+		data++;
+	}
+
+// skip // comments
+	if (c=='/' && data[1] == '/')
+	{
+		while (*data && *data != '\n')
+			data++;
+		goto skipwhite;
+	}
+
+// handle quoted strings specially
+	if (c == '\"')
+	{
+		*token = ++data;
+		while (*data && *data != '\"')
+			data++;
+		*len = data - *token;
+		return *data ? data+1 : data;
+	}
+
+	*token = data;
+
+// parse single characters
+	if (c=='{' || c=='}'|| c==')'|| c=='(' || c=='\'' || c==':')
+	{
+		*len = 1;
+		return data+1;
+	}
+
+// parse a regular word
+	do
+	{
+		data++;
+		c = *data;
+		if (c=='{' || c=='}'|| c==')'|| c=='(' || c=='\'' || c==':')
+			break;
+	} while (c>32);
+
+	*len = data - *token;
+	return data;
+}
+
 /*
 ====================
 ED_ParseEdict
@@ -797,6 +1230,9 @@ ED_ParseEdict
 Parses an edict out of the given string, returning the new position
 ed should be a properly initialized empty edict.
 Used for initial level load and for savegames.
+
+Keys and values are taken straight out of the entity text and converted
+into the edict in one pass, nothing is copied through com_token.
 ====================
 */
 char *ED_ParseEdict (char *data, edict_t *ent)
@@ -804,8 +1240,8 @@ char *ED_ParseEdict (char *data, edict_t *ent)
 	ddef_t		*key;
 	qboolean	anglehack;
 	qboolean	init;
-	char		keyname[256];
-	int			n;
+	char		*keyname, *value;
+	int			keylen, valuelen;
 
 	init = false;
 
@@ -817,72 +1253,64 @@ char *ED_ParseEdict (char *data, edict_t *ent)
 	while (1)
 	{	
 	// parse key
-		data = COM_Parse (data);
-		if (com_token[0] == '}')
+		data = ED_ParseToken (data, &keyname, &keylen);
+		if (keylen && keyname[0] == '}')
 			break;
 		if (!data)
 			Sys_Error ("ED_ParseEntity: EOF without closing brace");
 		
 // anglehack is to allow QuakeEd to write single scalar angles
 // and allow them to be turned into vectors. (FIXME...)
-if (!strcmp(com_token, "angle"))
-{
-	strcpy (com_token, "angles");
-	anglehack = true;
-}
-else
-	anglehack = false;
+		anglehack = (keylen == 5 && !strncmp (keyname, "angle", 5));
+		if (anglehack)
+		{
+			keyname = "angles";
+			keylen = 6;
+		}
 
 // FIXME: change light to _light to get rid of this hack
-if (!strcmp(com_token, "light"))
-	strcpy (com_token, "light_lev");	// hack for single light def
-
-		strcpy (keyname, com_token);
-
-		// another hack to fix heynames with trailing spaces
-		n = strlen(keyname);
-		while (n && keyname[n-1] == ' ')
+		else if (keylen == 5 && !strncmp (keyname, "light", 5))
 		{
-			keyname[n-1] = 0;
-			n--;
+			keyname = "light_lev";	// hack for single light def
+			keylen = 9;
 		}
 
+		// another hack to fix heynames with trailing spaces
+		while (keylen && keyname[keylen-1] == ' ')
+			keylen--;
+
 	// parse value	
-		data = COM_Parse (data);
+		data = ED_ParseToken (data, &value, &valuelen);
 		if (!data)
 			Sys_Error ("ED_ParseEntity: EOF without closing brace");
 
-		if (com_token[0] == '}')
+		if (valuelen && value[0] == '}')
 			Sys_Error ("ED_ParseEntity: closing brace without data");
 
 		init = true;	
 
 // keynames with a leading underscore are used for utility comments,
 // and are immediately discarded by quake
-		if (keyname[0] == '_')
+		if (keylen && keyname[0] == '_')
 			continue;
 		
-		key = ED_FindField (keyname);
+		key = ED_FindFieldLen (keyname, keylen);
 		if (!key)
 		{
-			Con_Printf ("'%s' is not a field\n", keyname);
+			Con_Printf ("'%.*s' is not a field\n", keylen, keyname);
 			continue;
 		}
 
-if (anglehack)
-{
-char	temp[32];
-strcpy (temp, com_token);
-sprintf (com_token, "0 %s 0", temp);
-}
-
-		if (!ED_ParseEpair ((void *)&ent->v, key, com_token))
+		if (!ED_ParseValue ((void *)&ent->v, key, value, valuelen, anglehack))
 			Host_Error ("ED_ParseEdict: parse error");
 	}
 
 	if (!init)
 		ent->free = true;
 
+	ED_IndexEdict (ent);
+	SV_AreaStale (ent);
+
 	return data;
 }
 
@@ -907,6 +1335,8 @@ void ED_LoadFromFile (char *data)
 	edict_t		*ent;
 	int			inhibit;
 	dfunction_t	*func;
+	char		*token;
+	int			len;
 	
 	ent = NULL;
 	inhibit = 0;
@@ -916,11 +1346,11 @@ void ED_LoadFromFile (char *data)
 	while (1)
 	{
 // parse the opening brace	
-		data = COM_Parse (data);
+		data = ED_ParseToken (data, &token, &len);
 		if (!data)
 			break;
-		if (com_token[0] != '{')
-			Sys_Error ("ED_LoadFromFile: found %s when expecting {",com_token);
+		if (!len || token[0] != '{')
+			Sys_Error ("ED_LoadFromFile: found %.*s when expecting {", len, token);
 
 		if (!ent)
 			ent = EDICT_NUM(0);
@@ -1057,6 +1487,10 @@ void PR_LoadProgs (void)
 
 	for (i=0 ; i<progs->numglobals ; i++)
 		((int *)pr_globals)[i] = LittleLong (((int *)pr_globals)[i]);
+
+	PR_HashNames (&pr_fieldhash, &pr_fielddefs[0].s_name, sizeof(ddef_t), progs->numfielddefs);
+	PR_HashNames (&pr_globalhash, &pr_globaldefs[0].s_name, sizeof(ddef_t), progs->numglobaldefs);
+	PR_HashNames (&pr_functionhash, &pr_functions[0].s_name, sizeof(dfunction_t), progs->numfunctions);
 }
 
 
@@ -1082,6 +1516,7 @@ void PR_Init (void)
 	Cvar_RegisterVariable (&saved2);
 	Cvar_RegisterVariable (&saved3);
 	Cvar_RegisterVariable (&saved4);
+	Cvar_RegisterVariable (&pr_findindex);
 }
 
 
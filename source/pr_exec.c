@@ -546,11 +546,15 @@ while (1)
 	case OP_STOREP_F:
 	case OP_STOREP_ENT:
 	case OP_STOREP_FLD:		// integers
-	case OP_STOREP_S:
 	case OP_STOREP_FNC:		// pointers
 		ptr = (eval_t *)((byte *)sv.edicts + b->_int);
 		ptr->_int = a->_int;
 		break;
+	case OP_STOREP_S:
+		ptr = (eval_t *)((byte *)sv.edicts + b->_int);
+		ptr->_int = a->_int;
+		ED_IndexStore (b->_int);
+		break;
 	case OP_STOREP_V:
 		ptr = (eval_t *)((byte *)sv.edicts + b->_int);
 		ptr->vector[0] = a->vector[0];
@@ -566,6 +570,10 @@ while (1)
 		if (ed == (edict_t *)sv.edicts && sv.state == ss_active)
 			PR_RunError ("assignment to world entity");
 		c->_int = (byte *)((int *)&ed->v + b->_int) - (byte *)sv.edicts;
+	// solid and origin, mins and maxs are contiguous
+		if ((unsigned)(b->_int - offsetof(entvars_t, solid)/4) < 4
+		|| (unsigned)(b->_int - offsetof(entvars_t, mins)/4) < 6)
+			SV_AreaStale (ed);
 		break;
 		
 	case OP_LOAD_F:
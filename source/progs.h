@@ -36,6 +36,7 @@ typedef struct edict_s
 {
 	qboolean	free;
 	link_t		area;				// linked to a division node or leaf
+	int			areastale;			// on the world.c stale list, see SV_AreaStale
 	
 	int			num_leafs;
 	short		leafnums[MAX_ENT_LEAFS];
@@ -76,6 +77,13 @@ void ED_Free (edict_t *ed);
 char	*ED_NewString (char *string);
 // returns a copy of the string allocated from the server's string heap
 
+void ED_ClearIndex (void);
+void ED_IndexEdict (edict_t *ed);
+void ED_UnindexEdict (edict_t *ed);
+void ED_IndexStore (int ofs);
+qboolean ED_FindIndexed (int ofs, char *s, int start, edict_t **found);
+// hashed lookups of the classname/targetname/target fields for find()
+
 void ED_Print (edict_t *ed);
 void ED_Write (FIL *f, edict_t *ed);
 char *ED_ParseEdict (char *data, edict_t *ent);
@@ -125,6 +133,8 @@ extern	int			pr_xstatement;
 
 extern	unsigned short		pr_crc;
 
+extern	cvar_t	pr_findindex;
+
 void PR_RunError (char *error, ...);
 
 void ED_PrintEdicts (void);
@@ -14,6 +14,7 @@ void psram_sections_init()
 {
 	memcpy(&__psram_data_start__, &__psram_data_load__, (&__psram_data_end__ - &__psram_data_start__));
 	memset(&__psram_bss_start__, 0, (&__psram_bss_end__ - &__psram_bss_start__));
+	memset(&__psram_cold_start__, 0, (&__psram_cold_end__ - &__psram_cold_start__));
 }
 
 void *alloc_base(const char *for_what)
@@ -68,66 +69,130 @@ void __attribute__((naked)) stackcall(void (*proc)(), void *new_sp) {
     );
 }
 
+// ----------------------
+// temporary stack watermarks
+//
+// with stackpaint set the temporary stacks are filled before the call and
+// the untouched words counted after it, the deepest use is kept per entry
+// point for "stackreport". tools/stackbudget.py gives the static bound.
+
+#define STACK_CANARY0	0xDEADBEEF
+#define STACK_CANARY1	0xCAFEF00D
+#define STACK_PAINT		0x57AC57AC
+#define MAX_STACKMARKS	32
+
+typedef struct {
+	const char	*name;
+	uint32_t	stackbytes;
+	uint32_t	peak;
+	uint32_t	calls;
+} stackmark_t;
+
+static stackmark_t	stackmarks[MAX_STACKMARKS];
+static int			numstackmarks;
+
+cvar_t	stackpaint = {"stackpaint", "0"};
+
+static void stackmark_note(const char *name, uint32_t stackbytes, uint32_t used) {
+	stackmark_t *mark;
+	int i;
+
+	for (i = 0, mark = stackmarks; i < numstackmarks; i++, mark++) {
+		if (mark->name == name && mark->stackbytes == stackbytes)
+			break;
+	}
+	if (i == numstackmarks) {
+		if (numstackmarks == MAX_STACKMARKS)
+			return;
+		numstackmarks++;
+		mark->name = name;
+		mark->stackbytes = stackbytes;
+		mark->peak = 0;
+		mark->calls = 0;
+	}
+	mark->calls++;
+	if (used > mark->peak)
+		mark->peak = used;
+}
+
+// run proc with stackbytes of stack above the canary at tempstack
+static void stackcall_checked(void (*proc)(), uint8_t *tempstack, uint32_t stackbytes, const char *name) {
+	uint32_t *words = (uint32_t*)tempstack;
+	uint32_t numwords = (stackbytes + 8) / 4;
+	uint32_t i;
+	int paint = stackpaint.value != 0;
+
+	// put canary on the bottom of "new" stack
+	words[0] = STACK_CANARY0;
+	words[1] = STACK_CANARY1;
+	if (paint) {
+		for (i = 2; i < numwords; i++)
+			words[i] = STACK_PAINT;
+	}
+
+	// call the proc
+	stackcall(proc, tempstack + stackbytes + 8);
+
+	// and check canary
+	if (words[0] != STACK_CANARY0 || words[1] != STACK_CANARY1) {
+		Sys_Error("stackcall_alloc(): stack overflow (proc=%s stackbytes=%d)\n",
+			name, stackbytes
+		);
+	}
+
+	if (paint) {
+		for (i = 2; i < numwords && words[i] == STACK_PAINT; i++)
+			;
+		stackmark_note(name, stackbytes, (numwords - i) * 4);
+	}
+}
+
+void stackcall_report_f(void) {
+	stackmark_t *mark;
+	int i;
+
+	if (Cmd_Argc() == 2 && !Q_strcmp(Cmd_Argv(1), "clear")) {
+		numstackmarks = 0;
+		return;
+	}
+	if (!numstackmarks) {
+		Con_Printf("no watermarks yet, set stackpaint 1\n");
+		return;
+	}
+
+	Con_Printf("%-22s %6s %6s %6s %s\n", "entry", "given", "peak", "spare", "calls");
+	for (i = 0, mark = stackmarks; i < numstackmarks; i++, mark++) {
+		Con_Printf("%-22s %6d %6d %6d %d\n", mark->name, mark->stackbytes, mark->peak,
+			mark->stackbytes - mark->peak, mark->calls
+		);
+	}
+}
+
 // allocate stack memory and call a function on it
-void stackcall_alloc_ex(void (*proc)(), uint32_t stackbytes, int always) {
-	uint8_t *auxa_rover;
+void stackcall_alloc_site(void (*proc)(), uint32_t stackbytes, int always, const char *name) {
 	uint8_t *tempstack;
 	if (always || stacktosram.value) {
-		auxa_rover = AUXA_GetRover(); 
-		tempstack  = (uint8_t*)AUXA_Alloc(stackbytes + 8);
+		// the stack goes when the scope does, after proc has returned
+		ARENA_SCOPE (aux_arena);
+		tempstack  = (uint8_t*)Arena_TryAlloc(&aux_arena, stackbytes + 8);
 		if (tempstack) {
-			// put canary on the bottom of "new" stack
-			((uint32_t*)tempstack)[0] = 0xDEADBEEF;
-			((uint32_t*)tempstack)[1] = 0xCAFEF00D;
-
-			// call the proc
-			stackcall(proc, tempstack + stackbytes + 8);
-			
-			// and check canary
-			if (((uint32_t*)tempstack)[0] != 0xDEADBEEF || ((uint32_t*)tempstack)[1] != 0xCAFEF00D) {
-				Sys_Error("stackcall_alloc(): stack overflow (proc=%08X stackbytes=%d)\n",
-					proc, stackbytes
-				);
-			}
-			
+			stackcall_checked(proc, tempstack, stackbytes, name);
 		} else { 
 			proc ();
 		}
-		// only then we can free the stack :)
-		AUXA_FreeToRover(auxa_rover);
 	} else {
 		proc ();
 	}
 }
 
-void stackcall_alloc(void (*proc)(), uint32_t stackbytes) {
-	stackcall_alloc_ex(proc, stackbytes, 0);
-}
-
-void stackcall_alloc_zba(void (*proc)(), uint32_t stackbytes) {
-	uint8_t *auxa_rover;
+void stackcall_alloc_zba_site(void (*proc)(), uint32_t stackbytes, const char *name) {
 	uint8_t *tempstack;
 
-	auxa_rover = ZBA_GetRover(); 
-	tempstack  = (uint8_t*)ZBA_Alloc(stackbytes + 8);
+	ARENA_SCOPE (zbuffer_arena);
+	tempstack  = (uint8_t*)Arena_TryAlloc(&zbuffer_arena, stackbytes + 8);
 	if (tempstack) {
-		// put canary on the bottom of "new" stack
-		((uint32_t*)tempstack)[0] = 0xDEADBEEF;
-		((uint32_t*)tempstack)[1] = 0xCAFEF00D;
-
-		// call the proc
-		stackcall(proc, tempstack + stackbytes + 8);
-		
-		// and check canary
-		if (((uint32_t*)tempstack)[0] != 0xDEADBEEF || ((uint32_t*)tempstack)[1] != 0xCAFEF00D) {
-			Sys_Error("stackcall_alloc(): stack overflow (proc=%08X stackbytes=%d)\n",
-				proc, stackbytes
-			);
-		}
-		
+		stackcall_checked(proc, tempstack, stackbytes, name);
 	} else { 
 		proc ();
 	}
-	// only then we can free the stack :)
-	ZBA_FreeToRover(auxa_rover);
-}
\ No newline at end of file
+}
@@ -15,6 +15,10 @@ extern uint8_t __psram_bss_end__;
 
 extern uint8_t __psram_heap_start__;
 
+// SRAM bss moved to PSRAM by the generated placement (placement/placement_psram.ld)
+extern uint8_t __psram_cold_start__;
+extern uint8_t __psram_cold_end__;
+
 // attribute macros to place variables in PSRAM sections
 
 // place initialized data or code in PSRAM
@@ -48,10 +52,15 @@ static inline unsigned int get_sp(void) {
 
 // call a function on a temporary stack
 void stackcall(void (*proc)(), void *new_sp);
-// allocate stack memory and call a function on it
-void stackcall_alloc(void (*proc)(), uint32_t stackbytes);
-void stackcall_alloc_ex(void (*proc)(), uint32_t stackbytes, int always);
-void stackcall_alloc_zba(void (*proc)(), uint32_t stackbytes);
+// allocate stack memory and call a function on it, name is kept for the
+// "stackreport" watermarks
+void stackcall_alloc_site(void (*proc)(), uint32_t stackbytes, int always, const char *name);
+void stackcall_alloc_zba_site(void (*proc)(), uint32_t stackbytes, const char *name);
+#define stackcall_alloc(proc, stackbytes)			stackcall_alloc_site(proc, stackbytes, 0, #proc)
+#define stackcall_alloc_ex(proc, stackbytes, always)	stackcall_alloc_site(proc, stackbytes, always, #proc)
+#define stackcall_alloc_zba(proc, stackbytes)		stackcall_alloc_zba_site(proc, stackbytes, #proc)
+
+void stackcall_report_f(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,57 @@
+// psram_null.c -- host stand-ins for psram_alloc.c, xipstream.c and main.cpp,
+// so the host tools (quakegeneric-null, kbench, scsim) link without the SDK
+
+#include "psram_alloc.h"
+#include "xipstream.h"
+#include "quakedef.h"
+#include "quakegeneric.h"
+
+#define PSRAM_NULL_STR2(x)	#x
+#define PSRAM_NULL_STR(x)	PSRAM_NULL_STR2(x)
+
+// the linker script puts the heap after the PSRAM sections, here it is just
+// an array big enough for the hunk, the z-buffer and what alloc_base hands out
+uint8_t psram_null_heap[__PSRAM_HUNK_SIZE + 153600]
+	__asm__(PSRAM_NULL_STR(__USER_LABEL_PREFIX__) "__psram_heap_start__") __attribute__((aligned(16)));
+
+// main.cpp's frame buffer, vid_null.c presents into it
+uint8_t FRAME_BUF[QUAKEGENERIC_RES_X * QUAKEGENERIC_RES_Y] __attribute__((aligned(4)));
+
+// the host has no PSRAM sections to copy, static data is already in place
+void psram_sections_init() {
+}
+
+// the host stack is big enough, proc always runs on it
+void stackcall_alloc_site(void (*proc)(), uint32_t stackbytes, int always, const char *name) {
+	proc ();
+}
+
+void stackcall_alloc_zba_site(void (*proc)(), uint32_t stackbytes, const char *name) {
+	proc ();
+}
+
+void stackcall_report_f(void) {
+	Con_Printf("no stack watermarks on the host\n");
+}
+
+// no XIP streaming on the host, so there is never a transfer to wait for
+int xipstream_init() {
+	return 0;
+}
+
+int xipstream_start(void *dst, void *src, uint32_t words) {
+	memcpy(dst, src, words * 4);
+	return 0;
+}
+
+int xipstream_is_running() {
+	return 0;
+}
+
+int xipstream_wait_blocking() {
+	return 0;
+}
+
+int xipstream_abort() {
+	return 0;
+}
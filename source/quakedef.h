@@ -201,6 +201,7 @@ extern "C" {
 
 #include "common.h"
 #include "bspfile.h"
+#include "arena.h"
 #include "vid.h"
 #include "sys.h"
 #include "zone.h"
@@ -221,6 +222,7 @@ typedef struct
 #include "wad.h"
 #include "draw.h"
 #include "cvar.h"
+#include "memstat.h"
 #include "screen.h"
 #include "net.h"
 #include "protocol.h"
@@ -277,6 +279,7 @@ extern	cvar_t		sys_ticrate;
 extern	cvar_t		sys_nostdout;
 extern	cvar_t		developer;
 extern  cvar_t      stacktosram;
+extern  cvar_t      stackpaint;
 
 extern	qboolean	host_initialized;		// true if into command execution
 extern	double		host_frametime;
@@ -296,6 +299,7 @@ void Host_EndGame (char *message, ...);
 void Host_Frame (float time);
 void Host_Quit_f (void);
 void Host_ClientCommands (char *fmt, ...);
+qboolean Host_SnapshotComment (int h, char *comment);
 void Host_ShutdownServer (qboolean crash);
 
 extern qboolean		msg_suppress_1;		// suppresses resolution and cache size console output
@@ -19,6 +19,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 */
 
 #include "quakedef.h"
+#include "quakegeneric.h"
+
+const qg_warp_t	*qg_warp;
 
 void QG_Tick(float duration)
 {
@@ -43,3 +46,51 @@ void QG_Create(int argc, char *argv[])
 	Host_Init (&parms);
 	Sys_Printf ("Host_Init done\n");
 }
+
+/*
+================
+QG_CopyRow
+
+The underwater warp used to be a copy of the view and a gather back into
+it on every frame; it is folded into the copy the backend does anyway.
+================
+*/
+void QG_CopyRow(unsigned char *dst, const unsigned char *pixels, int x, int y, int width)
+{
+	const qg_warp_t	*w = qg_warp;
+	const int		*turb, *row, *col;
+	int				u, end, n;
+
+	if (!w || y < w->y || y >= w->y + w->height)
+	{
+		memcpy(dst, pixels + y * QUAKEGENERIC_RES_X + x, width);
+		return;
+	}
+
+	end = x + width;
+
+	// left of the view
+	n = w->x - x;
+	if (n > 0)
+	{
+		if (n > width)
+			n = width;
+		memcpy(dst, pixels + y * QUAKEGENERIC_RES_X + x, n);
+		dst += n;
+		x += n;
+	}
+
+	turb = w->turb;
+	row = w->rowofs + (y - w->y);
+	col = w->column + turb[y - w->y];
+
+	n = (w->x + w->width < end ? w->x + w->width : end) - w->x;
+	for (u = x - w->x ; u < n ; u++)
+		*dst++ = pixels[row[turb[u]] + col[u]];
+	if (u > x - w->x)
+		x = w->x + u;
+
+	// right of the view
+	if (end > x)
+		memcpy(dst, pixels + y * QUAKEGENERIC_RES_X + x, end - x);
+}
@@ -39,14 +39,41 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 extern "C" {
 #endif
 
+// a changed region of the frame, in pixels
+typedef struct qg_rect_s
+{
+	int x, y;
+	int width, height;
+} qg_rect_t;
+
+// underwater warp of the view, applied by the backend while it copies the
+// frame out: pixel (x + u, y + v) of the rect comes from
+// pixels[rowofs[v + turb[u]] + column[u + turb[v]]]
+typedef struct qg_warp_s
+{
+	int x, y;
+	int width, height;
+	const int *turb;		// displacement per row and column, 0 to 2*AMP2
+	const int *rowofs;		// height + 2*AMP2 source row offsets into pixels
+	const int *column;		// width + 2*AMP2 source columns
+} qg_warp_t;
+
 // provided functions
 void QG_Tick(float duration);
 void QG_Create(int argc, char *argv[]);
+// copies width pixels of row y starting at x, warped if the row is inside
+// qg_warp. Backends use it for every row QG_DrawFrameRects presents.
+void QG_CopyRow(unsigned char *dst, const unsigned char *pixels, int x, int y, int width);
+extern const qg_warp_t *qg_warp;	// warp of the view in the frame, or NULL
 
 // user must implement these
 void QG_Init(void);
 void QG_Quit(void);
 void QG_DrawFrame(void *pixels);
+// present only the listed regions of pixels, the rest of the frame is
+// unchanged since the last call. pixels NULL means the regions were drawn
+// straight into the backend's frame and only need to be pushed out.
+void QG_DrawFrameRects(void *pixels, const qg_rect_t *rects, int numrects);
 void QG_SetPalette(unsigned char palette[768]);
 int QG_GetKey(int *down, int *key);
 void QG_GetMouseMove(int *x, int *y);
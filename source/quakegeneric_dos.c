@@ -64,6 +64,23 @@ void QG_DrawFrame(void *pixels)
 	memcpy(VGA, pixels, QUAKEGENERIC_RES_X * QUAKEGENERIC_RES_Y);
 }
 
+void QG_DrawFrameRects(void *pixels, const qg_rect_t *rects, int numrects)
+{
+	int i, y, ofs;
+
+	if (!pixels)
+		return;
+
+	for (i = 0; i < numrects; i++)
+	{
+		for (y = 0; y < rects[i].height; y++)
+		{
+			ofs = (rects[i].y + y) * QUAKEGENERIC_RES_X + rects[i].x;
+			QG_CopyRow(VGA + ofs, (unsigned char *)pixels, rects[i].x, rects[i].y + y, rects[i].width);
+		}
+	}
+}
+
 void QG_SetPalette(unsigned char palette[768])
 {
 	int i;
@@ -50,12 +50,24 @@ void QG_DrawFrame(void *pixels)
 
 }
 
+void QG_DrawFrameRects(void *pixels, const qg_rect_t *rects, int numrects)
+{
+
+}
+
 void QG_SetPalette(unsigned char palette[768])
 {
 
 }
 
+// headless: runs the engine with a fixed tick and no output, which is
+// enough for scripted runs such as "+hashcheck demo1 -hashexit"
 int main(int argc, char *argv[])
 {
+	QG_Create(argc, argv);
+
+	while (1)
+		QG_Tick(1.0f / 72.0f);
+
 	return 0;
 }
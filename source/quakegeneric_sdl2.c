@@ -30,6 +30,7 @@ SDL_Renderer *renderer;
 SDL_Texture *texture;
 uint32_t *rgbpixels;
 unsigned char pal[768];
+static int pal_changed;	// every pixel has to be converted again
 
 #define ARGB(r, g, b, a) (((a) << 24) | ((r) << 16) | ((g) << 8) | (b))
 
@@ -278,8 +279,59 @@ void QG_DrawFrame(void *pixels)
 	SDL_RenderPresent(renderer);
 }
 
+void QG_DrawFrameRects(void *pixels, const qg_rect_t *rects, int numrects)
+{
+	const qg_rect_t *r;
+	static const qg_rect_t full = {0, 0, QUAKEGENERIC_RES_X, QUAKEGENERIC_RES_Y};
+	SDL_Rect rect;
+	int i, x, y;
+
+	if (!pixels)
+		return;
+
+	// the texture outside the rects still has the old palette's colors
+	if (pal_changed)
+	{
+		pal_changed = 0;
+		rects = &full;
+		numrects = 1;
+	}
+
+	for (i = 0; i < numrects; i++)
+	{
+		r = &rects[i];
+
+		// convert just this region
+		for (y = r->y; y < r->y + r->height; y++)
+		{
+			uint8_t src[QUAKEGENERIC_RES_X];
+			uint32_t *dst = rgbpixels + y * QUAKEGENERIC_RES_X + r->x;
+			QG_CopyRow(src, (uint8_t *)pixels, r->x, y, r->width);
+			for (x = 0; x < r->width; x++)
+			{
+				uint8_t *entry = &((uint8_t *)pal)[src[x] * 3];
+				dst[x] = ARGB(*(entry), *(entry + 1), *(entry + 2), 255);
+			}
+		}
+
+		// and upload only that part of the texture
+		rect.x = r->x;
+		rect.y = r->y;
+		rect.w = r->width;
+		rect.h = r->height;
+		SDL_UpdateTexture(texture, &rect, rgbpixels + r->y * QUAKEGENERIC_RES_X + r->x, QUAKEGENERIC_RES_X * sizeof(uint32_t));
+	}
+
+	// blit
+	SDL_RenderClear(renderer);
+	SDL_RenderCopy(renderer, texture, NULL, NULL);
+	SDL_RenderPresent(renderer);
+}
+
 void QG_SetPalette(unsigned char palette[768])
 {
+	if (SDL_memcmp(pal, palette, 768))
+		pal_changed = 1;
 	SDL_memcpy(pal, palette, 768);
 }
 
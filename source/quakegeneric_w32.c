@@ -292,6 +292,23 @@ void QG_DrawFrame(void* pixels, void* palette){
 	InvalidateRect(hwnd, NULL, 0);
 }
 
+void QG_DrawFrameRects(void* pixels, const qg_rect_t* rects, int numrects){
+	int i, y, ofs;
+
+	if (!pixels)
+		return;
+
+	// the DIB is 320x200 and stretched to the window, so only the copy is
+	// trimmed to the changed rows
+	for (i = 0; i < numrects; i++){
+		for (y = rects[i].y; y < rects[i].y + rects[i].height && y < 200; y++){
+			ofs = y * 320 + rects[i].x;
+			QG_CopyRow(frontbuffer + ofs, (unsigned char*)pixels, rects[i].x, y, rects[i].width);
+		}
+	}
+	InvalidateRect(hwnd, NULL, 0);
+}
+
 int main(int argc, char** argv){
 	MSG Msg;
 	double oldtime, newtime;
@@ -53,8 +53,24 @@ int				r_amodels_drawn;
 int				a_skinwidth;
 int				r_anumverts;
 
+// mesh picked by R_AliasSetupLod: the full model or one of its lods
+static stvert_t			*r_apstverts;
+static mtriangle_t		*r_aptriangles;
+static unsigned short	*r_avertmap;		// NULL for the full model
+static int				r_anumtris;
+
+int				r_alodtris, r_alodsaved;	// for r_lodstats
+
 float	aliastransform[3][4];
 
+// aliastransform as integers for the byte vertices. x and y share one power
+// of two scale, z gets its own so 1/z keeps its precision when x and y have
+// been scaled up to screen units
+static int		aliasfixed[3][4];
+static float	aliasfixedscale[3];		// integer units -> aliastransform units
+static float	aliasfixedzinv;			// 2**zexp, turns 1/zint into 1/z
+static float	aliasfixedxyz;			// 2**(zexp-xyexp), turns x/zint into x/z
+
 typedef struct {
 	int	index0;
 	int	index1;
@@ -72,6 +88,10 @@ __psram_data("r_alias") float	r_avertexnormals[NUMVERTEXNORMALS][3] = {
 #include "anorms.h"
 };
 
+// shade for each lightnormalindex, rebuilt per entity by R_AliasSetupLighting
+// so the vertex loops never touch r_avertexnormals
+static int		r_alightshade[NUMVERTEXNORMALS];
+
 void R_AliasTransformAndProjectFinalVerts (finalvert_t *fv,
 	stvert_t *pstverts);
 void R_AliasSetUpTransform (int trivial_accept);
@@ -79,6 +99,8 @@ void R_AliasTransformVector (vec3_t in, vec3_t out);
 void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av,
 	trivertx_t *pverts, stvert_t *pstverts);
 void R_AliasProjectFinalVert (finalvert_t *fv, auxvert_t *av);
+void R_AliasSetUpFixedTransform (void);
+void R_AliasBuildLightTable (void);
 
 
 /*
@@ -274,14 +296,14 @@ void R_AliasPreparePoints (void)
 	mtriangle_t	*ptri;
 	finalvert_t	*pfv[3];
 
-	pstverts = (stvert_t *)((byte *)paliashdr + paliashdr->stverts);
-	r_anumverts = pmdl->numverts;
+	pstverts = r_apstverts;
  	fv = pfinalverts;
 	av = pauxverts;
 
-	for (i=0 ; i<r_anumverts ; i++, fv++, av++, r_apverts++, pstverts++)
+	for (i=0 ; i<r_anumverts ; i++, fv++, av++, pstverts++)
 	{
-		R_AliasTransformFinalVert (fv, av, r_apverts, pstverts);
+		R_AliasTransformFinalVert (fv, av,
+				r_apverts + (r_avertmap ? r_avertmap[i] : i), pstverts);
 		if (av->fv[2] < ALIAS_Z_CLIP_PLANE)
 			fv->flags |= ALIAS_Z_CLIP;
 		else
@@ -304,8 +326,8 @@ void R_AliasPreparePoints (void)
 //
 	r_affinetridesc.numtriangles = 1;
 
-	ptri = (mtriangle_t *)((byte *)paliashdr + paliashdr->triangles);
-	for (i=0 ; i<pmdl->numtris ; i++, ptri++)
+	ptri = r_aptriangles;
+	for (i=0 ; i<r_anumtris ; i++, ptri++)
 	{
 		pfv[0] = &pfinalverts[ptri->vertindex[0]];
 		pfv[1] = &pfinalverts[ptri->vertindex[1]];
@@ -407,6 +429,52 @@ void R_AliasSetUpTransform (int trivial_accept)
 }
 
 
+/*
+================
+R_AliasSetUpFixedTransform
+
+255 * |row| + |translation| is kept under 2**30 so the integer dot products
+can't overflow
+================
+*/
+static int R_AliasFixedExponent (float *row)
+{
+	int		exp;
+	float	bound;
+
+	bound = 255.0f * (fabsf(row[0]) + fabsf(row[1]) + fabsf(row[2])) +
+			fabsf(row[3]);
+	if (bound < 1.0f / (1<<30))
+		bound = 1.0f / (1<<30);
+
+	frexpf (bound, &exp);		// bound < 2**exp
+	return 30 - exp;
+}
+
+void R_AliasSetUpFixedTransform (void)
+{
+	int		i, j, exp[3];
+
+	exp[0] = R_AliasFixedExponent (aliastransform[0]);
+	exp[1] = R_AliasFixedExponent (aliastransform[1]);
+	if (exp[1] < exp[0])
+		exp[0] = exp[1];
+	else
+		exp[1] = exp[0];
+	exp[2] = R_AliasFixedExponent (aliastransform[2]);
+
+	for (i=0 ; i<3 ; i++)
+	{
+		for (j=0 ; j<4 ; j++)
+			aliasfixed[i][j] = (int)ldexpf (aliastransform[i][j], exp[i]);
+		aliasfixedscale[i] = ldexpf (1.0f, -exp[i]);
+	}
+
+	aliasfixedzinv = ldexpf (1.0f, exp[2]);
+	aliasfixedxyz = ldexpf (1.0f, exp[2] - exp[0]);
+}
+
+
 /*
 ================
 R_AliasTransformFinalVert
@@ -415,15 +483,18 @@ R_AliasTransformFinalVert
 void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av,
 	trivertx_t *pverts, stvert_t *pstverts)
 {
-	int		temp;
-	float	lightcos, *plightnormal;
+	int		v0, v1, v2;
+
+	v0 = pverts->v[0];
+	v1 = pverts->v[1];
+	v2 = pverts->v[2];
 
-	av->fv[0] = DotProduct(pverts->v, aliastransform[0]) +
-			aliastransform[0][3];
-	av->fv[1] = DotProduct(pverts->v, aliastransform[1]) +
-			aliastransform[1][3];
-	av->fv[2] = DotProduct(pverts->v, aliastransform[2]) +
-			aliastransform[2][3];
+	av->fv[0] = (float)(aliasfixed[0][0]*v0 + aliasfixed[0][1]*v1 +
+			aliasfixed[0][2]*v2 + aliasfixed[0][3]) * aliasfixedscale[0];
+	av->fv[1] = (float)(aliasfixed[1][0]*v0 + aliasfixed[1][1]*v1 +
+			aliasfixed[1][2]*v2 + aliasfixed[1][3]) * aliasfixedscale[1];
+	av->fv[2] = (float)(aliasfixed[2][0]*v0 + aliasfixed[2][1]*v1 +
+			aliasfixed[2][2]*v2 + aliasfixed[2][3]) * aliasfixedscale[2];
 
 	fv->v[2] = pstverts->s;
 	fv->v[3] = pstverts->t;
@@ -431,21 +502,7 @@ void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av,
 	fv->flags = pstverts->onseam;
 
 // lighting
-	plightnormal = r_avertexnormals[pverts->lightnormalindex];
-	lightcos = DotProduct (plightnormal, r_plightvec);
-	temp = r_ambientlight;
-
-	if (lightcos < 0)
-	{
-		temp += (int)(r_shadelight * lightcos);
-
-	// clamp; because we limited the minimum ambient and shading light, we
-	// don't have to clamp low light, just bright
-		if (temp < 0)
-			temp = 0;
-	}
-
-	fv->v[4] = temp;
+	fv->v[4] = r_alightshade[pverts->lightnormalindex];
 }
 
 /*
@@ -453,50 +510,49 @@ void R_AliasTransformFinalVert (finalvert_t *fv, auxvert_t *av,
 R_AliasTransformAndProjectFinalVerts
 ================
 */
-void R_AliasTransformAndProjectFinalVerts (finalvert_t *fv, stvert_t *pstverts)
+void __not_in_flash_func(R_AliasTransformAndProjectFinalVerts) (finalvert_t *fv, stvert_t *pstverts)
 {
-	int			i, temp;
-	float		lightcos, *plightnormal, zi;
+	int			i, v0, v1, v2, x, y, z;
+	int			m00, m01, m02, m03, m10, m11, m12, m13, m20, m21, m22, m23;
+	float		zi, zixy, xcenter, ycenter, zinv, xyz;
 	trivertx_t	*pverts;
 
-	pverts = r_apverts;
+	m00 = aliasfixed[0][0]; m01 = aliasfixed[0][1]; m02 = aliasfixed[0][2]; m03 = aliasfixed[0][3];
+	m10 = aliasfixed[1][0]; m11 = aliasfixed[1][1]; m12 = aliasfixed[1][2]; m13 = aliasfixed[1][3];
+	m20 = aliasfixed[2][0]; m21 = aliasfixed[2][1]; m22 = aliasfixed[2][2]; m23 = aliasfixed[2][3];
+	xcenter = aliasxcenter;
+	ycenter = aliasycenter;
+	zinv = aliasfixedzinv;
+	xyz = aliasfixedxyz;
 
-	for (i=0 ; i<r_anumverts ; i++, fv++, pverts++, pstverts++)
+	for (i=0 ; i<r_anumverts ; i++, fv++, pstverts++)
 	{
-	// transform and project
-		zi = 1.0f / (DotProduct(pverts->v, aliastransform[2]) +
-				aliastransform[2][3]);
-
-	// x, y, and z are scaled down by 1/2**31 in the transform, so 1/z is
-	// scaled up by 1/2**31, and the scaling cancels out for x and y in the
-	// projection
-		fv->v[5] = zi;
-
-		fv->v[0] = ((DotProduct(pverts->v, aliastransform[0]) +
-				aliastransform[0][3]) * zi) + aliasxcenter;
-		fv->v[1] = ((DotProduct(pverts->v, aliastransform[1]) +
-				aliastransform[1][3]) * zi) + aliasycenter;
+	// transform
+		pverts = r_apverts + (r_avertmap ? r_avertmap[i] : i);
+		v0 = pverts->v[0];
+		v1 = pverts->v[1];
+		v2 = pverts->v[2];
+
+		x = m00*v0 + m01*v1 + m02*v2 + m03;
+		y = m10*v0 + m11*v1 + m12*v2 + m13;
+		z = m20*v0 + m21*v1 + m22*v2 + m23;
+
+	// project; x, y, and z are scaled down by 1/2**31 in the transform, so
+	// 1/z is scaled up by 1/2**31, and the scaling cancels out for x and y in
+	// the projection. The integer scales only need one fixup each
+		zi = 1.0f / (float)z;
+		zixy = zi * xyz;
+
+		fv->v[5] = zi * zinv;
+		fv->v[0] = ((float)x * zixy) + xcenter;
+		fv->v[1] = ((float)y * zixy) + ycenter;
 
 		fv->v[2] = pstverts->s;
 		fv->v[3] = pstverts->t;
 		fv->flags = pstverts->onseam;
 
 	// lighting
-		plightnormal = r_avertexnormals[pverts->lightnormalindex];
-		lightcos = DotProduct (plightnormal, r_plightvec);
-		temp = r_ambientlight;
-
-		if (lightcos < 0)
-		{
-			temp += (int)(r_shadelight * lightcos);
-
-		// clamp; because we limited the minimum ambient and shading light, we
-		// don't have to clamp low light, just bright
-			if (temp < 0)
-				temp = 0;
-		}
-
-		fv->v[4] = temp;
+		fv->v[4] = r_alightshade[pverts->lightnormalindex];
 	}
 }
 
@@ -529,8 +585,7 @@ void R_AliasPrepareUnclippedPoints (void)
 	stvert_t	*pstverts;
 	finalvert_t	*fv;
 
-	pstverts = (stvert_t *)((byte *)paliashdr + paliashdr->stverts);
-	r_anumverts = pmdl->numverts;
+	pstverts = r_apstverts;
 // FIXME: just use pfinalverts directly?
 	fv = pfinalverts;
 
@@ -540,9 +595,8 @@ void R_AliasPrepareUnclippedPoints (void)
 		D_PolysetDrawFinalVerts (fv, r_anumverts);
 
 	r_affinetridesc.pfinalverts = pfinalverts;
-	r_affinetridesc.ptriangles = (mtriangle_t *)
-			((byte *)paliashdr + paliashdr->triangles);
-	r_affinetridesc.numtriangles = pmdl->numtris;
+	r_affinetridesc.ptriangles = r_aptriangles;
+	r_affinetridesc.numtriangles = r_anumtris;
 
 	D_PolysetDraw ();
 }
@@ -603,6 +657,38 @@ void R_AliasSetupSkin (void)
 	r_affinetridesc.skinheight = pmdl->skinheight;
 }
 
+/*
+================
+R_AliasBuildLightTable
+
+shade for every vertex normal; 162 entries per entity instead of a normal
+fetch and a float dot product per vertex
+================
+*/
+void R_AliasBuildLightTable (void)
+{
+	int		i, temp;
+	float	lightcos;
+
+	for (i=0 ; i<NUMVERTEXNORMALS ; i++)
+	{
+		lightcos = DotProduct (r_avertexnormals[i], r_plightvec);
+		temp = r_ambientlight;
+
+		if (lightcos < 0)
+		{
+			temp += (int)(r_shadelight * lightcos);
+
+		// clamp; because we limited the minimum ambient and shading light, we
+		// don't have to clamp low light, just bright
+			if (temp < 0)
+				temp = 0;
+		}
+
+		r_alightshade[i] = temp;
+	}
+}
+
 /*
 ================
 R_AliasSetupLighting
@@ -634,6 +720,8 @@ void R_AliasSetupLighting (alight_t *plighting)
 	r_plightvec[0] = DotProduct (plighting->plightvec, alias_forward);
 	r_plightvec[1] = -DotProduct (plighting->plightvec, alias_right);
 	r_plightvec[2] = DotProduct (plighting->plightvec, alias_up);
+
+	R_AliasBuildLightTable ();
 }
 
 /*
@@ -689,6 +777,50 @@ void R_AliasSetupFrame (void)
 }
 
 
+/*
+================
+R_AliasSetupLod
+
+picks the full mesh or one of the load time lods by the projected
+bounding radius; each lod takes over below half the size of the previous
+================
+*/
+void R_AliasSetupLod (void)
+{
+	int			i;
+	float		z, radius, size;
+	maliaslod_t	*plod;
+
+	r_apstverts = (stvert_t *)((byte *)paliashdr + paliashdr->stverts);
+	r_aptriangles = (mtriangle_t *)((byte *)paliashdr + paliashdr->triangles);
+	r_avertmap = NULL;
+	r_anumverts = pmdl->numverts;
+	r_anumtris = pmdl->numtris;
+
+	if (r_lod.value && paliashdr->numlods && currententity != &cl.viewent)
+	{
+		z = -DotProduct (modelorg, vpn);
+		if (z > 1)
+		{
+			radius = pmdl->boundingradius * xscale / z;
+			size = r_lodradius.value;
+			for (i=0 ; i<paliashdr->numlods && radius < size ; i++, size *= 0.5f)
+			{
+				plod = &paliashdr->lods[i];
+				r_apstverts = (stvert_t *)((byte *)paliashdr + plod->stverts);
+				r_aptriangles = (mtriangle_t *)((byte *)paliashdr + plod->triangles);
+				r_avertmap = (unsigned short *)((byte *)paliashdr + plod->vertmap);
+				r_anumverts = plod->numverts;
+				r_anumtris = plod->numtris;
+			}
+		}
+	}
+
+	r_alodtris += r_anumtris;
+	r_alodsaved += pmdl->numtris - r_anumtris;
+}
+
+
 /*
 ================
 R_AliasDrawModel
@@ -699,26 +831,35 @@ void R_AliasDrawModel (alight_t *plighting)
 	static __psram_bss("r_alias") __aligned(8) finalvert_t	finalverts[MAXALIASVERTS];
 	static __psram_bss("r_alias") __aligned(8) auxvert_t	auxverts[MAXALIASVERTS];
 	int alloc_on_heap;
-	uint8_t *auxa_rover = AUXA_GetRover();
+	ARENA_SCOPE (aux_arena);
 
 	r_amodels_drawn++;
 
 	paliashdr = (aliashdr_t *)Mod_Extradata (currententity->model);
 	pmdl = (mdl_t *)((byte *)paliashdr + paliashdr->model);
 
-	alloc_on_heap = pmdl->numverts * (currententity->trivial_accept != 0 ? 1 : 2);
-	if (alloc_on_heap <= 400) {	// tweakme, default seems to perform well
-		pfinalverts = (finalvert_t *)(AUXA_Alloc(sizeof(finalvert_t)*400)); // fixed-size predictable allocation =)
-		pauxverts   = (auxvert_t   *)(AUXA_Alloc(sizeof(auxvert_t  )*400)); // fixed-size predictable allocation =)
+	R_AliasSetupLod ();
+
+	// the unclipped path never touches auxverts, so it only pays for the
+	// finalverts and bigger models still fit in the SRAM scratch
+	alloc_on_heap = r_anumverts * sizeof(finalvert_t);
+	if (!currententity->trivial_accept)
+		alloc_on_heap += r_anumverts * sizeof(auxvert_t);
+	if (alloc_on_heap <= (sizeof(finalvert_t) + sizeof(auxvert_t)) * 400) {	// tweakme, default seems to perform well
+		pfinalverts = (finalvert_t *)(Arena_Alloc(&aux_arena, sizeof(finalvert_t)*r_anumverts));
+		if (currententity->trivial_accept)
+			pauxverts = &auxverts[0];
+		else
+			pauxverts = (auxvert_t *)(Arena_Alloc(&aux_arena, sizeof(auxvert_t)*r_anumverts));
 	} else {
 		// cache align
 		pfinalverts = &finalverts[0];
 		pauxverts = &auxverts[0];
-		alloc_on_heap = 0;
 	}
 
 	R_AliasSetupSkin ();
 	R_AliasSetUpTransform (currententity->trivial_accept);
+	R_AliasSetUpFixedTransform ();
 	R_AliasSetupLighting (plighting);
 	R_AliasSetupFrame ();
 
@@ -744,9 +885,5 @@ void R_AliasDrawModel (alight_t *plighting)
 		R_AliasPrepareUnclippedPoints ();
 	else
 		R_AliasPreparePoints ();
-
-	if (alloc_on_heap) {
-		AUXA_FreeToRover(auxa_rover);
-	}
 }
 
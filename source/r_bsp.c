@@ -336,9 +336,9 @@ void R_DrawSolidClippedSubmodelPolygons (model_t *pmodel)
 	int			numsurfaces;
 	mplane_t	*pplane;
 
-	uint8_t 	*zba_rover = ZBA_GetRover();
-	mvertex_t	*bverts = ZBA_Alloc(sizeof(mvertex_t) * MAX_BMODEL_VERTS);
-	bedge_t	    *bedges = ZBA_Alloc(sizeof(bedge_t)   * MAX_BMODEL_EDGES);
+	ARENA_SCOPE (zbuffer_arena);
+	mvertex_t	*bverts = Arena_Alloc(&zbuffer_arena, sizeof(mvertex_t) * MAX_BMODEL_VERTS);
+	bedge_t	    *bedges = Arena_Alloc(&zbuffer_arena, sizeof(bedge_t)   * MAX_BMODEL_EDGES);
 	bedge_t		*pbedge;
 
 	medge_t		*pedge, *pedges;
@@ -406,8 +406,6 @@ void R_DrawSolidClippedSubmodelPolygons (model_t *pmodel)
 			}
 		}
 	}
-
-	ZBA_FreeToRover(zba_rover);
 }
 
 
@@ -667,8 +665,8 @@ void R_RenderWorld (void)
 	int			i;
 	model_t		*clmodel;
 
-	uint8_t 	*zba_rover = ZBA_GetRover();
-	pbtofpolys = ZBA_Alloc(sizeof(btofpoly_t) * MAX_BTOFPOLYS);
+	ARENA_SCOPE (zbuffer_arena);
+	pbtofpolys = Arena_Alloc(&zbuffer_arena, sizeof(btofpoly_t) * MAX_BTOFPOLYS);
 
 	currententity = &cl_entities[0];
 	VectorCopy (r_origin, modelorg);
@@ -676,7 +674,7 @@ void R_RenderWorld (void)
 	r_pcurrentvertbase = clmodel->vertexes;
 
 	// allocate and clear marksurfaces visdata
-	msurfvis = ZBA_Alloc((MAX_MAP_MARKSURFACES+7)>>3);
+	msurfvis = Arena_Alloc(&zbuffer_arena, (MAX_MAP_MARKSURFACES+7)>>3);
 	memset(msurfvis, 0, (clmodel->nummarksurfaces+7)>>3);
 
 	R_RecursiveWorldNode (clmodel->nodes, 15);
@@ -691,9 +689,6 @@ void R_RenderWorld (void)
 			R_RenderPoly (pbtofpolys[i].psurf, pbtofpolys[i].clipflags);
 		}
 	}
-
-	ZBA_FreeToRover(zba_rover);
-
 }
 
 
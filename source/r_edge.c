@@ -674,8 +674,8 @@ void __no_inline_not_in_flash_func(R_ScanEdges) ()
 	int		iv, bottom;
 	surf_t	*s;
 
-	uint8_t *auxa_rover = AUXA_GetRover();
-	byte    *basespans  = (byte*)AUXA_Alloc((MAXSPANS+1)*sizeof(espan_t));
+	ARENA_SCOPE (aux_arena);
+	byte    *basespans  = (byte*)Arena_Alloc(&aux_arena, (MAXSPANS+1)*sizeof(espan_t));
 
 	espan_t* basespan_p = (espan_t*)(basespans);
 	max_span_p = &basespan_p[MAXSPANS - r_refdef.vrect.width];
@@ -710,7 +710,7 @@ void __no_inline_not_in_flash_func(R_ScanEdges) ()
 	edge_sentinel.prev = edge_aftertail_idx;
 
 	edge_t			*ebuf = edgebuf;		//
-	int 			zbuf_limit = ZBA_GetZBufferMaxRow();
+	int 			zbuf_limit = Arena_SharedRows(&zbuffer_arena) - 1;	// last row below the z-buffer arena
 
 //	
 // process all scan lines
@@ -733,7 +733,7 @@ void __no_inline_not_in_flash_func(R_ScanEdges) ()
 		(*pdrawfunc) ();
 
 	// flush the span list if we can't be sure we have enough spans left for
-	// the next scan, and on the z-buffer allocatior watermark so we could defer the flush-to-PSRAM as late as possible
+	// the next scan, and on the z-buffer arena watermark so we could defer the flush-to-PSRAM as late as possible
 		if ((span_p >= max_span_p) || ((edgebuf_swap != auxedges) && (iv == zbuf_limit)))
 		{
 			if (iv > zbuf_limit && edgebuf_swap != auxedges) {
@@ -746,6 +746,7 @@ void __no_inline_not_in_flash_func(R_ScanEdges) ()
 				edgebuf_swap = auxedges;
 				ebuf      	 = edgebuf_swap;
 				edgebuf      = edgebuf_swap;
+				Arena_Reclaim(&zbuffer_arena);
 			}
 
 			VID_UnlockBuffer ();
@@ -798,7 +799,8 @@ void __no_inline_not_in_flash_func(R_ScanEdges) ()
 		D_DrawSurfaces ();
 	}
 
-	AUXA_FreeToRover(auxa_rover);
+// the last spans may have gone over whatever was left in the z-buffer arena
+	Arena_Reclaim(&zbuffer_arena);
 }
 
 
@@ -70,6 +70,15 @@ extern cvar_t	r_numsurfs;
 extern cvar_t	r_reportedgeout;
 extern cvar_t	r_maxedges;
 extern cvar_t	r_numedges;
+extern cvar_t	r_lod;
+extern cvar_t	r_lodradius;
+extern cvar_t	r_lodstats;
+extern cvar_t	r_dynres;
+extern cvar_t	r_dynres_fps;
+extern cvar_t	r_dynres_min;
+extern cvar_t	r_dynres_max;
+extern cvar_t	r_dynres_band;
+extern cvar_t	r_dynres_hold;
 
 #ifdef Q_ALIAS_DOUBLE_TO_FLOAT_RENDER
 #define XCENTERING	(1.0f / 2.0f)
@@ -253,10 +262,13 @@ qboolean R_AliasCheckBBox (void);
 void R_DrawParticles (void);
 void R_InitParticles (void);
 void R_ClearParticles (void);
+void R_KickParticles (void);
+void R_ParticleWorker (void);
 void R_ReadPointFile_f (void);
 void R_SurfacePatch (void);
 
 extern int		r_amodels_drawn;
+extern int		r_alodtris, r_alodsaved;
 extern edge_t	*auxedges;
 extern int		r_numallocatededges;
 extern edge_t	*r_edges, *edge_p, *edge_max;
@@ -289,6 +301,9 @@ extern int		r_maxsurfsseen, r_maxedgesseen, r_cnumsurfs;
 extern qboolean	r_surfsonstack;
 extern cshift_t	cshift_water;
 extern qboolean	r_dowarpold, r_viewchanged;
+extern float	r_viewscale;
+extern qboolean	r_viewscaled;
+extern vrect_t	r_fullvrect;
 
 extern mleaf_t	*r_viewleaf, *r_oldviewleaf;
 
@@ -302,6 +317,7 @@ void R_StoreEfrags (efrag_t **ppefrag);
 void R_TimeRefresh_f (void);
 void R_TimeGraph (void);
 void R_PrintAliasStats (void);
+void R_PrintLodStats (void);
 void R_PrintTimes (void);
 void R_PrintDSpeeds (void);
 void R_SaveDSpeeds (void);
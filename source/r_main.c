@@ -21,6 +21,8 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "r_local.h"
+#include "kcapture.h"
+#include "sctrace.h"
 
 //define	PASSAGES
 
@@ -48,8 +50,6 @@ int			r_maxsurfsseen, r_maxedgesseen, r_cnumsurfs;
 qboolean	r_surfsonstack;
 int			r_clipflags;
 
-byte		*r_warpbuffer;
-
 byte		*r_stack_start;
 
 qboolean	r_fov_greater_than_90;
@@ -135,6 +135,19 @@ cvar_t	r_maxedges = {"r_maxedges", "0"};
 cvar_t	r_numedges = {"r_numedges", "0"};
 cvar_t	r_aliastransbase = {"r_aliastransbase", "200"};
 cvar_t	r_aliastransadj = {"r_aliastransadj", "100"};
+cvar_t	r_lod = {"r_lod", "1"};
+cvar_t	r_lodradius = {"r_lodradius", "24"};	// projected radius in pixels
+cvar_t	r_lodstats = {"r_lodstats", "0"};
+cvar_t	r_dynres = {"r_dynres", "0", true};
+cvar_t	r_dynres_fps = {"r_dynres_fps", "30", true};	// frame rate to hold
+cvar_t	r_dynres_min = {"r_dynres_min", "0.5", true};	// of the full view size
+cvar_t	r_dynres_max = {"r_dynres_max", "1", true};
+cvar_t	r_dynres_band = {"r_dynres_band", "0.1"};		// +- around the target
+cvar_t	r_dynres_hold = {"r_dynres_hold", "8"};		// frames between steps
+
+float		r_viewscale = 1;	// of the view, set by R_DynamicResolution
+qboolean	r_viewscaled;		// r_refdef.vrect is smaller than r_fullvrect
+vrect_t		r_fullvrect;		// where the view is presented
 
 extern cvar_t	scr_fov;
 
@@ -166,6 +179,7 @@ void	R_InitTextures (void)
 	for (m=0 ; m<4 ; m++)
 	{
 		dest = (byte *)r_notexture_mip + r_notexture_mip->offsets[m];
+		r_notexture_mip->mips[m] = dest;
 		for (y=0 ; y< (16>>m) ; y++)
 			for (x=0 ; x< (16>>m) ; x++)
 			{
@@ -194,6 +208,9 @@ void R_Init (void)
 	Cmd_AddCommand ("timerefresh", R_TimeRefresh_f);	
 	Cmd_AddCommand ("pointfile", R_ReadPointFile_f);	
 
+	KCap_Init ();
+	SCTrace_Init ();
+
 	Cvar_RegisterVariable (&r_draworder);
 	Cvar_RegisterVariable (&r_speeds);
 	Cvar_RegisterVariable (&r_timegraph);
@@ -215,6 +232,15 @@ void R_Init (void)
 	Cvar_RegisterVariable (&r_numedges);
 	Cvar_RegisterVariable (&r_aliastransbase);
 	Cvar_RegisterVariable (&r_aliastransadj);
+	Cvar_RegisterVariable (&r_lod);
+	Cvar_RegisterVariable (&r_lodradius);
+	Cvar_RegisterVariable (&r_lodstats);
+	Cvar_RegisterVariable (&r_dynres);
+	Cvar_RegisterVariable (&r_dynres_fps);
+	Cvar_RegisterVariable (&r_dynres_min);
+	Cvar_RegisterVariable (&r_dynres_max);
+	Cvar_RegisterVariable (&r_dynres_band);
+	Cvar_RegisterVariable (&r_dynres_hold);
 
 	Cvar_SetValue ("r_maxedges", (float)NUMSTACKEDGES);
 	Cvar_SetValue ("r_maxsurfs", (float)NUMSTACKSURFACES);
@@ -362,6 +388,20 @@ void R_ViewChanged (vrect_t *pvrect, int lineadj, float aspect)
 
 	R_SetVrect (pvrect, &r_refdef.vrect, lineadj);
 
+// dynamic resolution draws a smaller view in the same corner, and
+// D_UpscaleView stretches it back over r_fullvrect
+	r_fullvrect = r_refdef.vrect;
+	if (r_viewscale < 1)
+	{
+		r_refdef.vrect.width = (int)(r_fullvrect.width * r_viewscale) & ~7;
+		if (r_refdef.vrect.width < 64)
+			r_refdef.vrect.width = 64;
+		r_refdef.vrect.height = (r_fullvrect.height * r_refdef.vrect.width /
+				r_fullvrect.width) & ~1;
+	}
+	r_viewscaled = r_refdef.vrect.width != r_fullvrect.width ||
+			r_refdef.vrect.height != r_fullvrect.height;
+
 	r_refdef.horizontalFieldOfView = 2.0 * tan (r_refdef.fov_x/360*M_PI);
 	r_refdef.fvrectx = (float)r_refdef.vrect.x;
 	r_refdef.fvrectx_adj = (float)r_refdef.vrect.x - 0.5;
@@ -481,6 +521,7 @@ void R_MarkLeaves (void)
 	r_oldviewleaf = r_viewleaf;
 
 	vis = Mod_LeafPVS (r_viewleaf, cl.worldmodel);
+	Mod_PrefetchTextures (cl.worldmodel, vis);
 		
 	for (i=0 ; i<cl.worldmodel->numleafs ; i++)
 	{
@@ -851,10 +892,11 @@ R_EdgeDrawing
 static void R_EdgeDrawing ()
 {
 	//surf_t lsurfs[NUMSTACKSURFACES + ((CACHE_SIZE - 1) / sizeof(surf_t)) + 1];
-	uint8_t *auxa_rover = AUXA_GetRover();
+	// the z-buffer is free again, drop whatever level loading left in it
+	Arena_Reset(&zbuffer_arena);
 
-	// reset Z-Buffer allocator
-    ZBA_Reset();
+	ARENA_SCOPE (aux_arena);
+	ARENA_SCOPE (zbuffer_arena);
 
     // allocate edge buffer
     if (r_numallocatededges > NUMSTACKEDGES)
@@ -863,7 +905,7 @@ static void R_EdgeDrawing ()
 	}
 	else
 	{
-		edgebuf_swap = ZBA_Alloc(sizeof(edge_t)*(NUMSTACKEDGES+RESERVED_EDGES));
+		edgebuf_swap = Arena_Alloc(&zbuffer_arena, sizeof(edge_t)*(NUMSTACKEDGES+RESERVED_EDGES));
 	}
 
 	// forward egde storage
@@ -873,7 +915,7 @@ static void R_EdgeDrawing ()
 	if (r_surfsonstack)
 	{
 		//surfaces =  (surf_t *)(((intptr_t)lsurfs + CACHE_SIZE - 1) & ~(CACHE_SIZE - 1));
-		surfaces = (surf_t*)AUXA_Alloc(NUMSTACKSURFACES*sizeof(surf_t));
+		surfaces = (surf_t*)Arena_Alloc(&aux_arena, NUMSTACKSURFACES*sizeof(surf_t));
 		surf_max = &surfaces[r_cnumsurfs];
 	// surface 0 doesn't really exist; it's just a dummy because index 0
 	// is used to indicate no edge attached to surface
@@ -924,10 +966,6 @@ static void R_EdgeDrawing ()
 		//R_ScanEdges ();
 		stackcall_alloc(R_ScanEdges, 2048);
 	}
-
-	// reset Z-buffer allocator (the buffer is dead at this moment)
-	ZBA_Reset();
-	AUXA_FreeToRover(auxa_rover);
 }
 
 
@@ -938,12 +976,8 @@ R_RenderView
 r_refdef must be set before the first call
 ================
 */
-static byte warpbuffer[WARP_WIDTH * WARP_HEIGHT] __psram_bss("warpbuffer");
-
 void R_RenderView_ (void)
 {
-	r_warpbuffer = NULL;
-
 	if (r_timegraph.value || r_speeds.value || (r_dspeeds.value || cls.frametimedemo))
 		r_time1 = Sys_FloatTime ();
 
@@ -954,6 +988,7 @@ SetVisibilityByPassages ();
 #else
 	R_MarkLeaves ();	// done here so we know if we're in water
 #endif
+	Mod_PrefetchStep ();
 
 // make FDIV fast. This reduces timing precision after we've been running for a
 // while, so we don't do it globally.  This also sets chop mode, and we do it
@@ -963,6 +998,8 @@ SetVisibilityByPassages ();
 
 	if (!cl_entities[0].model || !cl.worldmodel)
 		Sys_Error ("R_RenderView: NULL worldmodel");
+
+	R_KickParticles ();	// simulated on core 1 under the world
 		
 	if (!(r_dspeeds.value || cls.frametimedemo))
 	{
@@ -1010,8 +1047,11 @@ SetVisibilityByPassages ();
 	if ((r_dspeeds.value || cls.frametimedemo))
 		dp_time2 = Sys_FloatTime ();
 
+	if (r_viewscaled)
+		D_UpscaleView (&r_refdef.vrect, &r_fullvrect);
+
 	if (r_dowarp)
-		D_WarpScreen ();
+		D_WarpScreen (&r_fullvrect);
 
 	V_SetContentsColor (r_viewleaf->contents);
 
@@ -1020,6 +1060,9 @@ SetVisibilityByPassages ();
 
 	if (r_aliasstats.value)
 		R_PrintAliasStats ();
+
+	if (r_lodstats.value)
+		R_PrintLodStats ();
 		
 	if (r_speeds.value && !cls.frametimedemo)
 		R_PrintTimes ();
@@ -1053,12 +1096,11 @@ void R_RenderView (void)
 	if ( (intptr_t)(&dummy) & 3 )
 		Sys_Error ("Stack is missaligned");
 
-	if ( (intptr_t)(&r_warpbuffer) & 3 )
-		Sys_Error ("Globals are missaligned");
-
 	if (!in_render_view) {
 		in_render_view = true;
+		KCap_BeginFrame ();
 		R_RenderView_ ();
+		KCap_EndFrame ();
 		in_render_view = false;
 	}
 }
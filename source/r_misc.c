@@ -119,9 +119,10 @@ void R_LineGraph (int x, int y, int h)
 	x += r_refdef.vrect.x;
 	y += r_refdef.vrect.y;
 	
-	dest = vid.buffer + vid.rowbytes*y + x;
-	
 	s = r_graphheight.value;
+
+	D_WarpOverdraw (x, y - s*2, 1, s*2 + 1);
+	dest = vid.buffer + vid.rowbytes*y + x;
 	
 	if (h>s)
 		h = s;
@@ -248,6 +249,8 @@ void R_SaveDSpeeds (void)
 	p->polycount = r_polycount;
 	p->drawnpolycount = r_drawnpolycount;
 	p->surf = c_surf; c_surf = 0;
+	p->scale = r_viewscale;
+	p->mipbias = d_mipbias;
 	p->dp = (dp_time2 - dp_time1) * 1000;
 	p->rw = (rw_time2 - rw_time1) * 1000;
 	p->db = (db_time2 - db_time1) * 1000;
@@ -268,15 +271,26 @@ void R_PrintAliasStats (void)
 	Con_Printf ("%3i polygon model drawn\n", r_amodels_drawn);
 }
 
+/*
+=============
+R_PrintLodStats
+=============
+*/
+void R_PrintLodStats (void)
+{
+	Con_Printf ("%3i models: %5i tris, %5i saved by lod\n",
+			r_amodels_drawn, r_alodtris, r_alodsaved);
+}
+
 
 void WarpPalette (void)
 {
 	int		i,j;
 	static const int basecolor[3] = { 130, 80, 50 };
-	uint8_t *auxa_rover = AUXA_GetRover();
+	ARENA_SCOPE (aux_arena);
 
 // pull the colors halfway to bright brown
-	byte* newpalette = (byte*)AUXA_Alloc(768);
+	byte* newpalette = (byte*)Arena_Alloc(&aux_arena, 768);
 	for (i=0 ; i<256 ; i++)
 	{
 		for (j=0 ; j<3 ; j++)
@@ -286,7 +300,6 @@ void WarpPalette (void)
 	}
 	
 	VID_ShiftPalette (newpalette);
-	AUXA_FreeToRover(auxa_rover);
 }
 
 
@@ -378,6 +391,86 @@ void R_SetUpFrustumIndexes (void)
 }
 
 
+/*
+===============
+R_DynamicResolution
+
+Picks the view scale from the recent frame times. Going down is as far as
+the frame time asks for at once, going up one step at a time, and after
+each step the scale holds for r_dynres_hold frames. Frame times inside
+r_dynres_band of the target leave it where it is. r_dynresfloor tells
+D_MipGovernor, which runs after this, whether the frame time is still
+being answered here.
+===============
+*/
+#define	DYNRES_STEPS	16		// scale is a multiple of 1/DYNRES_STEPS
+
+qboolean	r_dynresfloor;		// r_dynres is off or the view is as small as allowed
+
+static void R_DynamicResolution (void)
+{
+	static double	lasttime;
+	static float	avg;
+	static int		hold;
+	double			now;
+	float			frametime, target, lo, hi;
+	int				step, newstep;
+
+	now = Sys_FloatTime ();
+	frametime = now - lasttime;
+	lasttime = now;
+
+	lo = r_dynres_min.value < 0.25 ? 0.25 : r_dynres_min.value;
+	hi = r_dynres_max.value > 1 ? 1 : r_dynres_max.value;
+	if (hi < lo)
+		hi = lo;
+	step = (int)(r_viewscale * DYNRES_STEPS + 0.5);
+
+	// hashdemo frames have to come out the same every run
+	if (!r_dynres.value || cls.hashdemo || r_dynres_fps.value <= 0)
+	{
+		newstep = DYNRES_STEPS;
+		avg = 0;
+		r_dynresfloor = true;
+	}
+	else if (frametime <= 0 || frametime > 0.5)
+	{	// loading or paused, not a frame worth going by
+		newstep = step;
+		avg = 0;
+	}
+	else
+	{
+		avg = avg ? avg + (frametime - avg) * 0.25 : frametime;
+		target = 1.0 / r_dynres_fps.value;
+		newstep = step;
+
+		if (hold > 0)
+			hold--;
+		else if (avg > target * (1 + r_dynres_band.value))
+		{	// the pixel count goes with the square of the scale
+			newstep = (int)(step * sqrt (target / avg));
+			if (newstep >= step)
+				newstep = step - 1;
+		}
+		else if (avg < target * (1 - r_dynres_band.value))
+			newstep = step + 1;
+
+		if (newstep < (int)ceil (lo * DYNRES_STEPS))
+			newstep = (int)ceil (lo * DYNRES_STEPS);
+		if (newstep > (int)(hi * DYNRES_STEPS))
+			newstep = (int)(hi * DYNRES_STEPS);
+		r_dynresfloor = newstep <= (int)ceil (lo * DYNRES_STEPS);
+	}
+
+	if (newstep != step)
+	{
+		r_viewscale = (float)newstep / DYNRES_STEPS;
+		r_viewchanged = true;
+		hold = (int)r_dynres_hold.value;
+	}
+}
+
+
 /*
 ===============
 R_SetupFrame
@@ -454,6 +547,8 @@ r_refdef.viewangles[2]=    0;
 	r_oldviewleaf = r_viewleaf;
 	r_viewleaf = Mod_PointInLeaf (r_origin, cl.worldmodel);
 
+	R_DynamicResolution ();
+
 	r_dowarpold = r_dowarp;
 	r_dowarp = r_waterwarp.value && (r_viewleaf->contents <= CONTENTS_WATER);
 
@@ -525,6 +620,7 @@ r_refdef.viewangles[2]=    0;
 
 	R_SetUpFrustumIndexes ();
 
+	D_MipGovernor ();	// before the last frame's cache state goes
 	r_cache_thrash = false;
 
 // clear frame counts
@@ -534,6 +630,8 @@ r_refdef.viewangles[2]=    0;
 	r_drawnpolycount = 0;
 	r_wholepolycount = 0;
 	r_amodels_drawn = 0;
+	r_alodtris = 0;
+	r_alodsaved = 0;
 	r_outofsurfaces = 0;
 	r_outofedges = 0;
 
@@ -30,15 +30,247 @@ int		ramp1[8] = {0x6f, 0x6d, 0x6b, 0x69, 0x67, 0x65, 0x63, 0x61};
 int		ramp2[8] = {0x6f, 0x6e, 0x6d, 0x6c, 0x6b, 0x6a, 0x68, 0x66};
 int		ramp3[8] = {0x6d, 0x6b, 6, 5, 4, 3};
 
-particle_t	*active_particles, *free_particles;
-
-particle_t	*particles;
 int			r_numparticles;
 
 vec3_t			r_pright, r_pup, r_ppn;
 
+/*
+==============================================================================
+
+PARTICLE STORAGE
+
+Each particle field is its own array in sram, the live particles packed
+at the front of them.  A particle is moved on the frame after it was
+drawn: R_SimulateParticles first gives the ones drawn last frame, the
+first r_partdrawn, the move that followed their draw, then takes this
+frame's time off every die and swaps the expired ones out from the end.
+It runs on core 1 while core 0 draws the world, R_SyncParticles waits
+for it before anything else touches the arrays.
+
+==============================================================================
+*/
+
+static float		part_org[3][MAX_PARTICLES];
+#ifdef Q_PARTICLES_FP16
+static vechalf_t	part_vel[3][MAX_PARTICLES];
+#else
+static float		part_vel[3][MAX_PARTICLES];
+#endif
+static float		part_die[MAX_PARTICLES];
+static short		part_ramp[MAX_PARTICLES];	// q5.10
+static byte			part_color[MAX_PARTICLES];
+static ptype_t		part_type[MAX_PARTICLES];
+
+static int			r_activeparticles;
+static int			r_partdrawn;
+
+typedef struct
+{
+	float	frametime;
+	float	grav, dvel;
+	int		time1, time2, time3;
+} partmove_t;
+
+static partmove_t	r_partmove;		// the move owed by the drawn particles
+static float		r_partkill;		// taken off every die
+
+#define	PARTJOB_POSTED	1	// by R_KickParticles
+#define	PARTJOB_RUNNING	2	// taken by core 1
+
+static volatile int			r_partjob;		// PARTJOB_*, 0 when done
+static volatile qboolean	r_partworker;	// core 1 polls R_ParticleWorker
+
 #define CLTIME_F() ((float)cl.time)
 
+static void R_SimulateParticles (void);
+
+/*
+===============
+R_SyncParticles
+
+Finishes the simulation posted by R_KickParticles.  Core 1 only polls
+between its rows, so a job it has not taken yet is taken back and run
+here, and core 0 only ever waits for one that is already running.
+===============
+*/
+static void R_SyncParticles (void)
+{
+	if (r_partjob == PARTJOB_POSTED
+	&& __sync_bool_compare_and_swap (&r_partjob, PARTJOB_POSTED, 0))
+	{
+		R_SimulateParticles ();
+		return;
+	}
+
+	while (r_partjob)
+		;
+	__sync_synchronize ();
+}
+
+/*
+===============
+R_AllocParticle
+
+returns the index of a new particle with no velocity, or -1
+===============
+*/
+static int R_AllocParticle (void)
+{
+	int		p;
+
+	R_SyncParticles ();
+	if (r_activeparticles >= r_numparticles)
+		return -1;
+
+	p = r_activeparticles++;
+	part_vel[0][p] = part_vel[1][p] = part_vel[2][p] = 0;
+	part_ramp[p] = 0;
+	return p;
+}
+
+/*
+===============
+R_SimulateParticles
+===============
+*/
+static void __not_in_flash_func(R_SimulateParticles) (void)
+{
+	int			i, j, last;
+	float		frametime, grav, dvel;
+	int			time1, time2, time3;
+
+	frametime = r_partmove.frametime;
+	grav = r_partmove.grav;
+	dvel = r_partmove.dvel;
+	time1 = r_partmove.time1;
+	time2 = r_partmove.time2;
+	time3 = r_partmove.time3;
+
+	for (i=0 ; i<r_partdrawn ; i++)
+	{
+		part_org[0][i] += part_vel[0][i]*frametime;
+		part_org[1][i] += part_vel[1][i]*frametime;
+		part_org[2][i] += part_vel[2][i]*frametime;
+		
+		switch (part_type[i])
+		{
+		case pt_static:
+			break;
+		case pt_fire:
+			part_ramp[i] += time1;
+			if (part_ramp[i] >= (6 << PARTICLE_RAMP_FRACT))
+				part_die[i] = -1;
+			else
+				part_color[i] = ramp3[part_ramp[i] >> PARTICLE_RAMP_FRACT];
+			part_vel[2][i] += grav;
+			break;
+
+		case pt_explode:
+			part_ramp[i] += time2;
+			if (part_ramp[i] >= (8 << PARTICLE_RAMP_FRACT))
+				part_die[i] = -1;
+			else
+				part_color[i] = ramp1[part_ramp[i] >> PARTICLE_RAMP_FRACT];
+			for (j=0 ; j<3 ; j++)
+				part_vel[j][i] += part_vel[j][i]*dvel;
+			part_vel[2][i] -= grav;
+			break;
+
+		case pt_explode2:
+			part_ramp[i] += time3;
+			if (part_ramp[i] >= (8 << PARTICLE_RAMP_FRACT))
+				part_die[i] = -1;
+			else
+				part_color[i] = ramp2[part_ramp[i] >> PARTICLE_RAMP_FRACT];
+			for (j=0 ; j<3 ; j++)
+				part_vel[j][i] -= part_vel[j][i]*frametime;
+			part_vel[2][i] -= grav;
+			break;
+
+		case pt_blob:
+			for (j=0 ; j<3 ; j++)
+				part_vel[j][i] += part_vel[j][i]*dvel;
+			part_vel[2][i] -= grav;
+			break;
+
+		case pt_blob2:
+			for (j=0 ; j<2 ; j++)
+				part_vel[j][i] -= part_vel[j][i]*dvel;
+			part_vel[2][i] -= grav;
+			break;
+
+		case pt_grav:
+		case pt_slowgrav:
+			part_vel[2][i] -= grav;
+			break;
+		}
+	}
+	r_partdrawn = 0;
+
+// kill the expired ones, the last live particle takes the slot
+	for (i=0 ; i<r_activeparticles ; )
+	{
+		if ((part_die[i] -= r_partkill) >= 0.0f)
+		{
+			i++;
+			continue;
+		}
+
+		last = --r_activeparticles;
+		for (j=0 ; j<3 ; j++)
+		{
+			part_org[j][i] = part_org[j][last];
+			part_vel[j][i] = part_vel[j][last];
+		}
+		part_die[i] = part_die[last];
+		part_ramp[i] = part_ramp[last];
+		part_color[i] = part_color[last];
+		part_type[i] = part_type[last];
+	}
+}
+
+/*
+===============
+R_ParticleWorker
+
+Polled by core 1 between its other work, runs a posted simulation
+===============
+*/
+void __not_in_flash_func(R_ParticleWorker) (void)
+{
+	r_partworker = true;
+	if (r_partjob != PARTJOB_POSTED
+	|| !__sync_bool_compare_and_swap (&r_partjob, PARTJOB_POSTED, PARTJOB_RUNNING))
+		return;		// nothing posted, or core 0 took it back
+
+	R_SimulateParticles ();
+	__sync_synchronize ();
+	r_partjob = 0;
+}
+
+/*
+===============
+R_KickParticles
+
+Starts this frame's simulation, on core 1 when it is polling for it and
+inline otherwise. The client has spawned its particles by now.
+===============
+*/
+void R_KickParticles (void)
+{
+	R_SyncParticles ();
+
+	r_partkill = cl.time - cl.oldtime;
+
+	if (r_partworker)
+	{
+		__sync_synchronize ();
+		r_partjob = PARTJOB_POSTED;
+	}
+	else
+		R_SimulateParticles ();
+}
+
 /*
 ===============
 R_InitParticles
@@ -55,14 +287,13 @@ void R_InitParticles (void)
 		r_numparticles = (int)(Q_atoi(com_argv[i+1]));
 		if (r_numparticles < ABSOLUTE_MIN_PARTICLES)
 			r_numparticles = ABSOLUTE_MIN_PARTICLES;
+		if (r_numparticles > MAX_PARTICLES)
+			r_numparticles = MAX_PARTICLES;
 	}
 	else
 	{
 		r_numparticles = MAX_PARTICLES;
 	}
-
-	particles = (particle_t *)
-			Hunk_AllocName (r_numparticles * sizeof(particle_t), "particles");
 }
 
 /*
@@ -84,7 +315,7 @@ void R_EntityParticles (entity_t *ent)
 {
 	int			count;
 	int			i;
-	particle_t	*p;
+	int			p;
 	float		angle;
 	float		sr, sp, sy, cr, cp, cy;
 	vec3_t		forward;
@@ -118,20 +349,16 @@ avelocities[0][i] = (rand()&255) * 0.01f;
 		forward[1] = cp*sy;
 		forward[2] = -sp;
 
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
-
-		p->die = 0.01f;
-		p->color = 0x6f;
-		p->type = pt_explode;
+
+		part_die[p] = 0.01f;
+		part_color[p] = 0x6f;
+		part_type[p] = pt_explode;
 		
-		p->org[0] = ent->origin[0] + r_avertexnormals[i][0]*dist + forward[0]*beamlength;			
-		p->org[1] = ent->origin[1] + r_avertexnormals[i][1]*dist + forward[1]*beamlength;			
-		p->org[2] = ent->origin[2] + r_avertexnormals[i][2]*dist + forward[2]*beamlength;			
+		part_org[0][p] = ent->origin[0] + r_avertexnormals[i][0]*dist + forward[0]*beamlength;			
+		part_org[1][p] = ent->origin[1] + r_avertexnormals[i][1]*dist + forward[1]*beamlength;			
+		part_org[2][p] = ent->origin[2] + r_avertexnormals[i][2]*dist + forward[2]*beamlength;			
 	}
 }
 #else
@@ -139,7 +366,7 @@ void R_EntityParticles (entity_t *ent)
 {
 	int			count;
 	int			i;
-	particle_t	*p;
+	int			p;
 	float		angle;
 	float		sr, sp, sy, cr, cp, cy;
 	vec3_t		forward;
@@ -171,20 +398,16 @@ avelocities[0][i] = (rand()&255) * 0.01;
 		forward[1] = cp*sy;
 		forward[2] = -sp;
 
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
-
-		p->die = cl.time + 0.01;
-		p->color = 0x6f;
-		p->type = pt_explode;
+
+		part_die[p] = 0.01;
+		part_color[p] = 0x6f;
+		part_type[p] = pt_explode;
 		
-		p->org[0] = ent->origin[0] + r_avertexnormals[i][0]*dist + forward[0]*beamlength;			
-		p->org[1] = ent->origin[1] + r_avertexnormals[i][1]*dist + forward[1]*beamlength;			
-		p->org[2] = ent->origin[2] + r_avertexnormals[i][2]*dist + forward[2]*beamlength;			
+		part_org[0][p] = ent->origin[0] + r_avertexnormals[i][0]*dist + forward[0]*beamlength;			
+		part_org[1][p] = ent->origin[1] + r_avertexnormals[i][1]*dist + forward[1]*beamlength;			
+		part_org[2][p] = ent->origin[2] + r_avertexnormals[i][2]*dist + forward[2]*beamlength;			
 	}
 }
 #endif
@@ -197,24 +420,19 @@ R_ClearParticles
 */
 void R_ClearParticles (void)
 {
-	int		i;
-	
-	free_particles = &particles[0];
-	active_particles = NULL;
+	R_SyncParticles ();
 
-	for (i=0 ;i<r_numparticles ; i++)
-		particles[i].next = &particles[i+1];
-	particles[r_numparticles-1].next = NULL;
+	r_activeparticles = 0;
+	r_partdrawn = 0;
 }
 
-
 void R_ReadPointFile_f (void)
 {
 	FIL		*f;
 	vec3_t	org;
 	int		r;
-	int		c;
-	particle_t	*p;
+	int		c, j;
+	int		p;
 	char	name[MAX_OSPATH];
 	
 	snprintf (name, MAX_OSPATH, "maps/%s.pts", svp.name);
@@ -235,21 +453,17 @@ void R_ReadPointFile_f (void)
 			break;
 		c++;
 		
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 		{
 			Con_Printf ("Not enough free particles\n");
 			break;
 		}
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 		
-		p->die = 99999;
-		p->color = (-c)&15;
-		p->type = pt_static;
-		VectorCopy (vec3_origin, p->vel);
-		VectorCopy (org, p->org);
+		part_die[p] = 99999;
+		part_color[p] = (-c)&15;
+		part_type[p] = pt_static;
+		for (j=0 ; j<3 ; j++)
+			part_org[j][p] = org[j];
 	}
 
 	f_close (f);
@@ -293,39 +507,35 @@ R_ParticleExplosion
 void R_ParticleExplosion (vec3_t org)
 {
 	int			i, j;
-	particle_t	*p;
+	int			p;
 	float 		cltime_f;
 
 	cltime_f    = CLTIME_F();
 
 	for (i=0 ; i<1024 ; i++)
 	{
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
-
-		p->die = 5.0f;
-		p->color = ramp1[0];
-		p->ramp = (rand()&3) << PARTICLE_RAMP_FRACT;
+
+		part_die[p] = 5.0f;
+		part_color[p] = ramp1[0];
+		part_ramp[p] = (rand()&3) << PARTICLE_RAMP_FRACT;
 		if (i & 1)
 		{
-			p->type = pt_explode;
+			part_type[p] = pt_explode;
 			for (j=0 ; j<3 ; j++)
 			{
-				p->org[j] = org[j] + ((rand()%32)-16);
-				p->vel[j] = (rand()%512)-256;
+				part_org[j][p] = org[j] + ((rand()%32)-16);
+				part_vel[j][p] = (rand()%512)-256;
 			}
 		}
 		else
 		{
-			p->type = pt_explode2;
+			part_type[p] = pt_explode2;
 			for (j=0 ; j<3 ; j++)
 			{
-				p->org[j] = org[j] + ((rand()%32)-16);
-				p->vel[j] = (rand()%512)-256;
+				part_org[j][p] = org[j] + ((rand()%32)-16);
+				part_vel[j][p] = (rand()%512)-256;
 			}
 		}
 	}
@@ -340,7 +550,7 @@ R_ParticleExplosion2
 void R_ParticleExplosion2 (vec3_t org, int colorStart, int colorLength)
 {
 	int			i, j;
-	particle_t	*p;
+	int			p;
 	int			colorMod = 0;
 	float		cltime_f;
 
@@ -348,22 +558,18 @@ void R_ParticleExplosion2 (vec3_t org, int colorStart, int colorLength)
 
 	for (i=0; i<512; i++)
 	{
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
-		p->die = 0.3f;
-		p->color = colorStart + (colorMod % colorLength);
+		part_die[p] = 0.3f;
+		part_color[p] = colorStart + (colorMod % colorLength);
 		colorMod++;
 
-		p->type = pt_blob;
+		part_type[p] = pt_blob;
 		for (j=0 ; j<3 ; j++)
 		{
-			p->org[j] = org[j] + ((rand()%32)-16);
-			p->vel[j] = (rand()%512)-256;
+			part_org[j][p] = org[j] + ((rand()%32)-16);
+			part_vel[j][p] = (rand()%512)-256;
 		}
 	}
 }
@@ -377,40 +583,36 @@ R_BlobExplosion
 void R_BlobExplosion (vec3_t org)
 {
 	int			i, j;
-	particle_t	*p;
+	int			p;
 
 	float		cltime_f;
 	cltime_f    = CLTIME_F();
 	
 	for (i=0 ; i<1024 ; i++)
 	{
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
-		p->die = 1.0f + (rand()&8)*0.05f;
+		part_die[p] = 1.0f + (rand()&8)*0.05f;
 
 		if (i & 1)
 		{
-			p->type = pt_blob;
-			p->color = 66 + rand()%6;
+			part_type[p] = pt_blob;
+			part_color[p] = 66 + rand()%6;
 			for (j=0 ; j<3 ; j++)
 			{
-				p->org[j] = org[j] + ((rand()%32)-16);
-				p->vel[j] = (rand()%512)-256;
+				part_org[j][p] = org[j] + ((rand()%32)-16);
+				part_vel[j][p] = (rand()%512)-256;
 			}
 		}
 		else
 		{
-			p->type = pt_blob2;
-			p->color = 150 + rand()%6;
+			part_type[p] = pt_blob2;
+			part_color[p] = 150 + rand()%6;
 			for (j=0 ; j<3 ; j++)
 			{
-				p->org[j] = org[j] + ((rand()%32)-16);
-				p->vel[j] = (rand()%512)-256;
+				part_org[j][p] = org[j] + ((rand()%32)-16);
+				part_vel[j][p] = (rand()%512)-256;
 			}
 		}
 	}
@@ -425,53 +627,49 @@ R_RunParticleEffect
 void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count)
 {
 	int			i, j;
-	particle_t	*p;
+	int			p;
 
 	float		cltime_f;
 	cltime_f    = CLTIME_F();
 	
 	for (i=0 ; i<count ; i++)
 	{
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
 
 		if (count == 1024)
 		{	// rocket explosion
-			p->die = 5.0f;
-			p->color = ramp1[0];
-			p->ramp = (rand()&3) << PARTICLE_RAMP_FRACT;
+			part_die[p] = 5.0f;
+			part_color[p] = ramp1[0];
+			part_ramp[p] = (rand()&3) << PARTICLE_RAMP_FRACT;
 			if (i & 1)
 			{
-				p->type = pt_explode;
+				part_type[p] = pt_explode;
 				for (j=0 ; j<3 ; j++)
 				{
-					p->org[j] = org[j] + ((rand()%32)-16);
-					p->vel[j] = (rand()%512)-256;
+					part_org[j][p] = org[j] + ((rand()%32)-16);
+					part_vel[j][p] = (rand()%512)-256;
 				}
 			}
 			else
 			{
-				p->type = pt_explode2;
+				part_type[p] = pt_explode2;
 				for (j=0 ; j<3 ; j++)
 				{
-					p->org[j] = org[j] + ((rand()%32)-16);
-					p->vel[j] = (rand()%512)-256;
+					part_org[j][p] = org[j] + ((rand()%32)-16);
+					part_vel[j][p] = (rand()%512)-256;
 				}
 			}
 		}
 		else
 		{
-			p->die = 0.1f*(rand()%5);
-			p->color = (color&~7) + (rand()&7);
-			p->type = pt_slowgrav;
+			part_die[p] = 0.1f*(rand()%5);
+			part_color[p] = (color&~7) + (rand()&7);
+			part_type[p] = pt_slowgrav;
 			for (j=0 ; j<3 ; j++)
 			{
-				p->org[j] = org[j] + ((rand()&15)-8);
-				p->vel[j] = dir[j]*15;// + (rand()%300)-150;
+				part_org[j][p] = org[j] + ((rand()&15)-8);
+				part_vel[j][p] = dir[j]*15;// + (rand()%300)-150;
 			}
 		}
 	}
@@ -487,7 +685,7 @@ R_LavaSplash
 void R_LavaSplash (vec3_t org)
 {
 	int			i, j, k;
-	particle_t	*p;
+	int			p;
 	float		vel;
 	vec3_t		dir;
 
@@ -498,31 +696,27 @@ void R_LavaSplash (vec3_t org)
 		for (j=-16 ; j<16 ; j++)
 			for (k=0 ; k<1 ; k++)
 			{
-				if (!free_particles)
+				if ((p = R_AllocParticle ()) < 0)
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 		
-				p->die = 2.0f + (rand()&31) * 0.02f;
-				p->color = 224 + (rand()&7);
-				p->type = pt_slowgrav;
+				part_die[p] = 2.0f + (rand()&31) * 0.02f;
+				part_color[p] = 224 + (rand()&7);
+				part_type[p] = pt_slowgrav;
 				
 				dir[0] = j*8 + (rand()&7);
 				dir[1] = i*8 + (rand()&7);
 				dir[2] = 256;
 	
-				p->org[0] = org[0] + dir[0];
-				p->org[1] = org[1] + dir[1];
-				p->org[2] = org[2] + (rand()&63);
+				part_org[0][p] = org[0] + dir[0];
+				part_org[1][p] = org[1] + dir[1];
+				part_org[2][p] = org[2] + (rand()&63);
 	
 				VectorNormalize (dir);						
 				vel = 50 + (rand()&63);
 				//VectorScale (dir, vel, p->vel);
-				p->vel[0] = dir[0] * vel;
-				p->vel[1] = dir[1] * vel;
-				p->vel[2] = dir[2] * vel;
+				part_vel[0][p] = dir[0] * vel;
+				part_vel[1][p] = dir[1] * vel;
+				part_vel[2][p] = dir[2] * vel;
 			}
 }
 
@@ -535,7 +729,7 @@ R_TeleportSplash
 void R_TeleportSplash (vec3_t org)
 {
 	int			i, j, k;
-	particle_t	*p;
+	int			p;
 	float		vel;
 	vec3_t		dir;
 
@@ -546,31 +740,27 @@ void R_TeleportSplash (vec3_t org)
 		for (j=-16 ; j<16 ; j+=4)
 			for (k=-24 ; k<32 ; k+=4)
 			{
-				if (!free_particles)
+				if ((p = R_AllocParticle ()) < 0)
 					return;
-				p = free_particles;
-				free_particles = p->next;
-				p->next = active_particles;
-				active_particles = p;
 		
-				p->die = 0.2f + (rand()&7) * 0.02f;
-				p->color = 7 + (rand()&7);
-				p->type = pt_slowgrav;
+				part_die[p] = 0.2f + (rand()&7) * 0.02f;
+				part_color[p] = 7 + (rand()&7);
+				part_type[p] = pt_slowgrav;
 				
 				dir[0] = j*8;
 				dir[1] = i*8;
 				dir[2] = k*8;
 	
-				p->org[0] = org[0] + i + (rand()&3);
-				p->org[1] = org[1] + j + (rand()&3);
-				p->org[2] = org[2] + k + (rand()&3);
+				part_org[0][p] = org[0] + i + (rand()&3);
+				part_org[1][p] = org[1] + j + (rand()&3);
+				part_org[2][p] = org[2] + k + (rand()&3);
 	
 				VectorNormalize (dir);						
 				vel = 50 + (rand()&63);
 				//VectorScale (dir, vel, p->vel);
-				p->vel[0] = dir[0] * vel;
-				p->vel[1] = dir[1] * vel;
-				p->vel[2] = dir[2] * vel;
+				part_vel[0][p] = dir[0] * vel;
+				part_vel[1][p] = dir[1] * vel;
+				part_vel[2][p] = dir[2] * vel;
 			}
 }
 
@@ -579,7 +769,7 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 	vec3_t		vec;
 	float		len;
 	int			j;
-	particle_t	*p;
+	int			p;
 	int			dec;
 	static int	tracercount;
 
@@ -600,79 +790,75 @@ void R_RocketTrail (vec3_t start, vec3_t end, int type)
 	{
 		len -= dec;
 
-		if (!free_particles)
+		if ((p = R_AllocParticle ()) < 0)
 			return;
-		p = free_particles;
-		free_particles = p->next;
-		p->next = active_particles;
-		active_particles = p;
-		
-		VectorCopy (vec3_origin, p->vel);
-		p->die = 2.0f;
+
+		part_die[p] = 2.0f;
 
 		switch (type)
 		{
 			case 0:	// rocket trail
-				p->ramp = (rand()&3) << PARTICLE_RAMP_FRACT;
-				p->color = ramp3[(p->ramp) >> PARTICLE_RAMP_FRACT];
-				p->type = pt_fire;
+				part_ramp[p] = (rand()&3) << PARTICLE_RAMP_FRACT;
+				part_color[p] = ramp3[(part_ramp[p]) >> PARTICLE_RAMP_FRACT];
+				part_type[p] = pt_fire;
 				for (j=0 ; j<3 ; j++)
-					p->org[j] = start[j] + ((rand()%6)-3);
+					part_org[j][p] = start[j] + ((rand()%6)-3);
 				break;
 
 			case 1:	// smoke smoke
-				p->ramp = ((rand()&3) + 2) << PARTICLE_RAMP_FRACT;
-				p->color = ramp3[(p->ramp) >> PARTICLE_RAMP_FRACT];
-				p->type = pt_fire;
+				part_ramp[p] = ((rand()&3) + 2) << PARTICLE_RAMP_FRACT;
+				part_color[p] = ramp3[(part_ramp[p]) >> PARTICLE_RAMP_FRACT];
+				part_type[p] = pt_fire;
 				for (j=0 ; j<3 ; j++)
-					p->org[j] = start[j] + ((rand()%6)-3);
+					part_org[j][p] = start[j] + ((rand()%6)-3);
 				break;
 
 			case 2:	// blood
-				p->type = pt_grav;
-				p->color = 67 + (rand()&3);
+				part_type[p] = pt_grav;
+				part_color[p] = 67 + (rand()&3);
 				for (j=0 ; j<3 ; j++)
-					p->org[j] = start[j] + ((rand()%6)-3);
+					part_org[j][p] = start[j] + ((rand()%6)-3);
 				break;
 
 			case 3:
 			case 5:	// tracer
-				p->die = 0.5f;
-				p->type = pt_static;
+				part_die[p] = 0.5f;
+				part_type[p] = pt_static;
 				if (type == 3)
-					p->color = 52 + ((tracercount&4)<<1);
+					part_color[p] = 52 + ((tracercount&4)<<1);
 				else
-					p->color = 230 + ((tracercount&4)<<1);
+					part_color[p] = 230 + ((tracercount&4)<<1);
 			
 				tracercount++;
 
-				VectorCopy (start, p->org);
+				for (j=0 ; j<3 ; j++)
+					part_org[j][p] = start[j];
 				if (tracercount & 1)
 				{
-					p->vel[0] = 30*vec[1];
-					p->vel[1] = 30*-vec[0];
+					part_vel[0][p] = 30*vec[1];
+					part_vel[1][p] = 30*-vec[0];
 				}
 				else
 				{
-					p->vel[0] = 30*-vec[1];
-					p->vel[1] = 30*vec[0];
+					part_vel[0][p] = 30*-vec[1];
+					part_vel[1][p] = 30*vec[0];
 				}
 				break;
 
 			case 4:	// slight blood
-				p->type = pt_grav;
-				p->color = 67 + (rand()&3);
+				part_type[p] = pt_grav;
+				part_color[p] = 67 + (rand()&3);
 				for (j=0 ; j<3 ; j++)
-					p->org[j] = start[j] + ((rand()%6)-3);
+					part_org[j][p] = start[j] + ((rand()%6)-3);
 				len -= 3;
 				break;
 
 			case 6:	// voor trail
-				p->color = 9*16 + 8 + (rand()&3);
-				p->type = pt_static;
-				p->die = 0.3f;
+				part_color[p] = 9*16 + 8 + (rand()&3);
+				part_type[p] = pt_static;
+				part_die[p] = 0.3f;
 				for (j=0 ; j<3 ; j++)
-					p->org[j] = start[j] + ((rand()&15)-8);
+					part_org[j][p] = start[j] + ((rand()&15)-8);
 				break;
 		}
 		
@@ -691,117 +877,28 @@ extern	cvar_t	sv_gravity;
 
 void R_DrawParticles (void)
 {
-	particle_t		*p, *kill;
-	float			grav;
-	int				i;
-	int 			time2, time3;
-	int 			time1;
-	float			dvel;
 	float			frametime;
-	float           cltime_f;
 	
+	R_SyncParticles ();
+
 	D_StartParticles ();
 
 	VectorScale (vright, xscaleshrink, r_pright);
 	VectorScale (vup, yscaleshrink, r_pup);
 	VectorCopy (vpn, r_ppn);
 
-	frametime = cl.time - cl.oldtime;
-	time3 = frametime * 15 * (1 << PARTICLE_RAMP_FRACT);
-	time2 = frametime * 10 * (1 << PARTICLE_RAMP_FRACT); // 15;
-	time1 = frametime * 5  * (1 << PARTICLE_RAMP_FRACT);
-	grav = frametime * sv_gravity.value * 0.05f;
-	dvel = 4*frametime;
-	cltime_f = CLTIME_F();
-	
-	for ( ;; ) 
-	{
-		kill = active_particles;
-		if (kill && (kill->die -= frametime) < 0.0f)
-		{
-			active_particles = kill->next;
-			kill->next = free_particles;
-			free_particles = kill;
-			continue;
-		}
-		break;
-	}
-
-	for (p=active_particles ; p ; p=p->next)
-	{
-		for ( ;; )
-		{
-			kill = p->next;
-			if (kill && (kill->die -= frametime) < 0.0f)
-			{
-				p->next = kill->next;
-				kill->next = free_particles;
-				free_particles = kill;
-				continue;
-			}
-			break;
-		}
-
-		D_DrawParticle (p);
-
-		p->org[0] += p->vel[0]*frametime;
-		p->org[1] += p->vel[1]*frametime;
-		p->org[2] += p->vel[2]*frametime;
-		
-		switch (p->type)
-		{
-		case pt_static:
-			break;
-		case pt_fire:
-			p->ramp += time1;
-			if (p->ramp >= (6 << PARTICLE_RAMP_FRACT))
-				p->die = -1;
-			else
-				p->color = ramp3[(p->ramp) >> PARTICLE_RAMP_FRACT];
-			p->vel[2] += grav;
-			break;
+	D_DrawParticles (part_org[0], part_org[1], part_org[2], part_color,
+			r_activeparticles);
+	r_partdrawn = r_activeparticles;
 
-		case pt_explode:
-			p->ramp += time2;
-			if (p->ramp >= (8 << PARTICLE_RAMP_FRACT))
-				p->die = -1;
-			else
-				p->color = ramp1[(p->ramp) >> PARTICLE_RAMP_FRACT];
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
-			break;
-
-		case pt_explode2:
-			p->ramp += time3;
-			if (p->ramp >= (8 << PARTICLE_RAMP_FRACT))
-				p->die = -1;
-			else
-				p->color = ramp2[(p->ramp) >> PARTICLE_RAMP_FRACT];
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] -= p->vel[i]*frametime;
-			p->vel[2] -= grav;
-			break;
-
-		case pt_blob:
-			for (i=0 ; i<3 ; i++)
-				p->vel[i] += p->vel[i]*dvel;
-			p->vel[2] -= grav;
-			break;
-
-		case pt_blob2:
-			for (i=0 ; i<2 ; i++)
-				p->vel[i] -= p->vel[i]*dvel;
-			p->vel[2] -= grav;
-			break;
-
-		case pt_grav:
-		case pt_slowgrav:
-			p->vel[2] -= grav;
-			break;
-		}
-	}
+// the move after the draw is left to the next R_SimulateParticles
+	frametime = r_partkill;
+	r_partmove.frametime = frametime;
+	r_partmove.time3 = frametime * 15 * (1 << PARTICLE_RAMP_FRACT);
+	r_partmove.time2 = frametime * 10 * (1 << PARTICLE_RAMP_FRACT); // 15;
+	r_partmove.time1 = frametime * 5  * (1 << PARTICLE_RAMP_FRACT);
+	r_partmove.grav = frametime * sv_gravity.value * 0.05f;
+	r_partmove.dvel = 4*frametime;
 
 	D_EndParticles ();
 }
-
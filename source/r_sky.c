@@ -30,21 +30,17 @@ __psram_bss ("r_sky") float	skyspeed, skyspeed2;
 
 					  float		skytime;
 
-__psram_bss ("r_sky") byte		*r_skysource;
+byte		*r_skytop, *r_skybottom;	// what D_DrawSkyScans8 samples
 
-					  qboolean  r_skymade;
 __psram_bss ("r_sky") int 		r_skydirect;		// not used?
 
 
 // TODO: clean up these routines
 
-//__psram_bss ("r_sky") __aligned(8) byte	bottomsky[128*128];
-//__psram_bss ("r_sky") __aligned(8) byte	bottommask[128*128];
-//__psram_bss ("r_sky") __aligned(8) uint16_t	bottomsky[128*128*2]; // [sky,mask] interleaved
-__psram_bss ("r_sky") __aligned(8) byte topsky[128*128];
-__psram_bss ("r_sky") __aligned(8) byte	bottomsky[128*128]; // idx 255 is transparent
-
-byte	newsky[128*128];
+// the two layers are composed per sky pixel by D_DrawSkyScans8, in ram as
+// every lookup of a sky span lands in both
+__aligned(8) byte	topsky[128*128];
+__aligned(8) byte	bottomsky[128*128]; // idx 255 is transparent
 
 /*
 =============
@@ -58,7 +54,7 @@ void R_InitSky (texture_t *mt)
 	int			i, j;
 	byte		*src;
 
-	src = (byte *)mt + mt->offsets[0];
+	src = Mod_TextureMip (mt, 0);
 
 	for (i=0 ; i<128 ; i++)
 	{
@@ -83,49 +79,8 @@ void R_InitSky (texture_t *mt)
 		}
 	}
 	
-	r_skysource = newsky;
-}
-
-
-/*
-=================
-R_MakeSky
-=================
-*/
-void __no_inline_not_in_flash_func(R_MakeSky) (void)
-{
-	int			x, y;
-	int			ofs, baseofs;
-	int			xshift, yshift;
-	byte		*pnewsky, *ptopsky;
-	static int	xlast = -1, ylast = -1;
-
-	xshift = skytime*skyspeed;
-	yshift = skytime*skyspeed;
-
-	if ((xshift == xlast) && (yshift == ylast))
-		return;
-
-	xlast = xshift;
-	ylast = yshift;
-	
-	pnewsky = newsky;
-	ptopsky = topsky;
-
-	for (y=0 ; y<SKYSIZE ; y++)
-	{
-		baseofs = ((y+yshift) & SKYMASK) * 128;
-
-		#pragma GCC unroll 4
-		for (x=0 ; x<SKYSIZE ; x++)
-		{
-			ofs = baseofs + ((x+xshift) & SKYMASK);
-			*pnewsky++ = bottomsky[ofs] == 255 ? (*ptopsky) : bottomsky[ofs];
-			ptopsky++;
-		}
-	}
-
-	r_skymade = 1;
+	r_skytop = topsky;
+	r_skybottom = bottomsky;
 }
 
 
@@ -189,9 +144,6 @@ void R_SetSkyFrame (void)
 	temp = SKYSIZE * s1 * s2;
 
 	skytime = cl.time - ((int)(cl.time / temp) * temp);
-	
-
-	r_skymade = 0;
 }
 
 
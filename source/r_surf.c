@@ -21,6 +21,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include "quakedef.h"
 #include "r_local.h"
+#include "kcapture.h"
 
 drawsurf_t	r_drawsurf;
 
@@ -229,6 +230,24 @@ R_DrawSurface
 ===============
 */
 void R_DrawSurface (void)
+{
+// calculate the lightings
+	R_BuildLightMap ();
+
+	if (kcap_active)
+		KCap_Surface ();
+
+	R_DrawSurfaceBlocks ();
+}
+
+/*
+===============
+R_DrawSurfaceBlocks
+
+Fills r_drawsurf.surfdat from the texture and the lightmap in blocklights
+===============
+*/
+void R_DrawSurfaceBlocks (void)
 {
 	unsigned char	*basetptr;
 	int				smax, tmax, twidth;
@@ -239,14 +258,11 @@ void R_DrawSurface (void)
 	void			(*pblockdrawer)(void);
 	texture_t		*mt;
 
-// calculate the lightings
-	R_BuildLightMap ();
-	
 	surfrowbytes = r_drawsurf.rowbytes;
 
 	mt = r_drawsurf.texture;
 	
-	r_source = (byte *)mt + mt->offsets[r_drawsurf.surfmip];
+	r_source = Mod_TextureMip (mt, r_drawsurf.surfmip);
 	
 // the fractional light values should range from 0 to (VID_GRADES - 1) << 16
 // from a source range of 0 - 255
@@ -610,8 +626,7 @@ void R_GenTile (msurface_t *psurf, void *pdest)
 {
 	if (psurf->flags & SURF_DRAWTURB)
 	{
-		R_GenTurbTile ((pixel_t *)
-				((byte *)psurf->texinfo->texture + psurf->texinfo->texture->offsets[0]), pdest);
+		R_GenTurbTile ((pixel_t *)Mod_TextureMip (psurf->texinfo->texture, 0), pdest);
 	}
 	else if (psurf->flags & SURF_DRAWSKY)
 	{
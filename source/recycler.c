@@ -4,11 +4,9 @@
 #include "r_local.h"
 #include "r_shared.h"
 
-static void *zba_edgebuf_rover;
-
 void RC_NewFrame() {
-    // reset Z-Buffer allocator
-    ZBA_Reset();
+    // the z-buffer arena is free between frames
+    Arena_Reset(&zbuffer_arena);
 
     // allocate edge buffer
     if (r_numallocatededges > NUMSTACKEDGES)
@@ -17,17 +15,15 @@ void RC_NewFrame() {
 	}
 	else
 	{
-		edgebuf_swap = ZBA_Alloc(sizeof(edge_t)*(NUMSTACKEDGES+RESERVED_EDGES));
+		edgebuf_swap = Arena_Alloc(&zbuffer_arena, sizeof(edge_t)*(NUMSTACKEDGES+RESERVED_EDGES));
 	}
 
-    zba_edgebuf_rover = ZBA_GetRover();
-
     // allocate and load compressed PVS
     // TODO
 }
 
 void RC_EndFrame() {
-    ZBA_Reset();
+    Arena_Reset(&zbuffer_arena);
 }
 
 void RC_AbortNewFrame() {
@@ -127,6 +127,7 @@ void R_RemoveEfrags (entity_t *ent);
 void R_NewMap (void);
 
 
+void R_ClearParticles (void);
 void R_ParseParticleEffect (void);
 void R_RunParticleEffect (vec3_t org, vec3_t dir, int color, int count);
 void R_RocketTrail (vec3_t start, vec3_t end, int type);
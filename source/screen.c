@@ -637,6 +637,8 @@ void SCR_ScreenShot_f (void)
 	D_EnableBackBufferAccess ();	// enable direct drawing of console to back
 									//  buffer
 
+	D_WarpOverdraw (0, 0, vid.width, vid.height);	// the view as it was shown
+
 	WritePCXfile (pcxname, vid.buffer, vid.width, vid.height, vid.rowbytes,
 				  host_basepal);
 
@@ -920,6 +922,7 @@ void SCR_UpdateScreen (void)
 	else
 	{
 		SCR_DrawRam ();
+		MemStat_Draw ();
 		SCR_DrawNet ();
 		SCR_DrawTurtle ();
 		SCR_DrawPause ();
@@ -43,6 +43,7 @@ extern	int			sb_lines;
 extern	byte		clearnotify;	// set to 0 whenever notify text is drawn
 extern	qboolean	scr_disabled_for_loading;
 extern	qboolean	scr_skipupdate;
+extern	float		scr_centertime_off;
 
 extern	cvar_t		scr_viewsize;
 
@@ -0,0 +1,670 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// scsim.c -- host replay of surface cache traces
+//
+// usage: scsim <trace.sct> [-size bytes[k|m]]... [-policy rover|lru|seg]...
+//
+// replays a timedemo recorded with "sctrace" against cache sizes and
+// allocation policies and prints, for each, the hit rate, why lookups
+// missed, how many entries were thrown out and how many bytes of surface
+// had to be built per frame. Without -size the trace's own size is run
+// along with half, one and a half and twice it.
+//
+//   rover	D_SCAlloc as it is: one rover going round the cache, merging the
+//			blocks it runs over until the new one fits
+//   lru		the least recently used entries go first, as if the cache
+//			could be compacted for free; the difference to rover is what
+//			the rover's order and fragmentation cost
+//   seg		sizes rounded up to one of four steps per power of two, a
+//			miss takes the least recently used entry of its own size
+//			unless that was drawn this frame, so nothing is merged or
+//			split; the rounding is the cost
+//
+// The rover run at the trace's size replays what the engine did, its
+// counts should match the engine's own on the "engine" line.
+
+#include "quakedef.h"
+#include "d_local.h"
+#include "sctrace.h"
+
+#define SS_MAXSIZES		16
+#define SS_CLASSES		64
+
+typedef enum {
+	SS_HIT,
+	SS_COLD,		// first time, or first since a flush
+	SS_EVICTED,
+	SS_DLIGHT,
+	SS_ANIMATE,
+	SS_LIGHT,
+	SS_NUMREASONS
+} ssreason_t;
+
+static char	*ss_reasonnames[SS_NUMREASONS] =
+{
+	"hit", "cold", "evicted", "dlight", "animate", "light"
+};
+
+typedef struct ssentry_s
+{
+	unsigned			surface;
+	int					mip;
+	int					size;
+	int					held;				// bytes it takes under the policy
+	qboolean			present, seen;
+	unsigned			texture, light;
+	qboolean			dlit;
+	int					lastframe, lastseq;
+	int					slot;				// seg: size class
+	struct ssblock_s	*block;				// rover
+	struct ssentry_s	*prev, *next;		// lru and seg, most recent first
+} ssentry_t;
+
+typedef struct ssblock_s
+{
+	int					offset, size;
+	ssentry_t			*owner;
+	struct ssblock_s	*next;
+} ssblock_t;
+
+typedef struct
+{
+	ssentry_t	*head, *tail;
+} sslist_t;
+
+typedef struct
+{
+	char		*name;
+	void		(*reset) (void);
+	qboolean	(*alloc) (ssentry_t *e);	// false if it can never fit
+	void		(*touch) (ssentry_t *e);
+	void		(*unlink) (ssentry_t *e);
+} sspolicy_t;
+
+static sctheader_t	ss_header;
+static sctrecord_t	*ss_records;
+static int			ss_numrecords, ss_numframes, ss_numlookups;
+static int			ss_engine[SCR_NUMRESULTS];
+
+static ssentry_t	*ss_entries;
+static int			ss_numentries;
+static ssentry_t	**ss_lookupentry;		// per record, NULL for frames and flushes
+
+// the run
+static int			ss_cachesize;
+static int			ss_frame, ss_seq;
+static int			ss_live;				// bytes held by entries
+static int			ss_reasons[SS_NUMREASONS];
+static int			ss_evictions, ss_thrashframes;
+static qboolean		ss_thrashing;
+static double		ss_built, ss_builtinplace, ss_occupancy;
+static int			*ss_framebuilt;
+
+static ssblock_t	*ss_base, *ss_rover;
+static sslist_t		ss_lru;
+static sslist_t		ss_classes[SS_CLASSES];
+
+static void *SS_Alloc (int size)
+{
+	void	*p;
+
+	p = calloc (1, size > 0 ? size : 1);
+	if (!p)
+		Sys_Error ("SS_Alloc: failed on %i bytes", size);
+	return p;
+}
+
+/*
+===============
+SS_LoadTrace
+
+reads the trace and gives every surface and mip pair its own entry
+===============
+*/
+static void SS_LoadTrace (char *name)
+{
+	FILE		*f;
+	int			len, i, hashsize, h;
+	sctrecord_t	*r;
+	ssentry_t	**hash, *e;
+
+	f = fopen (name, "rb");
+	if (!f)
+		Sys_Error ("couldn't open %s", name);
+	fseek (f, 0, SEEK_END);
+	len = ftell (f);
+	fseek (f, 0, SEEK_SET);
+	if (len < sizeof(ss_header) || fread (&ss_header, 1, sizeof(ss_header), f) != sizeof(ss_header))
+		Sys_Error ("%s is not a surface cache trace", name);
+	if (ss_header.ident != SCT_IDENT)
+		Sys_Error ("%s is not a surface cache trace", name);
+	if (ss_header.version != SCT_VERSION)
+		Sys_Error ("%s is version %i, not %i", name, ss_header.version, SCT_VERSION);
+
+	ss_numrecords = (len - sizeof(ss_header)) / sizeof(sctrecord_t);
+	ss_records = SS_Alloc (ss_numrecords * sizeof(sctrecord_t));
+	if (fread (ss_records, sizeof(sctrecord_t), ss_numrecords, f) != ss_numrecords)
+		Sys_Error ("couldn't read %s", name);
+	fclose (f);
+
+	for (hashsize=1024 ; hashsize < ss_numrecords*2 ; hashsize<<=1)
+		;
+	hash = SS_Alloc (hashsize * sizeof(*hash));
+	ss_entries = SS_Alloc (ss_numrecords * sizeof(ssentry_t));
+	ss_lookupentry = SS_Alloc (ss_numrecords * sizeof(*ss_lookupentry));
+
+	for (i=0, r=ss_records ; i<ss_numrecords ; i++, r++)
+	{
+		if (r->kind == SCT_FRAME)
+			ss_numframes++;
+		if (r->kind != SCT_LOOKUP)
+			continue;
+		if (r->result >= SCR_NUMRESULTS || r->mip >= MIPLEVELS)
+			Sys_Error ("%s: bad record %i", name, i);
+		ss_numlookups++;
+		ss_engine[r->result]++;
+
+		h = (r->surface * 2654435761u + r->mip) & (hashsize-1);
+		for ( ; ; h = (h+1) & (hashsize-1))
+		{
+			e = hash[h];
+			if (!e)
+			{
+				e = hash[h] = &ss_entries[ss_numentries++];
+				e->surface = r->surface;
+				e->mip = r->mip;
+				e->size = r->size;
+				break;
+			}
+			if (e->surface == r->surface && e->mip == r->mip)
+				break;
+		}
+		ss_lookupentry[i] = e;
+	}
+	free (hash);
+
+	if (!ss_numframes)
+		ss_numframes = 1;
+	ss_framebuilt = SS_Alloc (ss_numframes * sizeof(int));
+}
+
+/*
+===============
+SS_List*
+
+most recently used at the head
+===============
+*/
+static void SS_ListRemove (sslist_t *l, ssentry_t *e)
+{
+	if (e->prev)
+		e->prev->next = e->next;
+	else
+		l->head = e->next;
+	if (e->next)
+		e->next->prev = e->prev;
+	else
+		l->tail = e->prev;
+	e->prev = e->next = NULL;
+}
+
+static void SS_ListFront (sslist_t *l, ssentry_t *e)
+{
+	e->prev = NULL;
+	e->next = l->head;
+	if (l->head)
+		l->head->prev = e;
+	else
+		l->tail = e;
+	l->head = e;
+}
+
+/*
+===============
+SS_Evict
+===============
+*/
+static void SS_Evict (sspolicy_t *p, ssentry_t *e)
+{
+	p->unlink (e);
+	e->present = false;
+	ss_live -= e->held;
+	ss_evictions++;
+	if (e->lastframe == ss_frame)
+		ss_thrashing = true;		// drawn this frame and gone again
+}
+
+/*
+==============================================================================
+
+ROVER
+
+==============================================================================
+*/
+
+static sspolicy_t	ss_rover_policy;
+
+static void Rover_Reset (void)
+{
+	ssblock_t	*b, *next;
+
+	for (b = ss_base ; b ; b = next)
+	{
+		next = b->next;
+		free (b);
+	}
+	ss_base = SS_Alloc (sizeof(ssblock_t));
+	ss_base->size = ss_cachesize;
+	ss_rover = ss_base;
+}
+
+static void Rover_Free (ssblock_t *b)
+{
+	if (b->owner)
+		SS_Evict (&ss_rover_policy, b->owner);
+}
+
+static qboolean Rover_Alloc (ssentry_t *e)
+{
+	ssblock_t	*new, *b;
+	int			size;
+
+	size = e->size;
+	if (size > ss_cachesize)
+		return false;
+
+	if (!ss_rover || ss_rover->offset > ss_cachesize - size)
+		ss_rover = ss_base;
+
+	new = ss_rover;
+	Rover_Free (new);
+	while (new->size < size)
+	{
+		b = new->next;
+		Rover_Free (b);
+		new->size += b->size;
+		new->next = b->next;
+		free (b);
+	}
+
+	if (new->size - size > ss_header.fragment)
+	{
+		b = SS_Alloc (sizeof(ssblock_t));
+		b->offset = new->offset + size;
+		b->size = new->size - size;
+		b->next = new->next;
+		new->next = b;
+		new->size = size;
+		ss_rover = b;
+	}
+	else
+		ss_rover = new->next;
+
+	new->owner = e;
+	e->block = new;
+	e->held = size;
+	return true;
+}
+
+static void Rover_Touch (ssentry_t *e)
+{
+}
+
+static void Rover_Unlink (ssentry_t *e)
+{
+	e->block->owner = NULL;
+	e->block = NULL;
+}
+
+static sspolicy_t	ss_rover_policy = {"rover", Rover_Reset, Rover_Alloc, Rover_Touch, Rover_Unlink};
+
+/*
+==============================================================================
+
+LRU
+
+==============================================================================
+*/
+
+static sspolicy_t	ss_lru_policy;
+
+static void LRU_Reset (void)
+{
+	ss_lru.head = ss_lru.tail = NULL;
+}
+
+static qboolean LRU_Alloc (ssentry_t *e)
+{
+	if (e->size > ss_cachesize)
+		return false;
+	while (ss_live + e->size > ss_cachesize)
+		SS_Evict (&ss_lru_policy, ss_lru.tail);
+	SS_ListFront (&ss_lru, e);
+	e->held = e->size;
+	return true;
+}
+
+static void LRU_Touch (ssentry_t *e)
+{
+	SS_ListRemove (&ss_lru, e);
+	SS_ListFront (&ss_lru, e);
+}
+
+static void LRU_Unlink (ssentry_t *e)
+{
+	SS_ListRemove (&ss_lru, e);
+}
+
+static sspolicy_t	ss_lru_policy = {"lru", LRU_Reset, LRU_Alloc, LRU_Touch, LRU_Unlink};
+
+/*
+==============================================================================
+
+SIZE SEGREGATED
+
+an entry holds a slot of its size rounded up to 4, 5, 6 or 7 times a
+power of two, so no more than a fifth is lost to rounding
+
+==============================================================================
+*/
+
+static sspolicy_t	ss_seg_policy;
+
+static int Seg_SlotSize (int c)
+{
+	return (4 + (c & 3)) << (c >> 2);
+}
+
+static int Seg_Class (int size)
+{
+	int		c;
+
+	for (c=16 ; Seg_SlotSize (c) < size ; c++)		// 64 bytes and up
+		;
+	return c;
+}
+
+static void Seg_Reset (void)
+{
+	memset (ss_classes, 0, sizeof(ss_classes));
+}
+
+static qboolean Seg_Alloc (ssentry_t *e)
+{
+	ssentry_t	*oldest;
+	sslist_t	*own;
+	int			c;
+
+	e->slot = Seg_Class (e->size);
+	if (e->slot >= SS_CLASSES || Seg_SlotSize (e->slot) > ss_cachesize)
+		return false;
+	own = &ss_classes[e->slot];
+
+	if (ss_live + Seg_SlotSize (e->slot) > ss_cachesize && own->tail && own->tail->lastframe != ss_frame)
+		SS_Evict (&ss_seg_policy, own->tail);
+	while (ss_live + Seg_SlotSize (e->slot) > ss_cachesize)
+	{
+		oldest = NULL;
+		for (c=0 ; c<SS_CLASSES ; c++)
+			if (ss_classes[c].tail && (!oldest || ss_classes[c].tail->lastseq < oldest->lastseq))
+				oldest = ss_classes[c].tail;
+		SS_Evict (&ss_seg_policy, oldest);
+	}
+
+	SS_ListFront (own, e);
+	e->held = Seg_SlotSize (e->slot);
+	return true;
+}
+
+static void Seg_Touch (ssentry_t *e)
+{
+	SS_ListRemove (&ss_classes[e->slot], e);
+	SS_ListFront (&ss_classes[e->slot], e);
+}
+
+static void Seg_Unlink (ssentry_t *e)
+{
+	SS_ListRemove (&ss_classes[e->slot], e);
+}
+
+static sspolicy_t	ss_seg_policy = {"seg", Seg_Reset, Seg_Alloc, Seg_Touch, Seg_Unlink};
+
+/*
+==============================================================================
+
+REPLAY
+
+==============================================================================
+*/
+
+static void SS_EndFrame (void)
+{
+	if (ss_frame < 0)
+		return;
+	if (ss_thrashing)
+		ss_thrashframes++;
+	ss_thrashing = false;
+	ss_occupancy += (double)ss_live / ss_cachesize;
+}
+
+static void SS_Flush (sspolicy_t *p)
+{
+	int			i;
+	ssentry_t	*e;
+
+	for (i=0, e=ss_entries ; i<ss_numentries ; i++, e++)
+	{
+		e->present = false;
+		e->seen = false;
+		e->block = NULL;
+		e->prev = e->next = NULL;
+	}
+	ss_live = 0;
+	p->reset ();
+}
+
+/*
+===============
+SS_Lookup
+
+what D_CacheSurface does with one lookup under the policy
+===============
+*/
+static void SS_Lookup (sspolicy_t *p, sctrecord_t *r, ssentry_t *e)
+{
+	ssreason_t	reason;
+	int			frame;
+
+	if (!e->present)
+		reason = e->seen ? SS_EVICTED : SS_COLD;
+	else if (e->dlit || (r->flags & SCTF_DLIGHT))
+		reason = SS_DLIGHT;
+	else if (e->texture != r->texture)
+		reason = SS_ANIMATE;
+	else if (e->light != r->light)
+		reason = SS_LIGHT;
+	else
+		reason = SS_HIT;
+
+	ss_reasons[reason]++;
+	e->seen = true;
+	e->lastframe = ss_frame;
+	e->lastseq = ss_seq++;
+
+	if (reason == SS_HIT)
+	{
+		p->touch (e);
+		return;
+	}
+
+	frame = ss_frame < 0 ? 0 : ss_frame;
+	ss_framebuilt[frame] += e->size;
+	ss_built += e->size;
+	if (e->present)
+	{
+		ss_builtinplace += e->size;
+		p->touch (e);
+	}
+	else if (p->alloc (e))
+	{
+		e->present = true;
+		ss_live += e->held;
+	}
+
+	e->texture = r->texture;
+	e->light = r->light;
+	e->dlit = (r->flags & SCTF_DLIGHT) != 0;
+}
+
+static int SS_CompareInts (const void *a, const void *b)
+{
+	return *(int *)a - *(int *)b;
+}
+
+/*
+===============
+SS_Run
+===============
+*/
+static void SS_Run (sspolicy_t *p, int cachesize)
+{
+	int			i, hits, p95, max;
+	sctrecord_t	*r;
+
+	ss_cachesize = cachesize;
+	ss_frame = -1;
+	ss_seq = 0;
+	memset (ss_reasons, 0, sizeof(ss_reasons));
+	ss_evictions = ss_thrashframes = 0;
+	ss_thrashing = false;
+	ss_built = ss_builtinplace = ss_occupancy = 0;
+	memset (ss_framebuilt, 0, ss_numframes * sizeof(int));
+	SS_Flush (p);
+
+	for (i=0, r=ss_records ; i<ss_numrecords ; i++, r++)
+	{
+		switch (r->kind)
+		{
+		case SCT_FRAME:
+			SS_EndFrame ();
+			if (ss_frame < ss_numframes - 1)
+				ss_frame++;
+			break;
+		case SCT_FLUSH:
+			SS_Flush (p);
+			break;
+		case SCT_LOOKUP:
+			SS_Lookup (p, r, ss_lookupentry[i]);
+			break;
+		}
+	}
+	SS_EndFrame ();
+
+	qsort (ss_framebuilt, ss_numframes, sizeof(int), SS_CompareInts);
+	p95 = ss_framebuilt[ss_numframes * 95 / 100];
+	max = ss_framebuilt[ss_numframes - 1];
+	hits = ss_reasons[SS_HIT];
+
+	printf ("%-6s %8i %6.2f%%", p->name, cachesize,
+			ss_numlookups ? 100.0 * hits / ss_numlookups : 0.0);
+	for (i=SS_COLD ; i<SS_NUMREASONS ; i++)
+		printf (" %8i", ss_reasons[i]);
+	printf (" %8i %6i %9.0f %9i %9i %7.0f %5.1f%%\n", ss_evictions, ss_thrashframes,
+			ss_built / ss_numframes, p95, max, ss_builtinplace / ss_numframes,
+			100 * ss_occupancy / ss_numframes);
+}
+
+static int SS_ParseSize (char *s)
+{
+	char	*end;
+	double	size;
+
+	size = strtod (s, &end);
+	if (*end == 'k' || *end == 'K')
+		size *= 1024;
+	else if (*end == 'm' || *end == 'M')
+		size *= 1024*1024;
+	return (int)size;
+}
+
+static sspolicy_t	*ss_policies[] = {&ss_rover_policy, &ss_lru_policy, &ss_seg_policy, NULL};
+
+int main (int argc, char *argv[])
+{
+	sspolicy_t	*run[4], **p;
+	int			sizes[SS_MAXSIZES];
+	int			numsizes, numrun, i, j;
+
+	if (argc < 2)
+	{
+		printf ("usage: scsim <trace.sct> [-size bytes[k|m]]... [-policy rover|lru|seg]...\n");
+		return 1;
+	}
+	numsizes = numrun = 0;
+	for (i=2 ; i<argc ; i++)
+	{
+		if (!strcmp (argv[i], "-size") && i+1 < argc)
+		{
+			if (numsizes < SS_MAXSIZES)
+				sizes[numsizes++] = SS_ParseSize (argv[++i]);
+		}
+		else if (!strcmp (argv[i], "-policy") && i+1 < argc)
+		{
+			i++;
+			for (p=ss_policies ; *p ; p++)
+				if (!strcmp ((*p)->name, argv[i]))
+					break;
+			if (!*p)
+				Sys_Error ("unknown policy %s", argv[i]);
+			if (numrun < 3)
+				run[numrun++] = *p;
+		}
+	}
+
+	SS_LoadTrace (argv[1]);
+	if (!numsizes)
+	{
+		sizes[numsizes++] = ss_header.cachesize / 2;
+		sizes[numsizes++] = ss_header.cachesize;
+		sizes[numsizes++] = ss_header.cachesize * 3 / 2;
+		sizes[numsizes++] = ss_header.cachesize * 2;
+	}
+	if (!numrun)
+		for (p=ss_policies ; *p ; p++)
+			run[numrun++] = *p;
+
+	printf ("%s: %i frames, %i lookups of %i surfaces, cache %i bytes\n", argv[1],
+			ss_numframes, ss_numlookups, ss_numentries, ss_header.cachesize);
+	printf ("engine: hit %i empty %i dlight %i animate %i light %i\n",
+			ss_engine[SCR_HIT], ss_engine[SCR_EMPTY], ss_engine[SCR_DLIGHT],
+			ss_engine[SCR_ANIMATE], ss_engine[SCR_LIGHT]);
+
+	printf ("%-6s %8s %7s", "policy", "size", "hits");
+	for (i=SS_COLD ; i<SS_NUMREASONS ; i++)
+		printf (" %8s", ss_reasonnames[i]);
+	printf (" %8s %6s %9s %9s %9s %7s %6s\n", "thrown", "thrash", "built/fr",
+			"p95", "max", "inplace", "live");
+
+	for (i=0 ; i<numrun ; i++)
+		for (j=0 ; j<numsizes ; j++)
+			SS_Run (run[i], sizes[j]);
+
+	return 0;
+}
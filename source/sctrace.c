@@ -0,0 +1,231 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sctrace.c -- records the surface cache lookups of a timedemo
+//
+// "sctrace <name>" arms the trace, the next timedemo writes every
+// D_CacheSurface lookup to <gamedir>/<name>.sct for scsim to replay
+// against other cache sizes and policies.
+
+#include "quakedef.h"
+#include "r_local.h"
+#include "d_local.h"
+#include "sctrace.h"
+
+#define	SCT_BUFFER		1024		// records written at a time
+
+qboolean	sct_active;
+
+static qboolean	sct_armed;
+static char		sct_name[MAX_OSPATH];
+static int		sct_file = -1;
+static __psram_bss("sctrace") sctrecord_t	sct_buffer[SCT_BUFFER];
+static int		sct_count;
+static int		sct_lookups, sct_frames;
+static int		sct_results[SCR_NUMRESULTS];
+
+static const char *sct_resultnames[SCR_NUMRESULTS] =
+{
+	"hit", "empty", "dlight", "animate", "light"
+};
+
+static void SCTrace_Drain (void)
+{
+	Sys_FileWrite (sct_file, sct_buffer, sct_count * sizeof(sctrecord_t));
+	sct_count = 0;
+}
+
+static sctrecord_t *SCTrace_Record (int kind)
+{
+	sctrecord_t	*r;
+
+	if (sct_count == SCT_BUFFER)
+		SCTrace_Drain ();
+	r = &sct_buffer[sct_count++];
+	memset (r, 0, sizeof(*r));
+	r->kind = kind;
+	return r;
+}
+
+/*
+===============
+SCTrace_Frame
+
+Called from D_SetupFrame
+===============
+*/
+void SCTrace_Frame (void)
+{
+	SCTrace_Record (SCT_FRAME)->surface = r_framecount;
+	sct_frames++;
+}
+
+/*
+===============
+SCTrace_Flush
+
+Called from D_FlushCaches, everything cached is gone
+===============
+*/
+void SCTrace_Flush (void)
+{
+	SCTrace_Record (SCT_FLUSH);
+}
+
+/*
+===============
+SCTrace_Lookup
+
+Called from D_CacheSurface once r_drawsurf holds the texture and light
+values the surface is drawn with, before the cache entry is tested
+===============
+*/
+void SCTrace_Lookup (msurface_t *surface, int miplevel, surfcache_t *cache)
+{
+	sctrecord_t	*r;
+	unsigned	light;
+	int			i, pixels;
+
+	light = 0;
+	for (i=0 ; i<MAXLIGHTMAPS ; i++)
+		light = light * 65599 + r_drawsurf.lightadj[i];
+
+	// what D_SCAlloc would take for it
+	pixels = (surface->extents[0] >> miplevel) * (surface->extents[1] >> miplevel);
+
+	r = SCTrace_Record (SCT_LOOKUP);
+	r->surface = (unsigned)(uintptr_t)surface;
+	r->texture = (unsigned)(uintptr_t)r_drawsurf.texture;
+	r->light = light;
+	r->size = ((int)offsetof(surfcache_t, data) + pixels + 3) & ~3;
+	r->mip = miplevel;
+	r->flags = surface->dlightframe == r_framecount ? SCTF_DLIGHT : 0;
+
+	if (!cache)
+		r->result = SCR_EMPTY;
+	else if (cache->dlight || surface->dlightframe == r_framecount)
+		r->result = SCR_DLIGHT;
+	else if (cache->texture != r_drawsurf.texture)
+		r->result = SCR_ANIMATE;
+	else if (cache->lightadj[0] != r_drawsurf.lightadj[0]
+			|| cache->lightadj[1] != r_drawsurf.lightadj[1]
+			|| cache->lightadj[2] != r_drawsurf.lightadj[2]
+			|| cache->lightadj[3] != r_drawsurf.lightadj[3])
+		r->result = SCR_LIGHT;
+	else
+		r->result = SCR_HIT;
+
+	sct_results[r->result]++;
+	sct_lookups++;
+}
+
+/*
+===============
+SCTrace_Begin
+
+timedemo started
+===============
+*/
+void SCTrace_Begin (void)
+{
+	sctheader_t	header;
+
+	if (!sct_armed)
+		return;
+	sct_armed = false;
+
+	sct_file = Sys_FileOpenWrite (sct_name);
+	if (sct_file == -1)
+	{
+		Con_Printf ("ERROR: couldn't open %s\n", sct_name);
+		return;
+	}
+
+	header.ident = SCT_IDENT;
+	header.version = SCT_VERSION;
+	header.cachesize = sc_size;
+	header.headersize = offsetof(surfcache_t, data);
+	header.fragment = SC_MINFRAGMENT;
+	Sys_FileWrite (sct_file, &header, sizeof(header));
+
+	sct_count = 0;
+	sct_lookups = sct_frames = 0;
+	memset (sct_results, 0, sizeof(sct_results));
+	sct_active = true;
+}
+
+/*
+===============
+SCTrace_End
+
+timedemo finished
+===============
+*/
+void SCTrace_End (void)
+{
+	int		i;
+
+	if (!sct_active)
+		return;
+	sct_active = false;
+
+	SCTrace_Drain ();
+	Sys_FileClose (sct_file);
+	sct_file = -1;
+
+	Con_Printf ("wrote %s: %i frames, %i lookups\n", sct_name, sct_frames, sct_lookups);
+	for (i=0 ; i<SCR_NUMRESULTS ; i++)
+		Con_Printf ("%8s %i\n", sct_resultnames[i], sct_results[i]);
+}
+
+/*
+===============
+SCTrace_f
+===============
+*/
+static void SCTrace_f (void)
+{
+	char	name[MAX_OSPATH];
+
+	if (Cmd_Argc() != 2)
+	{
+		Con_Printf ("sctrace <name> : trace the surface cache in the next timedemo\n");
+		return;
+	}
+
+// leave room for the extension
+	if (snprintf (name, sizeof(name) - 4, "%s/%s", com_gamedir, Cmd_Argv(1)) >= (int)sizeof(name) - 4)
+	{
+		Con_Printf ("sctrace: name too long\n");
+		return;
+	}
+	COM_DefaultExtension (name, ".sct");
+	strcpy (sct_name, name);
+	sct_armed = true;
+}
+
+/*
+===============
+SCTrace_Init
+===============
+*/
+void SCTrace_Init (void)
+{
+	Cmd_AddCommand ("sctrace", SCTrace_f);
+}
@@ -0,0 +1,77 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// sctrace.h -- surface cache lookups of a timedemo, shared by the engine
+// (writer, sctrace.c) and the host replay (reader, scsim.c)
+//
+// "sctrace <name>" arms it, the next timedemo writes every D_CacheSurface
+// lookup to <gamedir>/<name>.sct. The file is a sctheader_t followed by
+// sctrecord_t, in native byte order. A frame starts with a SCT_FRAME
+// record, D_FlushCaches writes SCT_FLUSH.
+
+#define SCT_IDENT		(('T'<<24)+('C'<<16)+('S'<<8)+'Q')
+#define SCT_VERSION		1
+
+typedef struct
+{
+	int		ident;
+	int		version;
+	int		cachesize;		// sc_size of the run
+	int		headersize;		// of a surfcache_t, included in every size
+	int		fragment;		// D_SCAlloc leaves a smaller remainder attached
+} sctheader_t;
+
+typedef enum {
+	SCT_FRAME,
+	SCT_FLUSH,
+	SCT_LOOKUP
+} sctkind_t;
+
+// what the engine's own cache did with a lookup, first reason that applies
+typedef enum {
+	SCR_HIT,
+	SCR_EMPTY,		// never built, or thrown out by the rover
+	SCR_DLIGHT,		// dynamically lit now or when it was built
+	SCR_ANIMATE,	// texture animated
+	SCR_LIGHT,		// a light style changed
+	SCR_NUMRESULTS
+} sctresult_t;
+
+#define SCTF_DLIGHT		1		// the surface is dynamically lit this frame
+
+typedef struct
+{
+	unsigned	surface;	// address of the msurface_t; SCT_FRAME: r_framecount
+	unsigned	texture;	// address of the texture_t drawn
+	unsigned	light;		// hash of the four light style values
+	int			size;		// bytes D_SCAlloc takes for it, header included
+	byte		kind;		// sctkind_t
+	byte		mip;
+	byte		flags;		// SCTF_*
+	byte		result;		// sctresult_t
+} sctrecord_t;
+
+extern qboolean	sct_active;
+
+void SCTrace_Init (void);
+void SCTrace_Begin (void);
+void SCTrace_End (void);
+void SCTrace_Frame (void);
+void SCTrace_Flush (void);
+void SCTrace_Lookup (struct msurface_s *surface, int miplevel, struct surfcache_s *cache);
@@ -23,8 +23,27 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 int			cache_full_cycle;
 
+static int	snd_adpcmsounds;		// since the last S_AdpcmReport (true)
+static int	snd_adpcmsaved;
+
 byte *S_Alloc (int size);
 
+/*
+================
+S_AdpcmReport
+
+the per map summary of how much sound cache ADPCM saved
+================
+*/
+void S_AdpcmReport (qboolean reset)
+{
+	if (!reset && snd_adpcmsounds)
+		Con_DPrintf ("%i sounds stored as ADPCM, %iK of sound cache saved\n",
+				snd_adpcmsounds, (snd_adpcmsaved + 1023) >> 10);
+	if (reset)
+		snd_adpcmsounds = snd_adpcmsaved = 0;
+}
+
 /*
 ================
 ResampleSfx
@@ -37,7 +56,9 @@ void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 	float	stepscale;
 	int		i;
 	int		sample, samplefrac, fracstep;
+	int		j, n;
 	sfxcache_t	*sc;
+	signed char	block[SFX_ADPCM_BLOCK];
 	
 	sc = Cache_Check (&sfx->cache);
 	if (!sc)
@@ -59,6 +80,32 @@ void ResampleSfx (sfx_t *sfx, int inrate, int inwidth, byte *data)
 
 // resample / decimate to the current source rate
 
+	if (sc->adpcm)
+	{
+// encoded a block at a time, always 8 bit
+		sc->width = 1;
+		samplefrac = 0;
+		fracstep = stepscale*256;
+		for (i=0 ; i<outcount ; i+=SFX_ADPCM_BLOCK)
+		{
+			n = outcount - i;
+			if (n > SFX_ADPCM_BLOCK)
+				n = SFX_ADPCM_BLOCK;
+			for (j=0 ; j<n ; j++)
+			{
+				srcsample = samplefrac >> 8;
+				samplefrac += fracstep;
+				if (inwidth == 2)
+					sample = LittleShort ( ((short *)data)[srcsample] );
+				else
+					sample = (int)(data[srcsample] - 128) << 8;
+				block[j] = sample >> 8;
+			}
+			S_AdpcmEncodeBlock (sc->data + (i / SFX_ADPCM_BLOCK) * SFX_ADPCM_BLOCKBYTES, block, n);
+		}
+		return;
+	}
+
 	if (stepscale == 1 && inwidth == 1 && sc->width == 1)
 	{
 // fast special case
@@ -102,6 +149,7 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	int		len;
 	float	stepscale;
 	sfxcache_t	*sc;
+	qboolean	adpcm;
 	byte	stackbuf[1*1024];		// avoid dirtying the cache heap
 
 // see if still in memory
@@ -134,7 +182,22 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	stepscale = (float)info.rate / shm->speed;	
 	len = info.samples / stepscale;
 
-	len = len * info.width * info.channels;
+// 4 bit ADPCM if asked for by name, or for the big ones
+	if (s->format == SFX_FORMAT_AUTO)
+		adpcm = snd_adpcm.value && len >= snd_adpcmsize.value;
+	else
+		adpcm = s->format == SFX_FORMAT_ADPCM;
+	if (!loadas8bit.value)
+		adpcm = false;
+
+	if (adpcm)
+	{
+		snd_adpcmsounds++;
+		snd_adpcmsaved += len * info.width * info.channels - SFX_ADPCM_BYTES(len);
+		len = SFX_ADPCM_BYTES(len);
+	}
+	else
+		len = len * info.width * info.channels;
 
 	sc = Cache_Alloc ( &s->cache, len + sizeof(sfxcache_t), s->name);
 	if (!sc)
@@ -145,6 +208,7 @@ sfxcache_t *S_LoadSound (sfx_t *s)
 	sc->speed = info.rate;
 	sc->width = info.width;
 	sc->stereo = info.channels;
+	sc->adpcm = adpcm;
 
 	ResampleSfx (s, sc->speed, sc->width, data + info.dataofs);
 
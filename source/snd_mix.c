@@ -0,0 +1,301 @@
+/*
+Copyright (C) 1996-1997 Id Software, Inc.
+
+This program is free software; you can redistribute it and/or
+modify it under the terms of the GNU General Public License
+as published by the Free Software Foundation; either version 2
+of the License, or (at your option) any later version.
+
+This program is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+
+See the GNU General Public License for more details.
+
+You should have received a copy of the GNU General Public License
+along with this program; if not, write to the Free Software
+Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+
+*/
+// snd_mix.c -- portable channel mixing kernel used by S_RenderSfx
+//
+// kept apart from snd_pico.c so the host benchmark can drive it
+
+#include "quakedef.h"
+
+#if defined(__ARM_FEATURE_DSP) && defined(__ARM_FEATURE_SIMD32)
+#include <arm_acle.h>
+#define SND_DSP	1
+#else
+#define SND_DSP	0
+#endif
+
+/*
+===================
+S_PaintSamples
+
+Mixes count frames, count a multiple of 4. Four samples are fetched with
+one load; on the M33 they are sign extended in pairs with SXTB16 and
+multiplied against the packed left/right volume with the halfword
+SMLAxy forms, elsewhere the same unrolled loop is left to the compiler.
+===================
+*/
+static inline void S_PaintSamples (int32_t *d, const int8_t *s, int vl, int vr, int count)
+{
+#if SND_DSP
+	int32_t		vol = vl | (vr << 16);
+	int32_t		s02, s13;
+	uint32_t	w;
+
+	for ( ; count ; count -= 4, s += 4, d += 8)
+	{
+		memcpy (&w, s, 4);		// unaligned ldr
+		s02 = __sxtb16 (w);
+		s13 = __sxtb16 ((w >> 8) | (w << 24));
+		d[0] = __smlabb (s02, vol, d[0]);
+		d[1] = __smlabt (s02, vol, d[1]);
+		d[2] = __smlabb (s13, vol, d[2]);
+		d[3] = __smlabt (s13, vol, d[3]);
+		d[4] = __smlatb (s02, vol, d[4]);
+		d[5] = __smlatt (s02, vol, d[5]);
+		d[6] = __smlatb (s13, vol, d[6]);
+		d[7] = __smlatt (s13, vol, d[7]);
+	}
+#else
+	int		s0, s1, s2, s3;
+
+	for ( ; count ; count -= 4, s += 4, d += 8)
+	{
+		s0 = s[0];
+		s1 = s[1];
+		s2 = s[2];
+		s3 = s[3];
+		d[0] += s0 * vl;
+		d[1] += s0 * vr;
+		d[2] += s1 * vl;
+		d[3] += s1 * vr;
+		d[4] += s2 * vl;
+		d[5] += s2 * vr;
+		d[6] += s3 * vl;
+		d[7] += s3 * vr;
+	}
+#endif
+}
+
+/*
+==============================================================================
+
+IMA ADPCM
+
+==============================================================================
+*/
+
+// in ram, core 1 walks these for every decoded sample
+static short	adpcm_steptable[89] = {
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37,
+	41, 45, 50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173,
+	190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658,
+	724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+	2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484,
+	7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818,
+	18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static signed char	adpcm_indextable[16] = {
+	-1, -1, -1, -1, 2, 4, 6, 8,
+	-1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static int8_t	adpcm_buf[SFX_ADPCM_BLOCK];		// decoded samples, core 1 only
+
+/*
+===================
+S_AdpcmDecodeStep
+
+advances the predictor by one code
+===================
+*/
+static inline void S_AdpcmDecodeStep (int *pred, int *index, int code)
+{
+	int		step, diff;
+
+	step = adpcm_steptable[*index];
+	diff = step >> 3;
+	if (code & 4)
+		diff += step;
+	if (code & 2)
+		diff += step >> 1;
+	if (code & 1)
+		diff += step >> 2;
+	if (code & 8)
+		*pred -= diff;
+	else
+		*pred += diff;
+	if (*pred > 32767)
+		*pred = 32767;
+	else if (*pred < -32768)
+		*pred = -32768;
+
+	*index += adpcm_indextable[code];
+	if (*index < 0)
+		*index = 0;
+	else if (*index > 88)
+		*index = 88;
+}
+
+/*
+===================
+S_AdpcmEncodeBlock
+
+Encodes up to SFX_ADPCM_BLOCK 8 bit samples, the rest of the block is
+padded with silence. Runs the decoder alongside so both stay in step.
+===================
+*/
+void S_AdpcmEncodeBlock (byte *out, signed char *samples, int count)
+{
+	int		i, x, pred, index, step, diff, code;
+	byte	*codes;
+
+	pred = (samples[0] << 8) | 0x80;
+	index = 0;
+	out[0] = pred & 255;
+	out[1] = (pred >> 8) & 255;
+	out[2] = index;
+	out[3] = 0;
+	codes = out + 4;
+	memset (codes, 0, SFX_ADPCM_BLOCK/2);
+
+	for (i=0 ; i<SFX_ADPCM_BLOCK ; i++)
+	{
+		x = i < count ? (samples[i] << 8) | 0x80 : 0;
+		step = adpcm_steptable[index];
+		diff = x - pred;
+		code = 0;
+		if (diff < 0)
+		{
+			code = 8;
+			diff = -diff;
+		}
+		if (diff >= step)
+		{
+			code |= 4;
+			diff -= step;
+		}
+		step >>= 1;
+		if (diff >= step)
+		{
+			code |= 2;
+			diff -= step;
+		}
+		step >>= 1;
+		if (diff >= step)
+			code |= 1;
+
+		S_AdpcmDecodeStep (&pred, &index, code);
+		codes[i>>1] |= code << ((i & 1) << 2);
+	}
+}
+
+/*
+===================
+S_AdpcmDecode
+
+Decodes count samples at ch->pos, within one block, into adpcm_buf. The
+decoder state is left in the channel so the next buffer continues where
+this one stopped instead of decoding the block again from its header.
+===================
+*/
+static int8_t * __not_in_flash_func(S_AdpcmDecode) (channel_t *ch, sfxcache_t *sc, int count)
+{
+	int		i, first, last, pred, index, code;
+	byte	*block;
+
+	first = ch->pos & (SFX_ADPCM_BLOCK-1);
+	last = first + count;
+	block = sc->data + (ch->pos / SFX_ADPCM_BLOCK) * SFX_ADPCM_BLOCKBYTES;
+
+	if (first && ch->adpcmsc == sc && ch->adpcmpos == ch->pos)
+	{
+		pred = ch->adpcmpred;
+		index = ch->adpcmindex;
+		i = first;
+	}
+	else
+	{
+		pred = (short)(block[0] | (block[1] << 8));
+		index = block[2];
+		i = 0;
+	}
+
+	for (block += 4 ; i<last ; i++)
+	{
+		code = (block[i>>1] >> ((i & 1) << 2)) & 15;
+		S_AdpcmDecodeStep (&pred, &index, code);
+		if (i >= first)
+			adpcm_buf[i - first] = pred >> 8;
+	}
+
+	ch->adpcmsc = sc;
+	ch->adpcmpos = ch->pos + count;
+	ch->adpcmpred = pred;
+	ch->adpcmindex = index;
+	return adpcm_buf;
+}
+
+/*
+===================
+S_PaintSfxChannel
+
+Adds frames of one 8 bit channel into a stereo 1.15 accumulation buffer,
+ADPCM sounds are decoded a block at a time on the way. Advances ch->pos,
+rewinds looped sounds and kills finished oneshots.
+===================
+*/
+void __not_in_flash_func(S_PaintSfxChannel) (int32_t *sfxbuf, channel_t *ch, sfxcache_t *sc, int frames, uint32_t timestamp)
+{
+	int32_t *d = sfxbuf;
+	int8_t  *s;
+	int vl = ch->leftvol >> 1, vr = ch->rightvol >> 1;
+	int f  = frames;
+
+	if (vl > 255) vl = 255;
+	if (vr > 255) vr = 255;
+
+	s = (int8_t*)sc->data + ch->pos;
+
+	// TODO this logic do not take into account ch->end, which kills sounds after certain amoutn of time
+	// or probably we shouldn't care lmao
+	while (f > 0) {
+		if (sc->length <= 0) break; // bogus sound
+		int n = (sc->length - ch->pos); if (n > f) n = f;
+		if (sc->adpcm) {
+			int left = SFX_ADPCM_BLOCK - (ch->pos & (SFX_ADPCM_BLOCK-1));
+			if (n > left) n = left;
+			s = S_AdpcmDecode (ch, sc, n);
+		}
+		int nn = n & ~3;
+		if (nn > 0) {
+			S_PaintSamples (d, s, vl, vr, nn);
+			d += nn*2; s += nn;
+		}
+		for (nn = n & 3 ; nn > 0 ; nn--) {
+			d[0] += (*s * vl); // 1.7 x 8.0 -> 1.15
+			d[1] += (*s * vr); // 1.7 x 8.0 -> 1.15
+			d += 2; s++;
+		}
+
+		ch->pos += n; f -= n;
+		if (ch->pos >= sc->length) {
+			if (sc->loopstart < 0) {
+				// oneshot
+				ch->sfx = NULL;	// done, kill sfx
+				break;
+			} else {
+				// looped, rewind to loop position
+				ch->pos = sc->loopstart;
+				ch->end = timestamp + n + sc->length - ch->pos;		// FIXME
+			}
+		}
+		s = (int8_t*)sc->data + ch->pos;
+	}
+}
@@ -30,6 +30,7 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 void S_Play(void);
 void S_PlayVol(void);
 void S_SoundList(void);
+void S_SoundFormat_f(void);
 void S_Update_();
 void S_StopAllSounds(qboolean clear);
 void S_StopAllSoundsC(void);
@@ -59,7 +60,7 @@ vec_t		sound_nominal_clip_dist=1000.0;
 sfx_t		*known_sfx;		// hunk allocated [MAX_SFX]
 int			num_sfx;
 
-int 		desired_speed = 11025;
+int 		desired_speed = SFX_OUTPUT_RATE / SFX_DOWNSAMPLE_RATIO;
 int 		desired_bits = 16;
 int 		paintedtime = 0;
 
@@ -74,6 +75,8 @@ cvar_t precache = {"precache", "1"};
 cvar_t ambient_level = {"ambient_level", "0.3"};
 cvar_t ambient_fade = {"ambient_fade", "100"};
 cvar_t snd_noextraupdate = {"snd_noextraupdate", "0"};
+cvar_t snd_adpcm = {"snd_adpcm", "0"};
+cvar_t snd_adpcmsize = {"snd_adpcmsize", "4096"};		// bytes of 8 bit pcm
 
 // ---------------------------
 // CORE 1 STUFF
@@ -92,43 +95,12 @@ void __not_in_flash_func(S_RenderSfx)(int32_t *sfxbuf, int frames, uint32_t time
 		if (ch->sfx == 0) continue;													 // no sfx
 		if (ch->leftvol == 0 || ch->rightvol == 0 || ch->end >= timestamp) continue; // silent or died
 
-		int32_t *d = sfxbuf;
-		int8_t  *s;
-		int vl = MIN(ch->leftvol >> 1, 255), vr = MIN(ch->rightvol >> 1, 255);
-		int f  = frames;
-
 		// get data pointer, checked last
 		sc = (sfxcache_t*)ch->sfx->cache.data;
 		if (sc == NULL || sc->data == NULL || sc->length <= 0) continue;
 
 		// render the channel (YES, UNDER A MUTEX)
-		s = (int8_t*)sc->data + ch->pos;
-
-		// TODO this logic do not take into account ch->end, which kills sounds after certain amoutn of time
-		// or probably we shouldn't care lmao
-		while (f > 0) {
-			if (sc->length <= 0) break; // bogus sound
-			int n = (sc->length - ch->pos); if (n > f) n = f; int nn = n;
-			if (n > 0) do {
-				d[0] += (*s * vl); // 1.7 x 8.0 -> 1.15
-				d[1] += (*s * vr); // 1.7 x 8.0 -> 1.15
-				d += 2; s++;
-			} while (--nn);
-
-			ch->pos += n; f -= n;
-			if (ch->pos >= sc->length) {
-				if (sc->loopstart < 0) {
-					// oneshot
-					ch->sfx = NULL;	// done, kill sfx
-					break;
-				} else {
-					// looped, rewind to loop position
-					ch->pos = sc->loopstart;
-					ch->end = timestamp + n + sc->length - ch->pos;		// FIXME
-					s = (int8_t*)sc->data + ch->pos;
-				}
-			}
-		}
+		S_PaintSfxChannel (sfxbuf, ch, sc, frames, timestamp);
 	}
 	mutex_exit(&snd_mutex);
 }
@@ -176,7 +148,7 @@ qboolean SNDDMA_Init(void)
 {
 	shm = &sn;
 	shm->buffer = NULL;		// mixing is done by core1
-	shm->speed = 11025;		// forced by now, also conserves memory
+	shm->speed = SFX_OUTPUT_RATE / SFX_DOWNSAMPLE_RATIO;	// conserves memory
 	shm->soundalive = true;
 
 	return 1;
@@ -223,6 +195,7 @@ void S_Init (void)
 	Cmd_AddCommand("stopsound", S_StopAllSoundsC);
 	Cmd_AddCommand("soundlist", S_SoundList);
 	Cmd_AddCommand("soundinfo", S_SoundInfo_f);
+	Cmd_AddCommand("sndformat", S_SoundFormat_f);
 
 	Cvar_RegisterVariable(&nosound);
 	Cvar_RegisterVariable(&cvar_volume);
@@ -231,6 +204,8 @@ void S_Init (void)
 	Cvar_RegisterVariable(&ambient_level);
 	Cvar_RegisterVariable(&ambient_fade);
 	Cvar_RegisterVariable(&snd_noextraupdate);
+	Cvar_RegisterVariable(&snd_adpcm);
+	Cvar_RegisterVariable(&snd_adpcmsize);
 
 	if (host_parms.memsize < 0x800000)
 	{
@@ -403,6 +378,98 @@ channel_t *SND_PickChannel(int entnum, int entchannel)
     return &channels[first_to_die];    
 }
 
+/*
+=================
+SND_SetListener
+
+Spatialization runs in fixed point: positions in whole world units, the
+listener's right vector in 2.14 and volumes scaled in 8.8
+=================
+*/
+static int	snd_listener[3];
+static int	snd_right[3];
+
+static void SND_SetListener (void)
+{
+	int		i;
+
+	for (i=0 ; i<3 ; i++)
+	{
+		snd_listener[i] = (int)listener_origin[i];
+		snd_right[i] = (int)(listener_right[i] * (1<<14));
+	}
+}
+
+static unsigned SND_ISqrt (unsigned x)
+{
+	unsigned	root, bit;
+
+	root = 0;
+	for (bit = 1u<<30 ; bit > x ; bit >>= 2)
+		;
+	for ( ; bit ; bit >>= 2)
+	{
+		if (x >= root + bit)
+		{
+			x -= root + bit;
+			root = (root >> 1) + bit;
+		}
+		else
+			root >>= 1;
+	}
+	return root;
+}
+
+/*
+=================
+SND_SpatializeFixed
+
+distmult is dist_mult scaled by 2**24
+=================
+*/
+static void __not_in_flash_func(SND_SpatializeFixed) (int *origin, int distmult, int master_vol, int *left, int *right)
+{
+	int		i, d[3], dist, fade, dot, lscale, rscale;
+
+	for (i=0 ; i<3 ; i++)
+	{
+		d[i] = origin[i] - snd_listener[i];
+	// keeps the squares and the dot product in range, nothing that far
+	// away is audible unless it's ATTN_NONE, which only needs the direction
+		if (d[i] > 16383)
+			d[i] = 16383;
+		else if (d[i] < -16383)
+			d[i] = -16383;
+	}
+
+	dist = SND_ISqrt (d[0]*d[0] + d[1]*d[1] + d[2]*d[2]);
+
+// distance effect
+	fade = 256 - ((dist * distmult) >> 16);
+	if (fade <= 0)
+	{
+		*left = *right = 0;
+		return;
+	}
+
+// stereo seperation
+	if (shm->channels == 1 || !dist)
+	{
+		rscale = 256;
+		lscale = 256;
+	}
+	else
+	{
+		dot = (snd_right[0]*d[0] + snd_right[1]*d[1] + snd_right[2]*d[2]) / dist;
+		dot >>= 6;
+		rscale = 256 + dot;
+		lscale = 256 - dot;
+	}
+
+	*right = (master_vol * fade * rscale) >> 16;
+	*left = (master_vol * fade * lscale) >> 16;
+}
+
 /*
 =================
 SND_Spatialize
@@ -410,11 +477,7 @@ SND_Spatialize
 */
 void SND_Spatialize(channel_t *ch)
 {
-    vec_t dot;
-    vec_t ldist, rdist, dist;
-    vec_t lscale, rscale, scale;
-    vec3_t source_vec;
-	sfx_t *snd;
+	int		origin[3];
 
 // anything coming from the view entity will allways be full volume
 	if (ch->entnum == cl.viewentity)
@@ -425,35 +488,131 @@ void SND_Spatialize(channel_t *ch)
 	}
 
 // calculate stereo seperation and distance attenuation
+	origin[0] = (int)ch->origin[0];
+	origin[1] = (int)ch->origin[1];
+	origin[2] = (int)ch->origin[2];
+	SND_SpatializeFixed (origin, (int)(ch->dist_mult * (1<<24)), ch->master_vol,
+			&ch->leftvol, &ch->rightvol);
+}
 
-	snd = ch->sfx;
-	VectorSubtract(ch->origin, listener_origin, source_vec);
-	
-	dist = VectorNormalize(source_vec) * ch->dist_mult;
-	
-	dot = DotProduct(listener_right, source_vec);
+/*
+===============================================================================
+
+STATIC SOUNDS
+
+The static channels are copied into a compact array, bucketed by sfx, when
+the set changes. Every update spatializes the array and sums each bucket,
+the first channel of a bucket plays for all of them so five torches are
+mixed once, and the others stay silent.
 
-	if (shm->channels == 1)
+===============================================================================
+*/
+
+typedef struct
+{
+	sfx_t	*sfx;
+	int		origin[3];
+	int		distmult;			// dist_mult * 2**24
+	int		master_vol;
+	int		channel;			// in channels[]
+} staticsound_t;
+
+static staticsound_t	snd_statics[MAX_CHANNELS];
+static int				snd_numstatics;
+static short			snd_staticgroups[MAX_CHANNELS+1];	// first static of every sfx
+static int				snd_numstaticgroups;
+static qboolean			snd_staticsdirty;
+
+/*
+=================
+S_SortStaticSounds
+=================
+*/
+static void S_SortStaticSounds (void)
+{
+	int				i, j;
+	channel_t		*ch;
+	staticsound_t	ss;
+
+	snd_numstatics = 0;
+	for (i=MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS ; i<total_channels ; i++)
 	{
-		rscale = 1.0f;
-		lscale = 1.0f;
+		ch = &channels[i];
+		if (!ch->sfx)
+			continue;
+
+		ss.sfx = ch->sfx;
+		ss.origin[0] = (int)ch->origin[0];
+		ss.origin[1] = (int)ch->origin[1];
+		ss.origin[2] = (int)ch->origin[2];
+		ss.distmult = (int)(ch->dist_mult * (1<<24));
+		ss.master_vol = ch->master_vol;
+		ss.channel = i;
+
+	// insertion sort by sfx, channel order within an sfx is kept
+		for (j=snd_numstatics ; j>0 && snd_statics[j-1].sfx > ss.sfx ; j--)
+			snd_statics[j] = snd_statics[j-1];
+		snd_statics[j] = ss;
+		snd_numstatics++;
 	}
-	else
+
+	snd_numstaticgroups = 0;
+	for (i=0 ; i<snd_numstatics ; i++)
+	{
+		if (i && snd_statics[i].sfx == snd_statics[i-1].sfx)
+		{
+			ch = &channels[snd_statics[i].channel];
+			ch->leftvol = ch->rightvol = 0;		// carried by the first one
+			continue;
+		}
+		snd_staticgroups[snd_numstaticgroups++] = i;
+	}
+	snd_staticgroups[snd_numstaticgroups] = snd_numstatics;
+
+	snd_staticsdirty = false;
+}
+
+/*
+=================
+S_UpdateStaticSounds
+=================
+*/
+static void S_UpdateStaticSounds (void)
+{
+	int		g, i, left, right, l, r;
+	int		vols[MAX_CHANNELS][2];
+	channel_t	*ch;
+
+	if (snd_staticsdirty)
 	{
-		rscale = 1.0f + dot;
-		lscale = 1.0f - dot;
+		mutex_enter_blocking(&snd_mutex);
+		S_SortStaticSounds ();
+		mutex_exit(&snd_mutex);
 	}
 
-// add in distance effect
-	scale = (1.0f - dist) * rscale;
-	ch->rightvol = (int) (ch->master_vol * scale);
-	if (ch->rightvol < 0)
-		ch->rightvol = 0;
+	for (g=0 ; g<snd_numstaticgroups ; g++)
+	{
+		left = right = 0;
+		for (i=snd_staticgroups[g] ; i<snd_staticgroups[g+1] ; i++)
+		{
+			SND_SpatializeFixed (snd_statics[i].origin, snd_statics[i].distmult,
+					snd_statics[i].master_vol, &l, &r);
+			left += l;
+			right += r;
+		}
+		vols[g][0] = left;
+		vols[g][1] = right;
+	}
 
-	scale = (1.0f - dist) * lscale;
-	ch->leftvol = (int) (ch->master_vol * scale);
-	if (ch->leftvol < 0)
-		ch->leftvol = 0;
+// publish, the lock is only held for the stores
+	mutex_enter_blocking(&snd_mutex);
+	for (g=0 ; g<snd_numstaticgroups ; g++)
+	{
+		ch = &channels[snd_statics[snd_staticgroups[g]].channel];
+		ch->leftvol = vols[g][0];
+		ch->rightvol = vols[g][1];
+	}
+	mutex_exit(&snd_mutex);
 }
 
 // =======================================================================
@@ -570,6 +729,7 @@ void S_StopAllSounds(qboolean clear)
 			channels[i].sfx = NULL;
 
 	Q_memset(channels, 0, MAX_CHANNELS * sizeof(channel_t));
+	snd_staticsdirty = true;
 	mutex_exit(&snd_mutex);
 
 	if (clear)
@@ -621,6 +781,7 @@ void S_StaticSound (sfx_t *sfx, vec3_t origin, float vol, float attenuation)
     ss->end = paintedtime + sc->length;	
 	
 	SND_Spatialize (ss);
+	snd_staticsdirty = true;
 	mutex_exit(&snd_mutex);
 }
 
@@ -652,6 +813,7 @@ void S_UpdateAmbientSounds (void)
 	{
 		for (ambient_channel = 0 ; ambient_channel< NUM_AMBIENTS ; ambient_channel++)
 			channels[ambient_channel].sfx = NULL;
+		mutex_exit(&snd_mutex);
 		return;
 	}
 
@@ -692,10 +854,9 @@ Called once each time through the main loop
 */
 void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 {
-	int			i, j;
+	int			i;
 	int			total;
 	channel_t	*ch;
-	channel_t	*combine;
 
 	if (!sound_started || (snd_blocked > 0))
 		return;
@@ -704,61 +865,22 @@ void S_Update(vec3_t origin, vec3_t forward, vec3_t right, vec3_t up)
 	VectorCopy(forward, listener_forward);
 	VectorCopy(right, listener_right);
 	VectorCopy(up, listener_up);
+	SND_SetListener ();
 	
 // update general area ambient sound sources
 	S_UpdateAmbientSounds ();
 
-	combine = NULL;
-
-// update spatialization for static and dynamic sounds	
-	mutex_enter_blocking(&snd_mutex);
+// update spatialization for dynamic sounds; core 1 only reads the volumes
+// and channels are only started from this core, so no lock is needed
 	ch = channels+NUM_AMBIENTS;
-	for (i=NUM_AMBIENTS ; i<total_channels; i++, ch++)
+	for (i=NUM_AMBIENTS ; i<MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS && i<total_channels; i++, ch++)
 	{
-		if (!ch->sfx)
-			continue;
-		SND_Spatialize(ch);         // respatialize channel
-		if (!ch->leftvol && !ch->rightvol)
-			continue;
-
-	// try to combine static sounds with a previous channel of the same
-	// sound effect so we don't mix five torches every frame
-	
-		if (i >= MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS)
-		{
-		// see if it can just use the last one
-			if (combine && combine->sfx == ch->sfx)
-			{
-				combine->leftvol += ch->leftvol;
-				combine->rightvol += ch->rightvol;
-				ch->leftvol = ch->rightvol = 0;
-				continue;
-			}
-		// search for one
-			combine = channels+MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS;
-			for (j=MAX_DYNAMIC_CHANNELS + NUM_AMBIENTS ; j<i; j++, combine++)
-				if (combine->sfx == ch->sfx)
-					break;
-					
-			if (j == total_channels)
-			{
-				combine = NULL;
-			}
-			else
-			{
-				if (combine != ch)
-				{
-					combine->leftvol += ch->leftvol;
-					combine->rightvol += ch->rightvol;
-					ch->leftvol = ch->rightvol = 0;
-				}
-				continue;
-			}
-		}
-		
-		
+		if (ch->sfx)
+			SND_Spatialize(ch);         // respatialize channel
 	}
-	mutex_exit(&snd_mutex);
+
+// and the static ones, combined per sfx
+	S_UpdateStaticSounds ();
 
 	// update CD audio
 	CDAudio_Update();
@@ -790,23 +912,78 @@ void S_SoundList(void)
 	int		i;
 	sfx_t	*sfx;
 	sfxcache_t	*sc;
-	int		size, total;
+	int		size, total, saved;
 
-	total = 0;
+	total = saved = 0;
 	for (sfx=known_sfx, i=0 ; i<num_sfx ; i++, sfx++)
 	{
 		sc = Cache_Check (&sfx->cache);
 		if (!sc)
 			continue;
 		size = sc->length*sc->width*(sc->stereo+1);
+		if (sc->adpcm)
+		{
+			saved += size - SFX_ADPCM_BYTES(sc->length);
+			size = SFX_ADPCM_BYTES(sc->length);
+		}
 		total += size;
 		if (sc->loopstart >= 0)
 			Con_Printf ("L");
 		else
 			Con_Printf (" ");
-		Con_Printf("(%2db) %6i : %s\n",sc->width*8,  size, sfx->name);
+		Con_Printf("(%2db) %6i : %s\n", sc->adpcm ? 4 : sc->width*8,  size, sfx->name);
 	}
 	Con_Printf ("Total resident: %i\n", total);
+	if (saved)
+		Con_Printf ("Saved by ADPCM: %i\n", saved);
+}
+
+/*
+==================
+S_SoundFormat_f
+
+sndformat <sample> [auto|pcm|adpcm]
+==================
+*/
+void S_SoundFormat_f(void)
+{
+	static char	*formats[] = {"auto", "pcm", "adpcm"};
+	sfx_t	*sfx;
+	int		format;
+
+	if (Cmd_Argc() < 2 || Cmd_Argc() > 3)
+	{
+		Con_Printf ("sndformat <sample> [auto|pcm|adpcm]\n");
+		return;
+	}
+	if (!known_sfx)
+		return;
+
+	sfx = S_FindName (Cmd_Argv(1));
+	if (Cmd_Argc() == 2)
+	{
+		Con_Printf ("%s: %s\n", sfx->name, formats[sfx->format]);
+		return;
+	}
+
+	for (format=0 ; format<3 ; format++)
+		if (!Q_strcasecmp (Cmd_Argv(2), formats[format]))
+			break;
+	if (format == 3)
+	{
+		Con_Printf ("sndformat: unknown format %s\n", Cmd_Argv(2));
+		return;
+	}
+	if (format == sfx->format)
+		return;
+	sfx->format = format;
+
+// reloaded in the new format the next time it plays, core 1 must not be
+// in the middle of it when it goes
+	mutex_enter_blocking(&snd_mutex);
+	if (Cache_Check (&sfx->cache))
+		Cache_Free (&sfx->cache);
+	mutex_exit(&snd_mutex);
 }
 
 
@@ -839,10 +1016,12 @@ void S_ClearPrecache (void)
 
 void S_BeginPrecaching (void)
 {
+	S_AdpcmReport (true);
 }
 
 void S_EndPrecaching (void)
 {
+	S_AdpcmReport (false);
 }
 
 void S_LocalSound (char *sound)
@@ -27,7 +27,12 @@ extern "C" {
 #ifndef __SOUND__
 #define __SOUND__
 
-#define SFX_DOWNSAMPLE_RATIO 4
+// effects are mixed at SFX_OUTPUT_RATE >> SFX_DOWNSAMPLE_SHIFT and linearly
+// interpolated up by the output callback; a shift of 1 doubles the effect
+// rate at the cost of twice the sound cache
+#define SFX_OUTPUT_RATE 44100
+#define SFX_DOWNSAMPLE_SHIFT 2
+#define SFX_DOWNSAMPLE_RATIO (1 << SFX_DOWNSAMPLE_SHIFT)
 
 #define DEFAULT_SOUND_PACKET_VOLUME 255
 #define DEFAULT_SOUND_PACKET_ATTENUATION 1.0
@@ -39,12 +44,24 @@ typedef struct
 	int right;
 } portable_samplepair_t;
 
+#define SFX_FORMAT_AUTO		0		// ADPCM when snd_adpcm and over snd_adpcmsize
+#define SFX_FORMAT_PCM		1
+#define SFX_FORMAT_ADPCM	2
+
 typedef struct sfx_s
 {
 	char 	name[MAX_QPATH];
 	cache_user_t	cache;
+	int		format;			// SFX_FORMAT_*, set with "sndformat"
 } sfx_t;
 
+// 4 bit IMA ADPCM: blocks of SFX_ADPCM_BLOCK samples, each a 4 byte header
+// (16 bit predictor, step index, pad) followed by the codes, low nibble
+// first, so a block can be decoded without the ones before it
+#define SFX_ADPCM_BLOCK			256
+#define SFX_ADPCM_BLOCKBYTES	(4 + SFX_ADPCM_BLOCK/2)
+#define SFX_ADPCM_BYTES(n)		((((n) + SFX_ADPCM_BLOCK-1) / SFX_ADPCM_BLOCK) * SFX_ADPCM_BLOCKBYTES)
+
 // !!! if this is changed, it much be changed in asm_i386.h too !!!
 typedef struct
 {
@@ -53,6 +70,7 @@ typedef struct
 	int 	speed;
 	int 	width;
 	int 	stereo;
+	int		adpcm;			// data is SFX_ADPCM_BLOCK blocks, decodes to width 1
 	byte	data[1];		// variable sized
 } sfxcache_t;
 
@@ -84,6 +102,9 @@ typedef struct
 	vec3_t	origin;			// origin of sound effect
 	vec_t	dist_mult;		// distance multiplier (attenuation/clipK)
 	int		master_vol;		// 0-255 master volume
+	sfxcache_t	*adpcmsc;	// decoder state at adpcmpos, kept by the mixer
+	int		adpcmpos;
+	int		adpcmpred, adpcmindex;
 } channel_t;
 
 typedef struct
@@ -115,6 +136,12 @@ void S_EndPrecaching (void);
 void S_PaintChannels(int endtime);
 void S_InitPaintChannels (void);
 
+// mixes one 8 bit channel into a stereo accumulation buffer (snd_mix.c)
+void S_PaintSfxChannel (int32_t *sfxbuf, channel_t *ch, sfxcache_t *sc, int frames, uint32_t timestamp);
+
+// IMA ADPCM encoder for the sound cache (snd_mix.c), count <= SFX_ADPCM_BLOCK
+void S_AdpcmEncodeBlock (byte *out, signed char *samples, int count);
+
 // picks a channel based on priorities, empty slots, number of channels
 channel_t *SND_PickChannel(int entnum, int entchannel);
 
@@ -163,6 +190,8 @@ extern volatile dma_t sn;
 extern vec_t sound_nominal_clip_dist;
 
 extern	cvar_t loadas8bit;
+extern	cvar_t snd_adpcm;
+extern	cvar_t snd_adpcmsize;
 extern	cvar_t bgmvolume;
 extern	cvar_t cvar_volume;
 
@@ -170,6 +199,7 @@ extern qboolean	snd_initialized;
 
 void S_LocalSound (char *s);
 sfxcache_t *S_LoadSound (sfx_t *s);
+void S_AdpcmReport (qboolean reset);
 
 wavinfo_t GetWavinfo (char *name, byte *wav, int wavlength);
 
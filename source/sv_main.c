@@ -1079,6 +1079,7 @@ void SV_SpawnServer (char *server)
 	sv.max_edicts = MAX_EDICTS;
 	
 	sv.edicts = Hunk_AllocName (sv.max_edicts*pr_edict_size, "edicts");
+	ED_ClearIndex ();
 
 	sv.datagram.maxsize = sizeof(svp.datagram_buf);
 	sv.datagram.cursize = 0;
@@ -98,6 +98,7 @@ void SV_CheckVelocity (edict_t *ent)
 		{
 			Con_Printf ("Got a NaN origin on %s\n", pr_strings + ent->v.classname);
 			ent->v.origin[i] = 0;
+			SV_AreaStale (ent);
 		}
 		if (ent->v.velocity[i] > sv_maxvelocity.value)
 			ent->v.velocity[i] = sv_maxvelocity.value;
@@ -263,6 +264,7 @@ int SV_FlyMove (edict_t *ent, float time, trace_t *steptrace)
 			VectorCopy (trace.endpos, ent->v.origin);
 			VectorCopy (ent->v.velocity, original_velocity);
 			numplanes = 0;
+			SV_AreaStale (ent);	// touch functions run before the caller relinks
 		}
 
 		if (trace.fraction == 1)
@@ -506,6 +508,7 @@ void SV_PushMove (edict_t *pusher, float movetime)
 			{	// corpse
 				check->v.mins[0] = check->v.mins[1] = 0;
 				VectorCopy (check->v.mins, check->v.maxs);
+				SV_AreaStale (check);
 				continue;
 			}
 			
@@ -77,6 +77,12 @@ void Sys_LowFPPrecision (void);
 void Sys_HighFPPrecision (void);
 void Sys_SetFPCW (void);
 
+void Sys_StartSampler (int hz, void (*sample) (const uint32_t *frame));
+void Sys_StopSampler (void);
+// calls sample hz times a second from an interrupt, with the exception frame
+// (r0-r3, r12, lr, pc, xpsr) of the code it stopped; does nothing on systems
+// without such an interrupt
+
 void Sys_PrintError(char *error, ...);
 
 #ifdef __cplusplus
@@ -208,6 +208,15 @@ void Sys_LowFPPrecision (void)
 {
 }
 
+// no interrupt to sample from here, pcprof instruments the host build
+void Sys_StartSampler (int hz, void (*sample) (const uint32_t *frame))
+{
+}
+
+void Sys_StopSampler (void)
+{
+}
+
 //=============================================================================
 
 /*
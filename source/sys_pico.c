@@ -21,6 +21,9 @@ Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
 
 #include <pico/stdlib.h>
 #include <hardware/watchdog.h>
+#include <hardware/exception.h>
+#include <hardware/clocks.h>
+#include <hardware/structs/systick.h>
 #include <tusb.h>
 #include "quakedef.h"
 #include "sys.h"
@@ -290,6 +293,57 @@ void Sys_LowFPPrecision (void)
 {
 }
 
+/*
+===============================================================================
+
+SAMPLER
+
+SysTick on core 0, for the pcprof profile
+
+===============================================================================
+*/
+
+static void (*sys_sample) (const uint32_t *frame);
+static exception_handler_t	sys_oldsystick;
+
+void __not_in_flash_func(Sys_SampleFrame) (const uint32_t *frame)
+{
+	sys_sample (frame);
+}
+
+// hands the stacked frame of whatever was interrupted to Sys_SampleFrame
+static void __attribute__((naked)) __not_in_flash_func(Sys_SysTick) (void)
+{
+	__asm__ volatile (
+		"tst    lr, #4" "\n"
+		"ite    eq" "\n"
+		"mrseq  r0, msp" "\n"
+		"mrsne  r0, psp" "\n"
+		"b      Sys_SampleFrame" "\n"
+	);
+}
+
+void Sys_StartSampler (int hz, void (*sample) (const uint32_t *frame))
+{
+	Sys_StopSampler ();
+
+	sys_sample = sample;
+	sys_oldsystick = exception_set_exclusive_handler (SYSTICK_EXCEPTION, Sys_SysTick);
+	systick_hw->rvr = clock_get_hz (clk_sys) / hz - 1;
+	systick_hw->cvr = 0;
+	systick_hw->csr = M33_SYST_CSR_CLKSOURCE_BITS | M33_SYST_CSR_TICKINT_BITS | M33_SYST_CSR_ENABLE_BITS;
+}
+
+void Sys_StopSampler (void)
+{
+	if (!sys_sample)
+		return;
+
+	systick_hw->csr = 0;
+	exception_restore_handler (SYSTICK_EXCEPTION, sys_oldsystick);
+	sys_sample = NULL;
+}
+
 void _unlink(const char* path) {
 	f_unlink(path);
 }
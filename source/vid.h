@@ -81,19 +81,7 @@ int VID_SetMode (int modenum, unsigned char *palette);
 void VID_HandlePause (qboolean pause);
 // called only on Win32, when pause happens, so the mouse can be released
 
-// evil z-buffer allocator, used for overoptimizing certain things ;)
-void ZBA_Reset();
-uint8_t* ZBA_GetRover();
-void ZBA_FreeToRover(uint8_t *rover);
-void *ZBA_Alloc(int bytes);
-int ZBA_GetZBufferMaxRow();
-uint32_t ZBA_GetFreeBytes();
-
-// aux buffer allocator - available at all times, used for predictable allocations
-void AUXA_Reset();
-uint8_t* AUXA_GetRover();
-void AUXA_FreeToRover(uint8_t *rover);
-void *AUXA_Alloc(int bytes);
-void *AUXA_MAlloc(int bytes);
-void AUXA_MFree(void *ptr);
-uint32_t AUXA_GetFreeBytes();
+// frame temporary memory (arena.h); the z-buffer arena is shared with the
+// z-buffer rows, the aux arena is available at all times
+extern arena_t zbuffer_arena;
+extern arena_t aux_arena;
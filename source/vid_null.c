@@ -48,102 +48,27 @@ size_t	surfcache_size = 652800;
 static byte surfcache_sram[SURFCACHE_SRAM_SIZE];
 #endif
 
-// evil z-buffer allocator, used for overoptimizing certain things ;)
-uint8_t *zba_rover;
-void ZBA_Reset() {
-	zba_rover = (uint8_t*)&zbuffer[BASEWIDTH*BASEHEIGHT];
-}
-uint8_t* ZBA_GetRover() {
-	return zba_rover;
-}
-void ZBA_FreeToRover(uint8_t *rover) {
-	if (((uintptr_t)rover <= (uintptr_t)zbuffer) || ((uintptr_t)rover > (uintptr_t)&zbuffer[BASEWIDTH*BASEHEIGHT])) {
-		Sys_Error("ZBA_FreeToRover(): attempt to reset rover outside of Z-buffer memory (%08X != [%08X..%08X])\n",
-			(uintptr_t)rover, (uintptr_t)zbuffer, (uintptr_t)&zbuffer[BASEWIDTH*BASEHEIGHT]
-		);
-	}
-	zba_rover = rover;
-}
-
-void *ZBA_Alloc(int bytes) {
-	if ((uintptr_t)(zba_rover - bytes) <= (uintptr_t)zbuffer) {
-		Sys_Error("ZBA_Alloc(): tried to allocate %d bytes but ran out of Z-buffer memory\n", bytes);
-		return NULL;
-	}
-	zba_rover -= bytes;
-	//Sys_Printf("ZBA_Alloc(): %d bytes -> 0x%08X", bytes, (uintptr_t)zba_rover);
-	return (void*)zba_rover;
-}
-
-int ZBA_GetZBufferMaxRow() {
-	int rtn = (zba_rover - (uint8_t*)&zbuffer[BASEWIDTH-1]) / (sizeof(short)*BASEWIDTH);
-	return rtn < 0 ? 0 : rtn;
-}
+// frame temporary memory: the top of the z-buffer, below the rows being
+// drawn, and the aux buffer, available at all times
+arena_t	zbuffer_arena;
+arena_t	aux_arena;
 
-uint32_t ZBA_GetFreeBytes() {
-	return ((uintptr_t)zba_rover - (uintptr_t)zbuffer);
-}
-
-// ----------------------
-// aux buffer allocation stuff
 static __aligned(8) uint8_t auxbuffer[AUX_BUFFER_SIZE];
 
-uint8_t *auxa_rover = auxbuffer;
-void AUXA_Reset() {
-	auxa_rover = auxbuffer;
-}
-
-uint8_t* AUXA_GetRover() {
-	return auxa_rover;
-}
-
-void AUXA_FreeToRover(uint8_t *rover) {
-	if (((uintptr_t)rover < (uintptr_t)auxbuffer) || ((uintptr_t)rover > (uintptr_t)&auxbuffer[AUX_BUFFER_SIZE])) {
-		Sys_Error("AUXA_FreeToRover(): attempt to reset rover outside of aux buffer memory (%08X != [%08X..%08X])\n",
-			(uintptr_t)rover, (uintptr_t)auxbuffer, (uintptr_t)&auxbuffer[AUX_BUFFER_SIZE]
-		);
-	}
-	auxa_rover = rover;
-}
-
-// enforces 8-bytes align
-void *AUXA_Alloc(int bytes) {
-	if ((uintptr_t)(auxa_rover + bytes + 7) >= (uintptr_t)&auxbuffer[AUX_BUFFER_SIZE]) {
-		Sys_Error("AUXA_Alloc(): tried to allocate %d bytes but ran out of aux buffer memory\n", bytes);
-		return NULL;
-	}
-	uint8_t *rtn = (uint8_t*)(((uintptr_t)auxa_rover + 7) & ~7);
-	auxa_rover   = (uint8_t*)(((uintptr_t)auxa_rover + bytes + 7) & ~7);
-	//Sys_Printf("AUXA_Alloc(): %d bytes -> 0x%08X", bytes, (uintptr_t)rtn);
-	return (void*)rtn;
-}
-
-// a pair of malloc/free-like functions for local allocations
-void *AUXA_MAlloc(int bytes) {
-	uint8_t *rover = AUXA_GetRover();
-	void *rtn = AUXA_Alloc(bytes + sizeof(uint8_t*));
-	*(uint8_t**)rtn = rover;
-	return (void*)((uintptr_t)rtn + sizeof(uint8_t*));
-}
-
-void AUXA_MFree(void *ptr) {
-	// extract rover
-	uint8_t *rover = *(uint8_t**)((uintptr_t)ptr - 4);
-	AUXA_FreeToRover(rover);
-}
-
-uint32_t AUXA_GetFreeBytes() {
-	return ((uintptr_t)&auxbuffer[AUX_BUFFER_SIZE] - (uintptr_t)auxa_rover);
-}
+static __psram_bss("vid_null") unsigned char	vid_curpalette[768];	// last palette handed to the backend
 
 void	VID_SetPalette (unsigned char *palette)
 {
+	memcpy (vid_curpalette, palette, sizeof(vid_curpalette));
+
 	// quake generic
 	QG_SetPalette(palette);
 }
 
 void	VID_ShiftPalette (unsigned char *palette)
 {
+	memcpy (vid_curpalette, palette, sizeof(vid_curpalette));
+
 	// quake generic
 	QG_SetPalette(palette);
 }
@@ -177,11 +102,9 @@ void	VID_Init (unsigned char *palette)
 	// quake generic
 	QG_Init();
 
-	// reset Z-buffer allocator
-	ZBA_Reset();
-
-	// reset aux allocator
-	AUXA_Reset();
+	Arena_Create (&zbuffer_arena, "zbuffer", zbuffer, BASEWIDTH*BASEHEIGHT*sizeof(short), ARENA_TOPDOWN);
+	Arena_SetShared (&zbuffer_arena, BASEWIDTH*sizeof(short));
+	Arena_Create (&aux_arena, "aux", auxbuffer, sizeof(auxbuffer), 0);
 }
 
 void	VID_Shutdown (void)
@@ -189,10 +112,66 @@ void	VID_Shutdown (void)
 	///	free(surfcache);
 }
 
+#define	MAX_UPDATERECTS	8
+
+/*
+================
+VID_Update
+
+Hands the changed regions SCR_UpdateScreen worked out to the backend, so it
+only has to copy or send those
+================
+*/
 void	VID_Update (vrect_t *rects)
 {
-	// quake generic
-	QG_DrawFrame(vid.buffer);
+	qg_rect_t	qrects[MAX_UPDATERECTS];
+	qg_rect_t	*r;
+	int			numrects;
+
+	if (cls.hashdemo)
+		CL_HashDemoFrame (vid.buffer, vid.rowbytes, vid_curpalette);
+
+	numrects = 0;
+	for ( ; rects ; rects = rects->pnext)
+	{
+		if (numrects == MAX_UPDATERECTS)
+		{	// too fragmented, just send everything
+			qrects[0].x = qrects[0].y = 0;
+			qrects[0].width = vid.width;
+			qrects[0].height = vid.height;
+			numrects = 1;
+			break;
+		}
+
+		r = &qrects[numrects];
+		r->x = rects->x < 0 ? 0 : rects->x;
+		r->y = rects->y < 0 ? 0 : rects->y;
+		r->width = rects->x + rects->width;
+		if (r->width > (int)vid.width)
+			r->width = vid.width;
+		r->width -= r->x;
+		r->height = rects->y + rects->height;
+		if (r->height > (int)vid.height)
+			r->height = vid.height;
+		r->height -= r->y;
+		if (r->width > 0 && r->height > 0)
+			numrects++;
+	}
+
+	// quake generic, the underwater warp is applied on the way out
+	if (numrects)
+		QG_DrawFrameRects (vid.buffer, qrects, numrects);
+}
+
+static void VID_PresentDirectRect (int x, int y, int width, int height)
+{
+	qg_rect_t	r;
+
+	r.x = x;
+	r.y = y;
+	r.width = width;
+	r.height = height;
+	QG_DrawFrameRects (NULL, &r, 1);
 }
 
 static __psram_bss("vid_null") byte	backingbuf[48*24];
@@ -235,6 +214,7 @@ void D_BeginDirectRect (int x, int y, byte *pbitmap, int width, int height)
 			}
 		}
 	VID_UnlockBuffer ();
+	VID_PresentDirectRect (x, y << repshift, width, height << repshift);
 }
 
 
@@ -273,6 +253,7 @@ void D_EndDirectRect (int x, int y, int width, int height)
 			}
 		}
 	VID_UnlockBuffer ();
+	VID_PresentDirectRect (x, y << repshift, width, height << repshift);
 }
 
 
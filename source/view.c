@@ -480,7 +480,6 @@ void V_UpdatePalette (void)
 	byte	*basepal, *newpal;
 	int		r,g,b;
 	qboolean force;
-	uint8_t	*zba_rover;
 
 	V_CalcPowerupCshift ();
 	
@@ -516,8 +515,8 @@ void V_UpdatePalette (void)
 		return;
 			
 	basepal = host_basepal;
-	zba_rover = ZBA_GetRover();
-	byte* pal = (byte*)ZBA_Alloc(768);
+	ARENA_SCOPE (zbuffer_arena);
+	byte* pal = (byte*)Arena_Alloc(&zbuffer_arena, 768);
 	newpal = pal;
 	
 	for (i=0 ; i<256 ; i++)
@@ -541,7 +540,6 @@ void V_UpdatePalette (void)
 	}
 
 	VID_ShiftPalette (pal);
-	ZBA_FreeToRover (zba_rover);
 }
 
 /* 
@@ -43,6 +43,13 @@ typedef struct
 
 
 int SV_HullPointContents (hull_t *hull, int num, vec3_t p);
+void SV_ClearHullCache (void);
+
+#define	AREA_STALE		1			// on the list, the links are wrong
+#define	AREA_RELINKED	2			// on the list, relinked since
+
+static	edict_t		*sv_stale[MAX_EDICTS];
+static	int			sv_numstale;
 
 /*
 ===============================================================================
@@ -54,8 +61,7 @@ HULL BOXES
 
 
 static	hull_t		box_hull;
-static	dclipnode_t	box_clipnodes[6];
-static	mplane_t	box_planes[6];
+static	mclipnode_t	box_clipnodes[6];
 
 /*
 ===================
@@ -71,14 +77,11 @@ void SV_InitBoxHull (void)
 	int		side;
 
 	box_hull.clipnodes = box_clipnodes;
-	box_hull.planes = box_planes;
 	box_hull.firstclipnode = 0;
 	box_hull.lastclipnode = 5;
 
 	for (i=0 ; i<6 ; i++)
 	{
-		box_clipnodes[i].planenum = i;
-		
 		side = i&1;
 		
 		box_clipnodes[i].children[side] = CONTENTS_EMPTY;
@@ -87,8 +90,8 @@ void SV_InitBoxHull (void)
 		else
 			box_clipnodes[i].children[side^1] = CONTENTS_SOLID;
 		
-		box_planes[i].type = i>>1;
-		box_planes[i].normal[i>>1] = 1;
+		box_clipnodes[i].type = i>>1;
+		box_clipnodes[i].normal[i>>1] = 1;
 	}
 	
 }
@@ -104,12 +107,12 @@ BSP trees instead of being compared directly.
 */
 hull_t	*SV_HullForBox (vec3_t mins, vec3_t maxs)
 {
-	box_planes[0].dist = maxs[0];
-	box_planes[1].dist = mins[0];
-	box_planes[2].dist = maxs[1];
-	box_planes[3].dist = mins[1];
-	box_planes[4].dist = maxs[2];
-	box_planes[5].dist = mins[2];
+	box_clipnodes[0].dist = maxs[0];
+	box_clipnodes[1].dist = mins[0];
+	box_clipnodes[2].dist = maxs[1];
+	box_clipnodes[3].dist = mins[1];
+	box_clipnodes[4].dist = maxs[2];
+	box_clipnodes[5].dist = mins[2];
 
 	return &box_hull;
 }
@@ -247,10 +250,13 @@ SV_ClearWorld
 void SV_ClearWorld (void)
 {
 	SV_InitBoxHull ();
+	SV_ClearHullCache ();
 	
 	memset (sv_areanodes, 0, sizeof(sv_areanodes));
 	sv_numareanodes = 0;
 	SV_CreateAreaNode (0, sv.worldmodel->mins, sv.worldmodel->maxs);
+
+	sv_numstale = 0;	// the edicts were just allocated
 }
 
 
@@ -382,6 +388,9 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 	if (ent->free)
 		return;
 
+	if (ent->areastale)
+		ent->areastale = AREA_RELINKED;	// the links are current again
+
 // set the abs box
 	VectorAdd (ent->v.origin, ent->v.mins, ent->v.absmin);	
 	VectorAdd (ent->v.origin, ent->v.maxs, ent->v.absmax);
@@ -444,6 +453,121 @@ void SV_LinkEdict (edict_t *ent, qboolean touch_triggers)
 
 
 
+/*
+===============================================================================
+
+STALE AREA LINKS
+
+An edict is linked into the area nodes by the box it had at its last
+SV_LinkEdict.  The progs can write origin, size or solid without calling
+setorigin, and physics runs touch functions before it relinks the edict it
+moves, so for a while the links can be wrong.  Those edicts are put on a
+list by SV_AreaStale, and SV_AreaEdicts returns them wherever they are until
+they are linked again.
+
+===============================================================================
+*/
+
+/*
+===============
+SV_AreaStale
+
+===============
+*/
+void SV_AreaStale (edict_t *ent)
+{
+	if (ent->areastale == AREA_STALE || ent == sv.edicts)
+		return;
+	if (!ent->areastale)
+		sv_stale[sv_numstale++] = ent;
+	ent->areastale = AREA_STALE;
+}
+
+/*
+====================
+SV_AreaEdicts_r
+
+====================
+*/
+static int SV_AreaEdicts_r (areanode_t *node, vec3_t mins, vec3_t maxs, edict_t **list, int count, int maxcount)
+{
+	link_t		*l, *start;
+	edict_t		*check;
+	int			i;
+
+	for (i=0 ; i<2 ; i++)
+	{
+		start = i ? &node->trigger_edicts : &node->solid_edicts;
+		for (l = start->next ; l != start ; l = l->next)
+		{
+			check = EDICT_FROM_AREA(l);
+			if (check->areastale == AREA_STALE)
+				continue;		// added from the stale list
+			if (mins[0] > check->v.absmax[0]
+			|| mins[1] > check->v.absmax[1]
+			|| mins[2] > check->v.absmax[2]
+			|| maxs[0] < check->v.absmin[0]
+			|| maxs[1] < check->v.absmin[1]
+			|| maxs[2] < check->v.absmin[2] )
+				continue;
+			if (count == maxcount)
+				return -1;
+			list[count++] = check;
+		}
+	}
+
+// recurse down both sides
+	if (node->axis == -1)
+		return count;
+
+	if ( maxs[node->axis] > node->dist )
+		count = SV_AreaEdicts_r (node->children[0], mins, maxs, list, count, maxcount);
+	if ( count >= 0 && mins[node->axis] < node->dist )
+		count = SV_AreaEdicts_r (node->children[1], mins, maxs, list, count, maxcount);
+
+	return count;
+}
+
+/*
+====================
+SV_AreaEdicts
+
+====================
+*/
+int SV_AreaEdicts (vec3_t mins, vec3_t maxs, edict_t **list, int maxcount)
+{
+	edict_t		*check;
+	int			i, count, numstale;
+
+	count = SV_AreaEdicts_r (sv_areanodes, mins, maxs, list, 0, maxcount);
+
+// a relinked, freed or non solid edict can come off the list, it can only
+// become solid again through another SV_AreaStale
+	numstale = 0;
+	for (i=0 ; i<sv_numstale ; i++)
+	{
+		check = sv_stale[i];
+		if (check->areastale != AREA_STALE || check->free || check->v.solid == SOLID_NOT)
+		{
+			check->areastale = 0;
+			continue;
+		}
+		sv_stale[numstale++] = check;
+
+		if (count < 0)
+			continue;
+		if (count == maxcount)
+			count = -1;
+		else
+			list[count++] = check;
+	}
+	sv_numstale = numstale;
+
+	return count;
+}
+
+
+
 /*
 ===============================================================================
 
@@ -461,8 +585,7 @@ SV_HullPointContents
 int SV_HullPointContents (hull_t *hull, int num, vec3_t p)
 {
 	float		d;
-	dclipnode_t	*node;
-	mplane_t	*plane;
+	mclipnode_t	*node;
 
 	while (num >= 0)
 	{
@@ -470,12 +593,11 @@ int SV_HullPointContents (hull_t *hull, int num, vec3_t p)
 			Sys_Error ("SV_HullPointContents: bad node number");
 	
 		node = hull->clipnodes + num;
-		plane = hull->planes + node->planenum;
 		
-		if (plane->type < 3)
-			d = p[plane->type] - plane->dist;
+		if (node->type < 3)
+			d = p[node->type] - node->dist;
 		else
-			d = DotProduct (plane->normal, p) - plane->dist;
+			d = DotProduct (node->normal, p) - node->dist;
 		if (d < 0)
 			num = node->children[1];
 		else
@@ -485,6 +607,90 @@ int SV_HullPointContents (hull_t *hull, int num, vec3_t p)
 	return num;
 }
 
+/*
+===============================================================================
+
+HULL QUERY CACHE
+
+Monsters keep asking the world the same questions (SV_CheckBottom probes the
+same corners and drops the same lines every frame they stand still), so the
+answers for bsp hulls are remembered in two small direct mapped tables.
+Bsp hulls never change while a level is running and traces are done in hull
+local space, so entries stay valid until SV_ClearWorld.  Box hulls are
+rebuilt for every entity and are never cached.
+
+===============================================================================
+*/
+
+#define	POINTCACHE_SIZE		32		// must be a power of two
+#define	TRACECACHE_SIZE		16		// must be a power of two
+
+typedef struct
+{
+	hull_t		*hull;
+	int			stamp;
+	vec3_t		p;
+	int			contents;
+} pointcache_t;
+
+typedef struct
+{
+	hull_t		*hull;
+	int			stamp;
+	vec3_t		start, end;
+	trace_t		trace;
+} tracecache_t;
+
+static	pointcache_t	sv_pointcache[POINTCACHE_SIZE];
+static	tracecache_t	sv_tracecache[TRACECACHE_SIZE];
+static	int				sv_hullcachestamp = 1;
+
+/*
+==================
+SV_ClearHullCache
+
+==================
+*/
+void SV_ClearHullCache (void)
+{
+	sv_hullcachestamp++;
+}
+
+static inline unsigned SV_HashPoint (vec3_t p)
+{
+	union { float f; unsigned u; }	x, y, z;
+
+	x.f = p[0];
+	y.f = p[1];
+	z.f = p[2];
+	return (x.u * 73856093) ^ (y.u * 19349663) ^ (z.u * 83492791);
+}
+
+/*
+==================
+SV_CachedPointContents
+
+Same as SV_HullPointContents from the head node of a bsp hull, but
+remembered for the rest of the level
+==================
+*/
+int SV_CachedPointContents (hull_t *hull, vec3_t p)
+{
+	pointcache_t	*pc;
+
+	pc = &sv_pointcache[(SV_HashPoint (p) ^ (unsigned)(uintptr_t)hull) & (POINTCACHE_SIZE-1)];
+	if (pc->hull == hull && pc->stamp == sv_hullcachestamp
+	&& pc->p[0] == p[0] && pc->p[1] == p[1] && pc->p[2] == p[2])
+		return pc->contents;
+
+	pc->contents = SV_HullPointContents (hull, hull->firstclipnode, p);
+	pc->hull = hull;
+	pc->stamp = sv_hullcachestamp;
+	VectorCopy (p, pc->p);
+
+	return pc->contents;
+}
+
 /*
 ==================
 SV_PointContents
@@ -495,7 +701,7 @@ int SV_PointContents (vec3_t p)
 {
 	int		cont;
 
-	cont = SV_HullPointContents (&sv.worldmodel->hulls[0], 0, p);
+	cont = SV_CachedPointContents (&sv.worldmodel->hulls[0], p);
 	if (cont <= CONTENTS_CURRENT_0 && cont >= CONTENTS_CURRENT_DOWN)
 		cont = CONTENTS_WATER;
 	return cont;
@@ -503,7 +709,7 @@ int SV_PointContents (vec3_t p)
 
 int SV_TruePointContents (vec3_t p)
 {
-	return SV_HullPointContents (&sv.worldmodel->hulls[0], 0, p);
+	return SV_CachedPointContents (&sv.worldmodel->hulls[0], p);
 }
 
 //===========================================================================
@@ -539,142 +745,225 @@ LINE TESTING IN HULLS
 // 1/32 epsilon to keep floating point happy
 #define	DIST_EPSILON	(0.03125)
 
+#define	MAX_HULLSTACK	64
+#define	HULLSTACK_CHUNK	16		// on the C stack, past MAX_HULLSTACK crossings
+
+// a node the line crosses, waiting for the near side to be traced
+typedef struct
+{
+	mclipnode_t	*node;
+	int			side;
+	float		frac;
+	float		p1f, p2f, midf;
+	vec3_t		p1, p2, mid;
+} hullstack_t;
+
+static	hullstack_t	hullstack[MAX_HULLSTACK];
+
+static qboolean SV_HullCheckDeeper (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace);
+
 /*
 ==================
-SV_RecursiveHullCheck
+SV_HullCheckStack
 
+The line is walked down to a leaf, every node it crosses is pushed on an
+explicit stack, and the far sides are visited by popping them back.  Gives
+the same results as the original recursion.  A line crossing more nodes
+than the stack holds traces the rest of that subtree with a new stack.
 ==================
 */
-qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
+static qboolean SV_HullCheckStack (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace, hullstack_t *stack, int stacksize)
 {
-	dclipnode_t	*node;
-	mplane_t	*plane;
+	mclipnode_t	*node;
+	hullstack_t	*top;
 	float		t1, t2;
 	float		frac;
 	int			i;
-	vec3_t		mid;
+	vec3_t		start, end;
 	int			side;
 	float		midf;
 
-// check for empty
-	if (num < 0)
+	top = stack;
+	VectorCopy (p1, start);
+	VectorCopy (p2, end);
+
+	while (1)
 	{
-		if (num != CONTENTS_SOLID)
+	//
+	// walk down to a leaf
+	//
+		while (num >= 0)
 		{
-			trace->allsolid = false;
-			if (num == CONTENTS_EMPTY)
-				trace->inopen = true;
+			if (num < hull->firstclipnode || num > hull->lastclipnode)
+				Sys_Error ("SV_RecursiveHullCheck: bad node number");
+
+		//
+		// find the point distances
+		//
+			node = hull->clipnodes + num;
+
+			if (node->type < 3)
+			{
+				t1 = start[node->type] - node->dist;
+				t2 = end[node->type] - node->dist;
+			}
 			else
-				trace->inwater = true;
-		}
-		else
-			trace->startsolid = true;
-		return true;		// empty
-	}
+			{
+				t1 = DotProduct (node->normal, start) - node->dist;
+				t2 = DotProduct (node->normal, end) - node->dist;
+			}
 
-	if (num < hull->firstclipnode || num > hull->lastclipnode)
-		Sys_Error ("SV_RecursiveHullCheck: bad node number");
+			if (t1 >= 0 && t2 >= 0)
+			{
+				num = node->children[0];
+				continue;
+			}
+			if (t1 < 0 && t2 < 0)
+			{
+				num = node->children[1];
+				continue;
+			}
 
-//
-// find the point distances
-//
-	node = hull->clipnodes + num;
-	plane = hull->planes + node->planenum;
+		// put the crosspoint DIST_EPSILON pixels on the near side
+			if (t1 < 0)
+				frac = (t1 + DIST_EPSILON)/(t1-t2);
+			else
+				frac = (t1 - DIST_EPSILON)/(t1-t2);
+			if (frac < 0)
+				frac = 0;
+			if (frac > 1)
+				frac = 1;
 
-	if (plane->type < 3)
-	{
-		t1 = p1[plane->type] - plane->dist;
-		t2 = p2[plane->type] - plane->dist;
-	}
-	else
-	{
-		t1 = DotProduct (plane->normal, p1) - plane->dist;
-		t2 = DotProduct (plane->normal, p2) - plane->dist;
-	}
-	
-#if 1
-	if (t1 >= 0 && t2 >= 0)
-		return SV_RecursiveHullCheck (hull, node->children[0], p1f, p2f, p1, p2, trace);
-	if (t1 < 0 && t2 < 0)
-		return SV_RecursiveHullCheck (hull, node->children[1], p1f, p2f, p1, p2, trace);
-#else
-	if ( (t1 >= DIST_EPSILON && t2 >= DIST_EPSILON) || (t2 > t1 && t1 >= 0) )
-		return SV_RecursiveHullCheck (hull, node->children[0], p1f, p2f, p1, p2, trace);
-	if ( (t1 <= -DIST_EPSILON && t2 <= -DIST_EPSILON) || (t2 < t1 && t1 <= 0) )
-		return SV_RecursiveHullCheck (hull, node->children[1], p1f, p2f, p1, p2, trace);
-#endif
+			if (top == stack + stacksize)
+			{
+				if (!SV_HullCheckDeeper (hull, num, p1f, p2f, start, end, trace))
+					return false;
+				break;		// the whole subtree is done
+			}
 
-// put the crosspoint DIST_EPSILON pixels on the near side
-	if (t1 < 0)
-		frac = (t1 + DIST_EPSILON)/(t1-t2);
-	else
-		frac = (t1 - DIST_EPSILON)/(t1-t2);
-	if (frac < 0)
-		frac = 0;
-	if (frac > 1)
-		frac = 1;
-		
-	midf = p1f + (p2f - p1f)*frac;
-	for (i=0 ; i<3 ; i++)
-		mid[i] = p1[i] + frac*(p2[i] - p1[i]);
+			side = (t1 < 0);
+
+			top->node = node;
+			top->side = side;
+			top->frac = frac;
+			top->p1f = p1f;
+			top->p2f = p2f;
+			top->midf = p1f + (p2f - p1f)*frac;
+			for (i=0 ; i<3 ; i++)
+				top->mid[i] = start[i] + frac*(end[i] - start[i]);
+			VectorCopy (start, top->p1);
+			VectorCopy (end, top->p2);
+
+		// move up to the node
+			p2f = top->midf;
+			VectorCopy (top->mid, end);
+			num = node->children[side];
+			top++;
+		}
 
-	side = (t1 < 0);
+	//
+	// check for empty
+	//
+		if (num < 0)
+		{
+			if (num != CONTENTS_SOLID)
+			{
+				trace->allsolid = false;
+				if (num == CONTENTS_EMPTY)
+					trace->inopen = true;
+				else
+					trace->inwater = true;
+			}
+			else
+				trace->startsolid = true;
+		}
 
-// move up to the node
-	if (!SV_RecursiveHullCheck (hull, node->children[side], p1f, midf, p1, mid, trace) )
-		return false;
+		if (top == stack)
+			return true;		// empty
 
-#ifdef PARANOID
-	if (SV_HullPointContents (sv_hullmodel, mid, node->children[side])
-	== CONTENTS_SOLID)
-	{
-		Con_Printf ("mid PointInHullSolid\n");
-		return false;
-	}
-#endif
-	
-	if (SV_HullPointContents (hull, node->children[side^1], mid)
-	!= CONTENTS_SOLID)
-// go past the node
-		return SV_RecursiveHullCheck (hull, node->children[side^1], midf, p2f, mid, p2, trace);
-	
-	if (trace->allsolid)
-		return false;		// never got out of the solid area
-		
-//==================
-// the other side of the node is solid, this is the impact point
-//==================
-	if (!side)
-	{
-		VectorCopy (plane->normal, trace->plane.normal);
-		trace->plane.dist = plane->dist;
-	}
-	else
-	{
-		VectorSubtract (vec3_origin, plane->normal, trace->plane.normal);
-		trace->plane.dist = -plane->dist;
-	}
+	//
+	// the near side of the innermost crossed node is done
+	//
+		top--;
+		node = top->node;
+		side = top->side;
+
+		if (SV_HullPointContents (hull, node->children[side^1], top->mid)
+		!= CONTENTS_SOLID)
+		{
+		// go past the node
+			num = node->children[side^1];
+			p1f = top->midf;
+			p2f = top->p2f;
+			VectorCopy (top->mid, start);
+			VectorCopy (top->p2, end);
+			continue;
+		}
+
+		if (trace->allsolid)
+			return false;		// never got out of the solid area
 
-	while (SV_HullPointContents (hull, hull->firstclipnode, mid)
-	== CONTENTS_SOLID)
-	{ // shouldn't really happen, but does occasionally
-		frac -= 0.1;
-		if (frac < 0)
+	//==================
+	// the other side of the node is solid, this is the impact point
+	//==================
+		if (!side)
 		{
-			trace->fraction = midf;
-			VectorCopy (mid, trace->endpos);
-			Con_DPrintf ("backup past 0\n");
-			return false;
+			VectorCopy (node->normal, trace->plane.normal);
+			trace->plane.dist = node->dist;
 		}
-		midf = p1f + (p2f - p1f)*frac;
-		for (i=0 ; i<3 ; i++)
-			mid[i] = p1[i] + frac*(p2[i] - p1[i]);
+		else
+		{
+			VectorSubtract (vec3_origin, node->normal, trace->plane.normal);
+			trace->plane.dist = -node->dist;
+		}
+
+		frac = top->frac;
+		midf = top->midf;
+		while (SV_HullPointContents (hull, hull->firstclipnode, top->mid)
+		== CONTENTS_SOLID)
+		{ // shouldn't really happen, but does occasionally
+			frac -= 0.1;
+			if (frac < 0)
+			{
+				trace->fraction = midf;
+				VectorCopy (top->mid, trace->endpos);
+				Con_DPrintf ("backup past 0\n");
+				return false;
+			}
+			midf = top->p1f + (top->p2f - top->p1f)*frac;
+			for (i=0 ; i<3 ; i++)
+				top->mid[i] = top->p1[i] + frac*(top->p2[i] - top->p1[i]);
+		}
+
+		trace->fraction = midf;
+		VectorCopy (top->mid, trace->endpos);
+
+		return false;
 	}
+}
 
-	trace->fraction = midf;
-	VectorCopy (mid, trace->endpos);
+/*
+==================
+SV_HullCheckDeeper
+
+==================
+*/
+static qboolean SV_HullCheckDeeper (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
+{
+	hullstack_t	stack[HULLSTACK_CHUNK];
 
-	return false;
+	return SV_HullCheckStack (hull, num, p1f, p2f, p1, p2, trace, stack, HULLSTACK_CHUNK);
+}
+
+/*
+==================
+SV_RecursiveHullCheck
+
+==================
+*/
+qboolean SV_RecursiveHullCheck (hull_t *hull, int num, float p1f, float p2f, vec3_t p1, vec3_t p2, trace_t *trace)
+{
+	return SV_HullCheckStack (hull, num, p1f, p2f, p1, p2, trace, hullstack, MAX_HULLSTACK);
 }
 
 
@@ -692,12 +981,7 @@ trace_t SV_ClipMoveToEntity (edict_t *ent, vec3_t start, vec3_t mins, vec3_t max
 	vec3_t		offset;
 	vec3_t		start_l, end_l;
 	hull_t		*hull;
-
-// fill in a default trace
-	memset (&trace, 0, sizeof(trace_t));
-	trace.fraction = 1;
-	trace.allsolid = true;
-	VectorCopy (end, trace.endpos);
+	tracecache_t	*tc;
 
 // get the clipping hull
 	hull = SV_HullForEntity (ent, mins, maxs, offset);
@@ -705,12 +989,48 @@ trace_t SV_ClipMoveToEntity (edict_t *ent, vec3_t start, vec3_t mins, vec3_t max
 	VectorSubtract (start, offset, start_l);
 	VectorSubtract (end, offset, end_l);
 
+// see if the same line was traced through this bsp hull already
+	tc = NULL;
+	if (hull != &box_hull)
+	{
+		tc = &sv_tracecache[(SV_HashPoint (start_l) ^ (SV_HashPoint (end_l) * 31)
+			^ (unsigned)(uintptr_t)hull) & (TRACECACHE_SIZE-1)];
+		if (tc->hull == hull && tc->stamp == sv_hullcachestamp
+		&& VectorCompare (tc->start, start_l) && VectorCompare (tc->end, end_l))
+		{
+			trace = tc->trace;
+			goto fixup;
+		}
+	}
+
+// fill in a default trace
+	memset (&trace, 0, sizeof(trace_t));
+	trace.fraction = 1;
+	trace.allsolid = true;
+	VectorCopy (end_l, trace.endpos);
+
 // trace a line through the apropriate clipping hull
 	SV_RecursiveHullCheck (hull, hull->firstclipnode, 0, 1, start_l, end_l, &trace);
 
+	if (tc)
+	{
+		tc->hull = hull;
+		tc->stamp = sv_hullcachestamp;
+		VectorCopy (start_l, tc->start);
+		VectorCopy (end_l, tc->end);
+		tc->trace = trace;
+	}
+
+fixup:
 // fix trace up by the offset
 	if (trace.fraction != 1)
+	{
 		VectorAdd (trace.endpos, offset, trace.endpos);
+	}
+	else
+	{
+		VectorCopy (end, trace.endpos);
+	}
 
 // did we clip the move?
 	if (trace.fraction < 1 || trace.startsolid  )
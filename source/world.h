@@ -64,6 +64,15 @@ int SV_TruePointContents (vec3_t p);
 
 edict_t	*SV_TestEntityPosition (edict_t *ent);
 
+void SV_AreaStale (edict_t *ent);
+// call when the origin, size or solid of an edict changed and it is not
+// relinked right away
+
+int SV_AreaEdicts (vec3_t mins, vec3_t maxs, edict_t **list, int maxcount);
+// fills in a list of the linked edicts whose absolute boxes touch mins/maxs,
+// and of the solid edicts that changed since they were linked
+// returns -1 if there were more than maxcount of them
+
 trace_t SV_Move (vec3_t start, vec3_t mins, vec3_t maxs, vec3_t end, int type, edict_t *passedict);
 // mins and maxs are reletive
 
@@ -239,6 +239,30 @@ void Z_Print (memzone_t *zone)
 }
 
 
+/*
+========================
+Z_Stats
+
+Size of the zone, the free bytes in it and the largest block they are in
+========================
+*/
+void Z_Stats (int *size, int *free, int *largest)
+{
+	memblock_t	*block;
+
+	*size = mainzone->size;
+	*free = *largest = 0;
+	for (block = mainzone->blocklist.next ; block != &mainzone->blocklist ; block = block->next)
+	{
+		if (block->tag)
+			continue;
+		*free += block->size;
+		if (block->size > *largest)
+			*largest = block->size;
+	}
+}
+
+
 /*
 ========================
 Z_CheckHeap
@@ -451,6 +475,20 @@ void Hunk_FreeToLowMark (int mark)
 	hunk_low_used = mark;
 }
 
+/*
+===================
+Hunk_Stats
+
+Like the marks, without freeing the temp allocation
+===================
+*/
+void Hunk_Stats (int *size, int *low, int *high)
+{
+	*size = hunk_size;
+	*low = hunk_low_used;
+	*high = hunk_high_used;
+}
+
 int	Hunk_HighMark (void)
 {
 	if (hunk_tempactive)
@@ -574,6 +612,8 @@ cache_system_t *Cache_TryAlloc (int size, qboolean nobottom);
 
 cache_system_t	cache_head;
 
+int		cache_evictions;	// blocks thrown out to make room, for memstat
+
 /*
 ===========
 Cache_Move
@@ -600,6 +640,7 @@ void Cache_Move ( cache_system_t *c)
 //		Con_Printf ("cache_move failed\n");
 
 		Cache_Free (c->user);		// tough luck...
+		cache_evictions++;
 	}
 }
 
@@ -656,7 +697,10 @@ void Cache_FreeHigh (int new_high_hunk)
 			return;		// there is space to grow the hunk
 		}
 		if (c == prev)
+		{
 			Cache_Free (c->user);	// didn't move out of the way
+			cache_evictions++;
+		}
 		else
 		{
 			Cache_Move (c);	// try to move it
@@ -811,6 +855,25 @@ void Cache_Report (void)
 	Con_DPrintf ("%4.1f megabyte data cache\n", (hunk_size - hunk_high_used - hunk_low_used) / (float)(1024*1024) );
 }
 
+/*
+============
+Cache_Stats
+
+Bytes and blocks in the cache, headers included
+============
+*/
+void Cache_Stats (int *bytes, int *blocks)
+{
+	cache_system_t	*cs;
+
+	*bytes = *blocks = 0;
+	for (cs = cache_head.next ; cs != &cache_head ; cs = cs->next)
+	{
+		*bytes += cs->size;
+		(*blocks)++;
+	}
+}
+
 /*
 ============
 Cache_Compact
@@ -922,6 +985,7 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name)
 		mutex_enter_blocking(&snd_mutex);
 		Cache_Free ( cache_head.lru_prev->user );
 		mutex_exit(&snd_mutex);
+		cache_evictions++;
 	} 
 	
 	return Cache_Check (c);
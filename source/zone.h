@@ -92,6 +92,7 @@ void *Z_TagMalloc (int size, int tag);
 void Z_DumpHeap (void);
 void Z_CheckHeap (void);
 int Z_FreeMemory (void);
+void Z_Stats (int *size, int *free, int *largest);
 
 void *Hunk_Alloc (int size);		// returns 0 filled memory
 void *Hunk_AllocName (int size, char *name);
@@ -106,6 +107,8 @@ void Hunk_FreeToHighMark (int mark);
 
 void *Hunk_TempAlloc (int size);
 
+void Hunk_Stats (int *size, int *low, int *high);
+
 void Hunk_Check (void);
 
 typedef struct cache_user_s
@@ -127,5 +130,8 @@ void *Cache_Alloc (cache_user_t *c, int size, char *name);
 
 void Cache_Report (void);
 
+void Cache_Stats (int *bytes, int *blocks);
+extern int cache_evictions;
+
 
 
@@ -0,0 +1,274 @@
+#!/usr/bin/env python3
+#
+# placement.py -- SRAM / flash / PSRAM placement from pcprof profiles
+#
+#   placement.py --map <firmware>.elf.map [--host-binary <exe>] <profile.pcp>...
+#                [--out placement] [--code-budget N] [--data-budget N]
+#                [--min-share PERCENT] [--cold-min N] [--keep REGEX]...
+#
+# Reads the input sections of the firmware from the linker map, charges the
+# samples of every profile to them, and writes the fragments the linker
+# scripts INCLUDE (memmap.ld):
+#
+#   placement_ram.ld    flash .text.* sections hot enough to run from SRAM
+#   placement_flash.ld  .time_critical.* sections that never showed up
+#   placement_data.ld   .psram_data.* groups hot enough for SRAM
+#   placement_bss.ld    .psram_bss.* groups hot enough for SRAM
+#   placement_psram.ld  SRAM .bss.* sections that were never pointed at
+#
+# Device profiles are matched by address. Host profiles (pcprof built with
+# -Dpcprof=true) carry host addresses, so --host-binary is needed to turn
+# them into function names, which are matched to .text.<name> and
+# .time_critical.<name>; they only weigh code. Several profiles can be
+# given, their weights are normalised and summed, so code that is hot in
+# any of the demos stays in SRAM.
+#
+# Only sections of the engine's own objects move. Core 1 is never sampled,
+# the code it runs is kept where it is by the --keep list, as is anything
+# in the objects that talk to hardware or run before PSRAM is up.
+
+import os
+import re
+import subprocess
+import sys
+from bisect import bisect_right
+
+ENGINE_OBJ = re.compile(r'/source/[^/]+\.(c|cpp)\.o(bj)?$')
+FIXED_OBJ = re.compile(r'/source/(main|mixer|hid_app|snd_pico|sys_pico|vid_null|'
+                       r'psram_alloc|xipstream|test_pins|tprintf|pcprof)\.(c|cpp)\.o(bj)?$')
+# runs on core 1, or from its interrupts
+KEEP = [r'^R_ParticleWorker$', r'^R_SimulateParticles$', r'^S_', r'^SNDDMA_']
+
+SECTION_RE = re.compile(r'^ (\.[^\s*]+)(?:\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*))?$')
+CONT_RE = re.compile(r'^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$')
+
+
+class Section:
+    def __init__(self, name, addr, size, obj):
+        self.name = name
+        self.addr = addr
+        self.size = size
+        self.obj = obj.strip()
+        self.code = 0.0
+        self.data = 0.0
+
+    def movable(self):
+        return ENGINE_OBJ.search(self.obj) and not FIXED_OBJ.search(self.obj)
+
+    def symbol(self):
+        return self.name.split('.', 2)[-1]
+
+
+def read_map(path):
+    sections = []
+    pending = None
+    started = False
+    with open(path, errors='replace') as f:
+        for line in f:
+            line = line.rstrip('\n')
+            if not started:
+                started = line.startswith('Linker script and memory map')
+                continue
+            if pending:
+                m = CONT_RE.match(line)
+                if m:
+                    sections.append(Section(pending, int(m.group(1), 16), int(m.group(2), 16), m.group(3)))
+                pending = None
+                continue
+            m = SECTION_RE.match(line)
+            if not m:
+                continue
+            if m.group(2) is None:
+                pending = m.group(1)
+            else:
+                sections.append(Section(m.group(1), int(m.group(2), 16), int(m.group(3), 16), m.group(4)))
+    sections = [s for s in sections if s.size and s.addr]
+    sections.sort(key=lambda s: s.addr)
+    return sections
+
+
+def read_profile(path):
+    head, anchor, code, data = None, None, {}, {}
+    with open(path) as f:
+        for line in f:
+            w = line.split()
+            if not w:
+                continue
+            if w[0] == 'pcprof':
+                head = w[2]
+            elif w[0] == 'anchor':
+                anchor = (w[1], int(w[2], 16))
+            elif w[0] in ('code', 'data'):
+                d = code if w[0] == 'code' else data
+                a = int(w[1], 16)
+                d[a] = d.get(a, 0) + int(w[2])
+    if head is None:
+        raise SystemExit('%s: not a pcprof file' % path)
+    return head, anchor, code, data
+
+
+def host_symbols(binary, anchor):
+    """sorted (address, name) of the host functions, rebased to the run"""
+    out = subprocess.run([os.environ.get('NM', 'nm'), '--defined-only', binary],
+                         capture_output=True, text=True, check=True).stdout
+    syms = []
+    for line in out.splitlines():
+        w = line.split()
+        if len(w) == 3 and w[1] in 'tT':
+            syms.append((int(w[0], 16), w[2]))
+    syms.sort()
+    base = [a for a, n in syms if n == anchor[0]]
+    if not base:
+        raise SystemExit('%s: no %s' % (binary, anchor[0]))
+    delta = anchor[1] - base[0]
+    return [(a + delta, n) for a, n in syms]
+
+
+def lookup(table, keys, addr):
+    i = bisect_right(keys, addr) - 1
+    return table[i] if i >= 0 else None
+
+
+def charge(sections, profiles, host_binary):
+    keys = [s.addr for s in sections]
+    bysymbol = {}
+    for s in sections:
+        if s.name.startswith(('.text.', '.time_critical.')):
+            bysymbol.setdefault(s.symbol(), s)
+
+    for path in profiles:
+        kind, anchor, code, data = read_profile(path)
+        total = float(sum(code.values())) or 1.0
+        if kind == 'host':
+            if not host_binary:
+                raise SystemExit('%s is a host profile, give --host-binary' % path)
+            syms = host_symbols(host_binary, anchor)
+            symkeys = [a for a, n in syms]
+            for addr, w in code.items():
+                sym = lookup(syms, symkeys, addr)
+                s = bysymbol.get(sym[1]) if sym else None
+                if s:
+                    s.code += w / total
+            continue
+
+        for addr, w in code.items():
+            s = lookup(sections, keys, addr & ~1)
+            if s and addr < s.addr + s.size:
+                s.code += w / total
+        dtotal = float(sum(data.values())) or 1.0
+        for addr, w in data.items():
+            s = lookup(sections, keys, addr)
+            if s and addr < s.addr + s.size:
+                s.data += w / dtotal
+
+
+def in_flash(s):
+    return 0x10000000 <= s.addr < 0x11000000
+
+
+def in_sram(s):
+    return 0x20000000 <= s.addr < 0x20082000
+
+
+def plan(sections, code_budget, data_budget, min_share, cold_min, keep):
+    kept = lambda s: any(k.search(s.symbol()) for k in keep)
+
+    ram, left = [], code_budget
+    for s in sorted((s for s in sections if s.name.startswith('.text.') and in_flash(s)
+                     and s.movable() and s.code >= min_share), key=lambda s: -s.code / s.size):
+        if s.size <= left:
+            ram.append(s)
+            left -= s.size
+
+    flash = [s for s in sections if s.name.startswith('.time_critical.') and in_sram(s)
+             and s.movable() and not s.code and not kept(s)]
+
+    data, bss, left = [], [], data_budget
+    groups = {}
+    for s in sections:
+        if s.name.startswith(('.psram_data.', '.psram_bss.')) and s.movable():
+            g = groups.setdefault(s.name, [0, 0.0])
+            g[0] += s.size
+            g[1] += s.data
+    for name, (size, hits) in sorted(groups.items(), key=lambda g: -g[1][1] / g[1][0]):
+        if hits > 0 and size <= left:
+            (data if name.startswith('.psram_data.') else bss).append(name)
+            left -= size
+
+    psram = [s for s in sections if s.name.startswith('.bss.') and in_sram(s)
+             and s.movable() and not s.data and s.size >= cold_min and not kept(s)]
+    return ram, flash, data, bss, psram
+
+
+def write_fragment(outdir, name, what, patterns, profiles):
+    with open(os.path.join(outdir, name), 'w') as f:
+        f.write('/* %s, written by tools/placement.py from %s */\n'
+                % (what, ' '.join(os.path.basename(p) for p in profiles)))
+        for p in sorted(set(patterns)):
+            f.write('*(%s)\n' % p)
+
+
+def main(argv):
+    mapfile, host_binary, outdir = None, None, 'placement'
+    code_budget, data_budget, min_share, cold_min = 32768, 32768, 0.1, 1024
+    keep = [re.compile(k) for k in KEEP]
+    profiles = []
+    i = 1
+    while i < len(argv):
+        a = argv[i]
+        if a in ('--map', '--host-binary', '--out', '--code-budget', '--data-budget',
+                 '--min-share', '--cold-min', '--keep') and i + 1 < len(argv):
+            v = argv[i + 1]
+            if a == '--map':
+                mapfile = v
+            elif a == '--host-binary':
+                host_binary = v
+            elif a == '--out':
+                outdir = v
+            elif a == '--code-budget':
+                code_budget = int(v)
+            elif a == '--data-budget':
+                data_budget = int(v)
+            elif a == '--min-share':
+                min_share = float(v)
+            elif a == '--cold-min':
+                cold_min = int(v)
+            else:
+                keep.append(re.compile(v))
+            i += 2
+        else:
+            profiles.append(a)
+            i += 1
+    if not mapfile or not profiles:
+        sys.stderr.write('usage: placement.py --map <firmware>.elf.map [--host-binary <exe>] '
+                         '<profile.pcp>... [--out dir] [--code-budget N] [--data-budget N] '
+                         '[--min-share PERCENT] [--cold-min N] [--keep REGEX]...\n')
+        return 1
+
+    sections = read_map(mapfile)
+    charge(sections, profiles, host_binary)
+    ram, flash, data, bss, psram = plan(sections, code_budget, data_budget,
+                                        min_share / 100 * len(profiles), cold_min, keep)
+
+    os.makedirs(outdir, exist_ok=True)
+    write_fragment(outdir, 'placement_ram.ld', 'hot code to SRAM', [s.name for s in ram], profiles)
+    write_fragment(outdir, 'placement_flash.ld', 'cold time critical code to flash',
+                   [s.name for s in flash], profiles)
+    write_fragment(outdir, 'placement_data.ld', 'hot PSRAM data to SRAM', data, profiles)
+    write_fragment(outdir, 'placement_bss.ld', 'hot PSRAM bss to SRAM', bss, profiles)
+    write_fragment(outdir, 'placement_psram.ld', 'cold SRAM bss to PSRAM',
+                   [s.name for s in psram], profiles)
+
+    print('to SRAM:  %3d functions %7d bytes' % (len(ram), sum(s.size for s in ram)))
+    for s in sorted(ram, key=lambda s: -s.code)[:20]:
+        print('    %5.1f%%  %6d  %s' % (s.code * 100 / len(profiles), s.size, s.symbol()))
+    print('to flash: %3d functions %7d bytes' % (len(flash), sum(s.size for s in flash)))
+    print('to SRAM:  %3d PSRAM groups' % (len(data) + len(bss)))
+    for name in data + bss:
+        print('    ' + name)
+    print('to PSRAM: %3d bss sections %7d bytes' % (len(psram), sum(s.size for s in psram)))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))
@@ -0,0 +1,179 @@
+#!/usr/bin/env python3
+#
+# stackbudget.py -- worst case stack depth of the stackcall_* entry points
+#
+# Reads the call graph files gcc writes with -fcallgraph-info=su (.ci, one
+# per object, frame sizes included) from the build tree, finds every
+# stackcall_alloc / stackcall_alloc_ex / stackcall_alloc_zba call in the
+# sources and prints, for each, the deepest path below the entry point
+# next to the size the call site asks for.
+#
+#   stackbudget.py <build dir> <source dir> [--margin N] [--depth FUNC=N]...
+#
+# Frames of functions gcc could not see (libgcc, newlib, the SDK when it is
+# built without the flag) count as 0 and are listed. Calls through function
+# pointers are listed but not followed, as is recursion past --depth (one
+# level by default). Interrupts run on the current MSP and so on these
+# stacks too; --margin (default 1024) is added to the suggested size for
+# them.
+
+import os
+import re
+import sys
+
+NODE_RE = re.compile(r'node:\s*\{\s*title:\s*"([^"]*)"\s*label:\s*"([^"]*)"')
+EDGE_RE = re.compile(r'edge:\s*\{\s*sourcename:\s*"([^"]*)"\s*targetname:\s*"([^"]*)"')
+SIZE_RE = re.compile(r'(\d+) bytes \(([a-z,]+)\)')
+SITE_RE = re.compile(r'\bstackcall_alloc(_ex|_zba)?\s*\(\s*(\w+)\s*,\s*(\d+)')
+
+INDIRECT = '__indirect_call'
+
+
+class Graph:
+    def __init__(self):
+        self.frame = {}         # title -> bytes
+        self.dynamic = set()    # titles with a dynamic frame
+        self.calls = {}         # title -> set of titles
+        self.byname = {}        # plain name -> title of the definition
+
+    def load(self, path):
+        with open(path, errors='replace') as f:
+            text = f.read()
+        for title, label in NODE_RE.findall(text):
+            m = SIZE_RE.search(label)
+            if not m:
+                continue        # declaration only
+            self.frame[title] = int(m.group(1))
+            if 'dynamic' in m.group(2):
+                self.dynamic.add(title)
+            name = label.split('\\n')[0]
+            self.byname.setdefault(name, title)
+        for src, dst in EDGE_RE.findall(text):
+            self.calls.setdefault(src, set()).add(dst)
+
+    def resolve(self, title):
+        if title in self.frame:
+            return title
+        return self.byname.get(title, title)
+
+
+class Budget:
+    def __init__(self, graph, depths):
+        self.graph = graph
+        self.depths = depths
+        self.memo = {}
+        self.external = set()
+        self.indirect = set()
+        self.recursive = set()
+        self.dynamic = set()
+
+    def worst(self, title, stack):
+        """deepest usage below and including title, and the path to it"""
+        g = self.graph
+        title = g.resolve(title)
+        if title in self.memo:
+            return self.memo[title]
+        if title not in g.frame:
+            self.external.add(title)
+            return 0, [title]
+        if title in g.dynamic:
+            self.dynamic.add(title)
+
+        stack.append(title)
+        best, bestpath = 0, []
+        for callee in sorted(g.calls.get(title, ())):
+            if callee == INDIRECT:
+                self.indirect.add(title)
+                continue
+            callee = g.resolve(callee)
+            if callee in stack:
+                self.recursive.add(callee)
+                continue
+            depth, path = self.worst(callee, stack)
+            if depth > best:
+                best, bestpath = depth, path
+        stack.pop()
+
+        frame = g.frame[title]
+        name = title.split(':')[-1]
+        levels = self.depths.get(name, 1) if title in self.recursive else 1
+        result = (frame * levels + best, [title] + bestpath)
+        # a result that cut a cycle short depends on the path taken to it
+        if not any(t in self.recursive for t in stack):
+            self.memo[title] = result
+        return result
+
+
+def find_sites(srcdir):
+    sites = []
+    for name in sorted(os.listdir(srcdir)):
+        if not name.endswith(('.c', '.cpp')) or name == 'psram_alloc.c':
+            continue
+        with open(os.path.join(srcdir, name), errors='replace') as f:
+            for lineno, line in enumerate(f, 1):
+                code = line.split('//')[0]
+                for kind, proc, size in SITE_RE.findall(code):
+                    sites.append(('%s:%d' % (name, lineno), kind or '', proc, int(size)))
+    return sites
+
+
+def round_up(n, to):
+    return (n + to - 1) // to * to
+
+
+def main(argv):
+    args, margin, depths = [], 1024, {}
+    i = 1
+    while i < len(argv):
+        if argv[i] == '--margin':
+            margin = int(argv[i + 1])
+            i += 2
+        elif argv[i] == '--depth':
+            name, n = argv[i + 1].split('=')
+            depths[name] = int(n)
+            i += 2
+        else:
+            args.append(argv[i])
+            i += 1
+    if len(args) != 2:
+        sys.stderr.write('usage: stackbudget.py <build dir> <source dir> '
+                         '[--margin N] [--depth FUNC=N]...\n')
+        return 1
+    builddir, srcdir = args
+
+    graph = Graph()
+    count = 0
+    for root, dirs, files in os.walk(builddir):
+        for name in files:
+            if name.endswith('.ci'):
+                graph.load(os.path.join(root, name))
+                count += 1
+    if not count:
+        sys.stderr.write('no .ci files under %s, configure with -DSTACK_BUDGET=ON\n' % builddir)
+        return 1
+
+    budget = Budget(graph, depths)
+    print('%-28s %-16s %7s %7s %7s %7s' % ('entry', 'site', 'given', 'worst', 'suggest', 'spare'))
+    total = 0
+    for site, kind, proc, given in find_sites(srcdir):
+        depth, path = budget.worst(proc, [])
+        suggest = round_up(depth + margin, 256)
+        total += given - suggest
+        entry = proc + (' (zba)' if kind == '_zba' else '')
+        print('%-28s %-16s %7d %7d %7d %7d' % (entry, site, given, depth, suggest, given - suggest))
+        print('    ' + ' > '.join(t.split(':')[-1] for t in path))
+    print('\n%d bytes over the suggested sizes in total, margin %d' % (total, margin))
+
+    def listing(title, names):
+        if names:
+            print('\n%s:\n    %s' % (title, ' '.join(sorted(n.split(':')[-1] for n in names))))
+
+    listing('recursive, counted --depth times (default 1)', budget.recursive)
+    listing('calls through pointers, not followed', budget.indirect)
+    listing('dynamic frames (alloca / VLA)', budget.dynamic)
+    listing('no call graph, counted as 0', budget.external)
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main(sys.argv))